@@ -48,6 +48,9 @@ set(VALKEY_SERVER_SRCS
     ${CMAKE_SOURCE_DIR}/src/crc16.c
     ${CMAKE_SOURCE_DIR}/src/endianconv.c
     ${CMAKE_SOURCE_DIR}/src/commandlog.c
+    ${CMAKE_SOURCE_DIR}/src/hotkeys.c
+    ${CMAKE_SOURCE_DIR}/src/commandphase.c
+    ${CMAKE_SOURCE_DIR}/src/keysizes.c
     ${CMAKE_SOURCE_DIR}/src/eval.c
     ${CMAKE_SOURCE_DIR}/src/bio.c
     ${CMAKE_SOURCE_DIR}/src/rio.c
@@ -295,8 +295,9 @@ static void *ACLListDupSds(void *item) {
 /* Structure used for handling key patterns with different key
  * based permissions. */
 typedef struct {
-    int flags;   /* The ACL key permission types for this key pattern */
-    sds pattern; /* The pattern to match keys against */
+    int flags;             /* The ACL key permission types for this key pattern */
+    sds pattern;           /* The pattern to match keys against */
+    stringMatcher matcher; /* The pattern compiled for matching */
 } keyPattern;
 
 /* Create a new key pattern. */
@@ -304,6 +305,7 @@ static keyPattern *ACLKeyPatternCreate(sds pattern, int flags) {
     keyPattern *new = (keyPattern *)zmalloc(sizeof(keyPattern));
     new->pattern = pattern;
     new->flags = flags;
+    stringMatcherInit(&new->matcher, pattern, sdslen(pattern), 0);
     return new;
 }
 
@@ -1550,8 +1552,7 @@ static int ACLSelectorCheckKey(aclSelector *selector, const char *key, int keyle
     while ((ln = listNext(&li))) {
         keyPattern *pattern = listNodeValue(ln);
         if ((pattern->flags & key_flags) != key_flags) continue;
-        size_t plen = sdslen(pattern->pattern);
-        if (stringmatchlen(pattern->pattern, plen, key, keylen, 0)) return ACL_OK;
+        if (stringMatcherMatch(&pattern->matcher, key, keylen)) return ACL_OK;
     }
     return ACL_DENIED_KEY;
 }
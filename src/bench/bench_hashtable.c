@@ -0,0 +1,114 @@
+#include <string.h>
+
+#include "../hashtable.h"
+#include "../zmalloc.h"
+#include "bench_help.h"
+
+/* Size of the tables the lookup and iteration benchmarks run against. A
+ * power of two, so that random keys are picked with a mask. */
+#define BENCH_HASHTABLE_SIZE (1 << 17)
+
+/* The entries are the keys themselves, plain C strings. */
+static uint64_t hashCString(const void *key) {
+    return hashtableGenHashFunction(key, strlen(key));
+}
+
+static int compareCString(const void *key1, const void *key2) {
+    return strcmp(key1, key2);
+}
+
+static hashtableType benchType = {
+    .hashFunction = hashCString,
+    .keyCompare = compareCString,
+};
+
+typedef struct {
+    hashtable *ht;
+    char **keys;       /* The keys the benchmark operates on. */
+    size_t numkeys;    /* Number of 'keys'. */
+    char **table_keys; /* The keys in the table, when they are not 'keys'. */
+} hashtableBench;
+
+static hashtableBench *createBench(size_t numkeys, size_t inserted) {
+    hashtableBench *b = zmalloc(sizeof(*b));
+    b->ht = hashtableCreate(&benchType);
+    b->keys = benchCreateKeys(numkeys, "key:");
+    b->numkeys = numkeys;
+    b->table_keys = NULL;
+    for (size_t j = 0; j < inserted; j++) hashtableAdd(b->ht, b->keys[j]);
+    return b;
+}
+
+static void freeBench(void *ctx) {
+    hashtableBench *b = ctx;
+    hashtableRelease(b->ht);
+    zfree(b->keys);
+    zfree(b->table_keys);
+    zfree(b);
+}
+
+static void *setupEmpty(size_t ops) {
+    return createBench(ops, 0);
+}
+
+static void *setupFull(size_t ops) {
+    return createBench(ops, ops);
+}
+
+static void *setupLookup(size_t ops) {
+    UNUSED(ops);
+    return createBench(BENCH_HASHTABLE_SIZE, BENCH_HASHTABLE_SIZE);
+}
+
+/* Same table as setupLookup(), but the keys looked up are not in it. */
+static void *setupLookupMiss(size_t ops) {
+    hashtableBench *b = setupLookup(ops);
+    b->table_keys = b->keys;
+    b->keys = benchCreateKeys(BENCH_HASHTABLE_SIZE, "miss:");
+    return b;
+}
+
+static void runAdd(void *ctx, size_t ops) {
+    hashtableBench *b = ctx;
+    for (size_t j = 0; j < ops; j++) hashtableAdd(b->ht, b->keys[j]);
+}
+
+static void runFind(void *ctx, size_t ops) {
+    hashtableBench *b = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    void *found;
+    for (size_t j = 0; j < ops; j++) {
+        hashtableFind(b->ht, b->keys[benchRandom(&seed) & (b->numkeys - 1)], &found);
+        BENCH_KEEP(found);
+    }
+}
+
+static void runDelete(void *ctx, size_t ops) {
+    hashtableBench *b = ctx;
+    for (size_t j = 0; j < ops; j++) hashtableDelete(b->ht, b->keys[j]);
+}
+
+static void runIterate(void *ctx, size_t ops) {
+    hashtableBench *b = ctx;
+    hashtableIterator iter;
+    void *next;
+    hashtableInitIterator(&iter, b->ht, 0);
+    for (size_t j = 0; j < ops; j++) {
+        if (!hashtableNext(&iter, &next)) {
+            hashtableResetIterator(&iter);
+            hashtableInitIterator(&iter, b->ht, 0);
+            hashtableNext(&iter, &next);
+        }
+        BENCH_KEEP(next);
+    }
+    hashtableResetIterator(&iter);
+}
+
+microBenchmark benchHashtable[] = {
+    {"add", setupEmpty, runAdd, freeBench},
+    {"find", setupLookup, runFind, freeBench},
+    {"find_miss", setupLookupMiss, runFind, freeBench},
+    {"delete", setupFull, runDelete, freeBench},
+    {"iterate", setupLookup, runIterate, freeBench},
+    {NULL, NULL, NULL, NULL},
+};
@@ -0,0 +1,64 @@
+/* A very simple micro benchmark framework for valkey. See bench/README.md for
+ * more information on usage.
+ *
+ * Example:
+ *
+ * static void *setupExample(size_t ops) {
+ *     return zmalloc(ops);
+ * }
+ *
+ * static void runExample(void *ctx, size_t ops) {
+ *     memset(ctx, 0, ops);
+ * }
+ *
+ * microBenchmark benchExample[] = {
+ *     {"memset", setupExample, runExample, zfree},
+ *     {NULL, NULL, NULL, NULL},
+ * };
+ */
+
+#ifndef __BENCHHELP_H
+#define __BENCHHELP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Prepares the input needed to perform 'ops' operations, and returns it. It
+ * is not part of the measurement. */
+typedef void *benchSetupProc(size_t ops);
+/* Performs 'ops' operations. This is the measured part. */
+typedef void benchRunProc(void *ctx, size_t ops);
+/* Releases what the setup function returned. It is not part of the
+ * measurement. */
+typedef void benchTeardownProc(void *ctx);
+
+typedef struct microBenchmark {
+    const char *name;
+    benchSetupProc *setup; /* Can be NULL, in which case the context is NULL. */
+    benchRunProc *run;
+    benchTeardownProc *teardown; /* Can be NULL. */
+} microBenchmark;
+
+/* Keeps the compiler from optimizing away a computation whose result is
+ * otherwise unused. */
+#define BENCH_KEEP(x) __asm__ volatile("" : : "r"(x) : "memory")
+
+/* A fast pseudo random generator, so that generating the input of the
+ * benchmarks does not dominate them. */
+static inline uint64_t benchRandom(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/* Creates 'count' distinct keys "<prefix><n>" in a single allocation, that
+ * is released with zfree(). */
+char **benchCreateKeys(size_t count, const char *prefix);
+
+#ifndef UNUSED
+#define UNUSED(x) (void)(x)
+#endif
+
+#endif
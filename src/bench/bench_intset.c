@@ -0,0 +1,48 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../intset.h"
+#include "../zmalloc.h"
+#include "bench_help.h"
+
+/* Number of entries of the intsets, the default set-max-intset-entries. */
+#define BENCH_INTSET_ENTRIES 512
+
+/* Builds intsets of BENCH_INTSET_ENTRIES random 32 bit integers, inserted in
+ * random order, so that the memmove of the sorted insertion is measured. */
+static void runAdd(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    intset *is = intsetNew();
+    for (size_t j = 0; j < ops; j++) {
+        if (j % BENCH_INTSET_ENTRIES == 0 && j) {
+            zfree(is);
+            is = intsetNew();
+        }
+        is = intsetAdd(is, (int32_t)benchRandom(&seed), NULL);
+    }
+    zfree(is);
+}
+
+static void *setupIntset(size_t ops) {
+    UNUSED(ops);
+    intset *is = intsetNew();
+    for (int64_t j = 0; j < BENCH_INTSET_ENTRIES; j++) is = intsetAdd(is, j * 7919, NULL);
+    return is;
+}
+
+/* Half of the lookups are hits. */
+static void runFind(void *ctx, size_t ops) {
+    intset *is = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t j = 0; j < ops; j++) {
+        uint8_t found = intsetFind(is, (int64_t)(benchRandom(&seed) % (BENCH_INTSET_ENTRIES * 2)) * 7919);
+        BENCH_KEEP(found);
+    }
+}
+
+microBenchmark benchIntset[] = {
+    {"add", NULL, runAdd, NULL},
+    {"find", setupIntset, runFind, zfree},
+    {NULL, NULL, NULL, NULL},
+};
@@ -0,0 +1,99 @@
+#include <string.h>
+
+#include "../listpack.h"
+#include "../zmalloc.h"
+#include "bench_help.h"
+
+/* Number of entries of the listpacks, the default list-max-listpack-size
+ * and hash-max-listpack-entries are in the same range. */
+#define BENCH_LISTPACK_ENTRIES 128
+
+static const char *value = "value:0123456789";
+
+/* Builds listpacks of BENCH_LISTPACK_ENTRIES strings, the way list pushes
+ * do, so that the reallocation of the growing listpack is measured too. */
+static void runAppendString(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    unsigned char *lp = lpNew(0);
+    for (size_t j = 0; j < ops; j++) {
+        if (j % BENCH_LISTPACK_ENTRIES == 0 && j) {
+            lpFree(lp);
+            lp = lpNew(0);
+        }
+        lp = lpAppend(lp, (unsigned char *)value, strlen(value));
+    }
+    lpFree(lp);
+}
+
+static void runAppendInteger(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    unsigned char *lp = lpNew(0);
+    for (size_t j = 0; j < ops; j++) {
+        if (j % BENCH_LISTPACK_ENTRIES == 0 && j) {
+            lpFree(lp);
+            lp = lpNew(0);
+        }
+        lp = lpAppendInteger(lp, (long long)j * 7919);
+    }
+    lpFree(lp);
+}
+
+/* A listpack of field value pairs, like a small hash: the fields are
+ * "field:<n>" and the values alternate between strings and integers. */
+static void *setupListpack(size_t ops) {
+    UNUSED(ops);
+    char buf[32];
+    unsigned char *lp = lpNew(0);
+    for (int j = 0; j < BENCH_LISTPACK_ENTRIES / 2; j++) {
+        int len = snprintf(buf, sizeof(buf), "field:%d", j);
+        lp = lpAppend(lp, (unsigned char *)buf, len);
+        if (j % 2)
+            lp = lpAppend(lp, (unsigned char *)value, strlen(value));
+        else
+            lp = lpAppendInteger(lp, j * 1000003LL);
+    }
+    return lp;
+}
+
+static void runIterate(void *ctx, size_t ops) {
+    unsigned char *lp = ctx, *p = lpFirst(lp);
+    unsigned int slen;
+    long long lval;
+    for (size_t j = 0; j < ops; j++) {
+        if (p == NULL) p = lpFirst(lp);
+        unsigned char *s = lpGetValue(p, &slen, &lval);
+        BENCH_KEEP(s);
+        BENCH_KEEP(lval);
+        p = lpNext(lp, p);
+    }
+}
+
+static void runSeek(void *ctx, size_t ops) {
+    unsigned char *lp = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t j = 0; j < ops; j++) {
+        unsigned char *p = lpSeek(lp, benchRandom(&seed) % BENCH_LISTPACK_ENTRIES);
+        BENCH_KEEP(p);
+    }
+}
+
+/* Looks up a field, skipping the values, like HGET does. */
+static void runFindField(void *ctx, size_t ops) {
+    unsigned char *lp = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    char buf[32];
+    for (size_t j = 0; j < ops; j++) {
+        int len = snprintf(buf, sizeof(buf), "field:%d", (int)(benchRandom(&seed) % (BENCH_LISTPACK_ENTRIES / 2)));
+        unsigned char *p = lpFind(lp, lpFirst(lp), (unsigned char *)buf, len, 1);
+        BENCH_KEEP(p);
+    }
+}
+
+microBenchmark benchListpack[] = {
+    {"append_string", NULL, runAppendString, NULL},
+    {"append_integer", NULL, runAppendInteger, NULL},
+    {"iterate", setupListpack, runIterate, lpFreeVoid},
+    {"seek", setupListpack, runSeek, lpFreeVoid},
+    {"find_field", setupListpack, runFindField, lpFreeVoid},
+    {NULL, NULL, NULL, NULL},
+};
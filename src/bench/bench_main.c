@@ -0,0 +1,452 @@
+/*
+ * Copyright Valkey contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#include <errno.h>
+#include <strings.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "bench_help.h"
+#include "../zmalloc.h"
+#include "../util.h"
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
+#define BENCH_MAX_REPETITIONS 100
+
+extern microBenchmark benchHashtable[];
+extern microBenchmark benchIntset[];
+extern microBenchmark benchListpack[];
+extern microBenchmark benchQuicklist[];
+extern microBenchmark benchRax[];
+extern microBenchmark benchSds[];
+extern microBenchmark benchStream[];
+
+static struct benchSuite {
+    const char *name;
+    microBenchmark *benchmarks;
+} benchSuites[] = {
+    {"hashtable", benchHashtable},
+    {"intset", benchIntset},
+    {"listpack", benchListpack},
+    {"quicklist", benchQuicklist},
+    {"rax", benchRax},
+    {"sds", benchSds},
+    {"stream", benchStream},
+};
+
+static struct benchConfig {
+    const char *filter;
+    int repetitions;
+    long long min_time_ns;
+    long long warmup_ns;
+    int counters;
+    const char *save_baseline;
+    const char *baseline;
+    double threshold;
+} config = {
+    .filter = NULL,
+    .repetitions = 5,
+    .min_time_ns = 100 * 1000000LL,
+    .warmup_ns = 100 * 1000000LL,
+    .counters = 1,
+    .save_baseline = NULL,
+    .baseline = NULL,
+    .threshold = 5,
+};
+
+/* We override the default assertion mechanism, so that it prints out info and then dies. */
+void _serverAssert(const char *estr, const char *file, int line) {
+    printf("serverAssert - %s:%d - %s\n", file, line, estr);
+    exit(1);
+}
+
+static long long benchNanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Creates 'count' distinct keys "<prefix><n>", in a single allocation. */
+char **benchCreateKeys(size_t count, const char *prefix) {
+    size_t stride = strlen(prefix) + 21;
+    char **keys = zmalloc(count * (sizeof(char *) + stride));
+    char *buf = (char *)(keys + count);
+    for (size_t j = 0; j < count; j++) {
+        keys[j] = buf + j * stride;
+        snprintf(keys[j], stride, "%s%zu", prefix, j);
+    }
+    return keys;
+}
+
+/* ----------------------------------------------------------------------------
+ * Allocation counting
+ * ------------------------------------------------------------------------- */
+
+/* Fetches the total number of allocation requests and allocated bytes so
+ * far. Only jemalloc keeps these statistics, with other allocators 0 is
+ * returned. */
+static int benchAllocStats(uint64_t *allocs, uint64_t *bytes) {
+#if defined(USE_JEMALLOC)
+    uint64_t epoch = 1, small = 0, large = 0;
+    size_t sz = sizeof(epoch);
+    /* The allocations served by the thread cache are only accounted in the
+     * arena statistics when the cache is flushed. */
+    je_mallctl("thread.tcache.flush", NULL, NULL, NULL, 0);
+    je_mallctl("epoch", &epoch, &sz, &epoch, sz);
+    sz = sizeof(uint64_t);
+    if (je_mallctl("stats.arenas." STRINGIFY(MALLCTL_ARENAS_ALL) ".small.nrequests", &small, &sz, NULL, 0) ||
+        je_mallctl("stats.arenas." STRINGIFY(MALLCTL_ARENAS_ALL) ".large.nrequests", &large, &sz, NULL, 0) ||
+        je_mallctl("thread.allocated", bytes, &sz, NULL, 0))
+        return 0;
+    *allocs = small + large;
+    return 1;
+#else
+    UNUSED(allocs);
+    UNUSED(bytes);
+    return 0;
+#endif
+}
+
+/* ----------------------------------------------------------------------------
+ * Hardware counters
+ * ------------------------------------------------------------------------- */
+
+enum {
+    COUNTER_CYCLES = 0,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_CACHE_MISSES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_NUM
+};
+
+static const char *counter_names[COUNTER_NUM] = {"cycles/op", "instr/op", "llc-miss/op", "br-miss/op"};
+
+/* The counters are opened as a single group, so that they are enabled and
+ * read together. Counters the CPU or the kernel don't support are skipped,
+ * their 'counter_slot' is -1. */
+static int counter_fds[COUNTER_NUM] = {-1, -1, -1, -1};
+static int counter_slot[COUNTER_NUM] = {-1, -1, -1, -1};
+static int counter_leader = -1;
+static int counters_opened = 0;
+
+#ifdef __linux__
+static int benchOpenCounter(uint64_t config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+static void benchOpenCounters(void) {
+#ifdef __linux__
+    static const uint64_t events[COUNTER_NUM] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int j = 0; j < COUNTER_NUM; j++) {
+        counter_fds[j] = benchOpenCounter(events[j], counter_leader);
+        if (counter_fds[j] == -1) continue;
+        if (counter_leader == -1) counter_leader = counter_fds[j];
+        counter_slot[j] = counters_opened++;
+    }
+#endif
+    if (!counters_opened)
+        printf("Hardware counters are not available (check /proc/sys/kernel/perf_event_paranoid).\n\n");
+}
+
+static void benchStartCounters(void) {
+#ifdef __linux__
+    if (!counters_opened) return;
+    ioctl(counter_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counter_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+static void benchStopCounters(uint64_t *values) {
+    memset(values, 0, sizeof(uint64_t) * COUNTER_NUM);
+#ifdef __linux__
+    if (!counters_opened) return;
+    uint64_t buf[1 + COUNTER_NUM];
+    ioctl(counter_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(counter_leader, buf, sizeof(buf)) <= 0) return;
+    for (int j = 0; j < COUNTER_NUM; j++) {
+        if (counter_slot[j] != -1) values[j] = buf[1 + counter_slot[j]];
+    }
+#endif
+}
+
+/* ----------------------------------------------------------------------------
+ * Baselines
+ * ------------------------------------------------------------------------- */
+
+typedef struct benchResult {
+    char name[128];
+    size_t ops;       /* Operations per repetition. */
+    double ns_per_op; /* Median of the repetitions. */
+    double spread;    /* (slowest - fastest) / median of the repetitions. */
+    double allocs_per_op;
+    double bytes_per_op;
+    double counters[COUNTER_NUM]; /* Per operation, from the median repetition. */
+} benchResult;
+
+typedef struct benchBaseline {
+    char name[128];
+    double ns_per_op;
+} benchBaseline;
+
+static benchBaseline *baselines = NULL;
+static int baselines_count = 0;
+
+/* The baseline file has one line per benchmark, "<suite>:<name> <ns/op>". */
+static void benchLoadBaseline(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Can't open the baseline file %s: %s\n", filename, strerror(errno));
+        exit(1);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        benchBaseline b;
+        if (sscanf(line, "%127s %lf", b.name, &b.ns_per_op) != 2) continue;
+        baselines = zrealloc(baselines, sizeof(benchBaseline) * (baselines_count + 1));
+        baselines[baselines_count++] = b;
+    }
+    fclose(fp);
+}
+
+static benchBaseline *benchFindBaseline(const char *name) {
+    for (int j = 0; j < baselines_count; j++) {
+        if (!strcmp(baselines[j].name, name)) return &baselines[j];
+    }
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------------
+ * Runner
+ * ------------------------------------------------------------------------- */
+
+/* Runs 'ops' operations of the benchmark, returning the elapsed time of the
+ * measured part in nanoseconds. */
+static long long benchRunOnce(microBenchmark *b, size_t ops, uint64_t *allocs, uint64_t *bytes, uint64_t *counters) {
+    uint64_t allocs_start = 0, bytes_start = 0;
+    void *ctx = b->setup ? b->setup(ops) : NULL;
+
+    int alloc_stats = benchAllocStats(&allocs_start, &bytes_start);
+    benchStartCounters();
+    long long start = benchNanoseconds();
+    b->run(ctx, ops);
+    long long elapsed = benchNanoseconds() - start;
+    benchStopCounters(counters);
+    if (alloc_stats && benchAllocStats(allocs, bytes)) {
+        *allocs -= allocs_start;
+        *bytes -= bytes_start;
+    } else {
+        *allocs = *bytes = 0;
+    }
+
+    if (b->teardown) b->teardown(ctx);
+    return elapsed > 0 ? elapsed : 1;
+}
+
+/* Runs the benchmark with a growing number of operations until the warm-up
+ * time has elapsed, and returns the number of operations a repetition should
+ * do to run for about the minimum time. */
+static size_t benchCalibrate(microBenchmark *b) {
+    uint64_t allocs, bytes, counters[COUNTER_NUM];
+    long long start = benchNanoseconds();
+    size_t ops = 1;
+    double ns_per_op;
+
+    while (1) {
+        long long elapsed = benchRunOnce(b, ops, &allocs, &bytes, counters);
+        ns_per_op = (double)elapsed / ops;
+        if (benchNanoseconds() - start >= config.warmup_ns && elapsed >= config.min_time_ns / 10) break;
+        if (elapsed >= config.min_time_ns) break;
+        ops = elapsed < config.min_time_ns / 100 ? ops * 10 : ops * 2;
+    }
+    double target = config.min_time_ns / ns_per_op;
+    return target < 1 ? 1 : (size_t)target;
+}
+
+static int benchCompareDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void benchRun(microBenchmark *b, const char *suite, benchResult *r) {
+    double ns_per_op[BENCH_MAX_REPETITIONS], sorted[BENCH_MAX_REPETITIONS];
+    uint64_t counters[BENCH_MAX_REPETITIONS][COUNTER_NUM];
+    uint64_t allocs = 0, bytes = 0;
+
+    snprintf(r->name, sizeof(r->name), "%s:%s", suite, b->name);
+    r->ops = benchCalibrate(b);
+    for (int j = 0; j < config.repetitions; j++) {
+        uint64_t rep_allocs, rep_bytes;
+        ns_per_op[j] = (double)benchRunOnce(b, r->ops, &rep_allocs, &rep_bytes, counters[j]) / r->ops;
+        allocs += rep_allocs;
+        bytes += rep_bytes;
+    }
+
+    memcpy(sorted, ns_per_op, sizeof(double) * config.repetitions);
+    qsort(sorted, config.repetitions, sizeof(double), benchCompareDouble);
+    r->ns_per_op = sorted[config.repetitions / 2];
+    r->spread = (sorted[config.repetitions - 1] - sorted[0]) / r->ns_per_op;
+    r->allocs_per_op = (double)allocs / config.repetitions / r->ops;
+    r->bytes_per_op = (double)bytes / config.repetitions / r->ops;
+
+    int median = 0;
+    for (int j = 0; j < config.repetitions; j++) {
+        if (ns_per_op[j] == r->ns_per_op) median = j;
+    }
+    for (int j = 0; j < COUNTER_NUM; j++) r->counters[j] = (double)counters[median][j] / r->ops;
+}
+
+static void benchPrintHeader(void) {
+    printf("%-40s %10s %10s %7s %10s %10s", "benchmark", "ops/rep", "ns/op", "spread", "allocs/op", "bytes/op");
+    for (int j = 0; j < COUNTER_NUM; j++) {
+        if (counter_slot[j] != -1) printf(" %11s", counter_names[j]);
+    }
+    if (counter_slot[COUNTER_CYCLES] != -1 && counter_slot[COUNTER_INSTRUCTIONS] != -1) printf(" %5s", "IPC");
+    if (baselines) printf(" %9s", "baseline");
+    printf("\n");
+}
+
+/* Prints the result, and returns 1 if it is a regression compared to the
+ * baseline. */
+static int benchPrintResult(benchResult *r) {
+    int regression = 0;
+    printf("%-40s %10zu %10.2f %6.1f%% ", r->name, r->ops, r->ns_per_op, r->spread * 100);
+#if defined(USE_JEMALLOC)
+    printf("%10.2f %10.1f", r->allocs_per_op, r->bytes_per_op);
+#else
+    printf("%10s %10s", "-", "-");
+#endif
+    for (int j = 0; j < COUNTER_NUM; j++) {
+        if (counter_slot[j] != -1) printf(" %11.2f", r->counters[j]);
+    }
+    if (counter_slot[COUNTER_CYCLES] != -1 && counter_slot[COUNTER_INSTRUCTIONS] != -1)
+        printf(" %5.2f", r->counters[COUNTER_CYCLES] ? r->counters[COUNTER_INSTRUCTIONS] / r->counters[COUNTER_CYCLES]
+                                                     : 0);
+    if (baselines) {
+        benchBaseline *b = benchFindBaseline(r->name);
+        if (b) {
+            double change = (r->ns_per_op - b->ns_per_op) / b->ns_per_op * 100;
+            regression = change > config.threshold;
+            printf(" %+8.1f%%%s", change, regression ? " REGRESSION" : "");
+        } else {
+            printf(" %9s", "new");
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+    return regression;
+}
+
+static void benchUsage(void) {
+    printf("Usage: valkey-microbench [options]\n\n"
+           "Options:\n"
+           " --filter <pattern>     Only run the benchmarks matching the glob-style\n"
+           "                        pattern, e.g. 'hashtable:*' or '*find*'.\n"
+           " --list                 List the benchmarks and exit.\n"
+           " --repetitions <num>    Measured repetitions of each benchmark (default 5),\n"
+           "                        the median is reported.\n"
+           " --min-time <ms>        Duration of each repetition (default 100).\n"
+           " --warmup <ms>          Warm-up duration, used to size the repetitions (default 100).\n"
+           " --no-counters          Don't collect hardware counters.\n"
+           " --save-baseline <file> Save the results, to compare later runs against them.\n"
+           " --baseline <file>      Compare the results to the saved ones. The exit code is\n"
+           "                        1 if a benchmark is slower than the threshold.\n"
+           " --threshold <percent>  Slowdown considered a regression (default 5).\n");
+}
+
+int main(int argc, char **argv) {
+    int list = 0;
+    for (int j = 1; j < argc; j++) {
+        char *arg = argv[j];
+        int moreargs = j + 1 < argc;
+        if (!strcasecmp(arg, "--filter") && moreargs) {
+            config.filter = argv[++j];
+        } else if (!strcasecmp(arg, "--list")) {
+            list = 1;
+        } else if (!strcasecmp(arg, "--repetitions") && moreargs) {
+            config.repetitions = atoi(argv[++j]);
+            if (config.repetitions < 1 || config.repetitions > BENCH_MAX_REPETITIONS) {
+                fprintf(stderr, "The number of repetitions must be between 1 and %d\n", BENCH_MAX_REPETITIONS);
+                return 1;
+            }
+        } else if (!strcasecmp(arg, "--min-time") && moreargs) {
+            config.min_time_ns = atoll(argv[++j]) * 1000000LL;
+            if (config.min_time_ns <= 0) config.min_time_ns = 1000000LL;
+        } else if (!strcasecmp(arg, "--warmup") && moreargs) {
+            config.warmup_ns = atoll(argv[++j]) * 1000000LL;
+            if (config.warmup_ns < 0) config.warmup_ns = 0;
+        } else if (!strcasecmp(arg, "--no-counters")) {
+            config.counters = 0;
+        } else if (!strcasecmp(arg, "--save-baseline") && moreargs) {
+            config.save_baseline = argv[++j];
+        } else if (!strcasecmp(arg, "--baseline") && moreargs) {
+            config.baseline = argv[++j];
+        } else if (!strcasecmp(arg, "--threshold") && moreargs) {
+            config.threshold = atof(argv[++j]);
+        } else {
+            benchUsage();
+            return !strcasecmp(arg, "--help") ? 0 : 1;
+        }
+    }
+
+    if (config.baseline) benchLoadBaseline(config.baseline);
+    FILE *save = NULL;
+    if (config.save_baseline) {
+        save = fopen(config.save_baseline, "w");
+        if (save == NULL) {
+            fprintf(stderr, "Can't open the baseline file %s: %s\n", config.save_baseline, strerror(errno));
+            return 1;
+        }
+    }
+    if (config.counters && !list) benchOpenCounters();
+    if (!list) benchPrintHeader();
+
+    int numsuites = sizeof(benchSuites) / sizeof(struct benchSuite);
+    int executed = 0, regressions = 0;
+    for (int j = 0; j < numsuites; j++) {
+        for (microBenchmark *b = benchSuites[j].benchmarks; b->name != NULL; b++) {
+            char name[128];
+            snprintf(name, sizeof(name), "%s:%s", benchSuites[j].name, b->name);
+            if (config.filter && !stringmatch(config.filter, name, 0)) continue;
+            if (list) {
+                printf("%s\n", name);
+                continue;
+            }
+            benchResult r;
+            benchRun(b, benchSuites[j].name, &r);
+            regressions += benchPrintResult(&r);
+            if (save) fprintf(save, "%s %.4f\n", r.name, r.ns_per_op);
+            executed++;
+        }
+    }
+    if (save) fclose(save);
+    if (list) return 0;
+
+    printf("\n%d benchmarks executed", executed);
+    if (baselines) printf(", %d regressions over %.1f%%", regressions, config.threshold);
+    printf("\n");
+    return regressions ? 1 : 0;
+}
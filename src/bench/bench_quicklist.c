@@ -0,0 +1,89 @@
+#include <string.h>
+
+#include "../quicklist.h"
+#include "../zmalloc.h"
+#include "bench_help.h"
+
+/* Length of the lists the iteration and index benchmarks run against. */
+#define BENCH_QUICKLIST_LENGTH 100000
+
+static const char *value = "value:0123456789";
+
+/* The lists use the default list-max-listpack-size (-2) and no compression,
+ * unless the benchmark name says otherwise. */
+static void *setupEmpty(size_t ops) {
+    UNUSED(ops);
+    return quicklistNew(-2, 0);
+}
+
+static void *setupEmptyCompressed(size_t ops) {
+    UNUSED(ops);
+    return quicklistNew(-2, 1);
+}
+
+static void *setupFull(size_t ops) {
+    quicklist *ql = quicklistNew(-2, 0);
+    for (size_t j = 0; j < ops; j++) quicklistPushTail(ql, (void *)value, strlen(value));
+    return ql;
+}
+
+static void *setupList(size_t ops) {
+    UNUSED(ops);
+    return setupFull(BENCH_QUICKLIST_LENGTH);
+}
+
+static void freeList(void *ctx) {
+    quicklistRelease(ctx);
+}
+
+static void runPushTail(void *ctx, size_t ops) {
+    quicklist *ql = ctx;
+    for (size_t j = 0; j < ops; j++) quicklistPushTail(ql, (void *)value, strlen(value));
+}
+
+static void runPopHead(void *ctx, size_t ops) {
+    quicklist *ql = ctx;
+    unsigned char *data;
+    size_t sz;
+    long long lval;
+    for (size_t j = 0; j < ops; j++) {
+        quicklistPop(ql, QUICKLIST_HEAD, &data, &sz, &lval);
+        zfree(data);
+    }
+}
+
+static void runIterate(void *ctx, size_t ops) {
+    quicklist *ql = ctx;
+    quicklistIter *iter = quicklistGetIterator(ql, AL_START_HEAD);
+    quicklistEntry entry;
+    for (size_t j = 0; j < ops; j++) {
+        if (!quicklistNext(iter, &entry)) {
+            quicklistReleaseIterator(iter);
+            iter = quicklistGetIterator(ql, AL_START_HEAD);
+            quicklistNext(iter, &entry);
+        }
+        BENCH_KEEP(entry.value);
+    }
+    quicklistReleaseIterator(iter);
+}
+
+/* Random access, like LINDEX does. */
+static void runIndex(void *ctx, size_t ops) {
+    quicklist *ql = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    quicklistEntry entry;
+    for (size_t j = 0; j < ops; j++) {
+        quicklistIter *iter = quicklistGetIteratorEntryAtIdx(ql, benchRandom(&seed) % BENCH_QUICKLIST_LENGTH, &entry);
+        BENCH_KEEP(entry.value);
+        quicklistReleaseIterator(iter);
+    }
+}
+
+microBenchmark benchQuicklist[] = {
+    {"push_tail", setupEmpty, runPushTail, freeList},
+    {"push_tail_compressed", setupEmptyCompressed, runPushTail, freeList},
+    {"pop_head", setupFull, runPopHead, freeList},
+    {"iterate", setupList, runIterate, freeList},
+    {"index", setupList, runIndex, freeList},
+    {NULL, NULL, NULL, NULL},
+};
@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include "../rax.h"
+#include "../zmalloc.h"
+#include "bench_help.h"
+
+/* Number of keys of the tree the lookup and iteration benchmarks run
+ * against. A power of two, so that random keys are picked with a mask. */
+#define BENCH_RAX_SIZE (1 << 17)
+
+typedef struct {
+    rax *rt;
+    char **keys;
+    size_t numkeys;
+} raxBench;
+
+static raxBench *createBench(size_t numkeys, size_t inserted) {
+    raxBench *b = zmalloc(sizeof(*b));
+    b->rt = raxNew();
+    b->keys = benchCreateKeys(numkeys, "key:");
+    b->numkeys = numkeys;
+    for (size_t j = 0; j < inserted; j++) raxInsert(b->rt, (unsigned char *)b->keys[j], strlen(b->keys[j]), NULL, NULL);
+    return b;
+}
+
+static void freeBench(void *ctx) {
+    raxBench *b = ctx;
+    raxFree(b->rt);
+    zfree(b->keys);
+    zfree(b);
+}
+
+static void *setupEmpty(size_t ops) {
+    return createBench(ops, 0);
+}
+
+static void *setupFull(size_t ops) {
+    return createBench(ops, ops);
+}
+
+static void *setupLookup(size_t ops) {
+    UNUSED(ops);
+    return createBench(BENCH_RAX_SIZE, BENCH_RAX_SIZE);
+}
+
+static void runInsert(void *ctx, size_t ops) {
+    raxBench *b = ctx;
+    for (size_t j = 0; j < ops; j++) raxInsert(b->rt, (unsigned char *)b->keys[j], strlen(b->keys[j]), NULL, NULL);
+}
+
+static void runFind(void *ctx, size_t ops) {
+    raxBench *b = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    void *value;
+    for (size_t j = 0; j < ops; j++) {
+        char *key = b->keys[benchRandom(&seed) & (b->numkeys - 1)];
+        int found = raxFind(b->rt, (unsigned char *)key, strlen(key), &value);
+        BENCH_KEEP(found);
+    }
+}
+
+static void runRemove(void *ctx, size_t ops) {
+    raxBench *b = ctx;
+    for (size_t j = 0; j < ops; j++) raxRemove(b->rt, (unsigned char *)b->keys[j], strlen(b->keys[j]), NULL);
+}
+
+static void runIterate(void *ctx, size_t ops) {
+    raxBench *b = ctx;
+    raxIterator ri;
+    raxStart(&ri, b->rt);
+    raxSeek(&ri, "^", NULL, 0);
+    for (size_t j = 0; j < ops; j++) {
+        if (!raxNext(&ri)) {
+            raxSeek(&ri, "^", NULL, 0);
+            raxNext(&ri);
+        }
+        BENCH_KEEP(ri.key);
+    }
+    raxStop(&ri);
+}
+
+microBenchmark benchRax[] = {
+    {"insert", setupEmpty, runInsert, freeBench},
+    {"find", setupLookup, runFind, freeBench},
+    {"remove", setupFull, runRemove, freeBench},
+    {"iterate", setupLookup, runIterate, freeBench},
+    {NULL, NULL, NULL, NULL},
+};
@@ -0,0 +1,67 @@
+#include <string.h>
+
+#include "../sds.h"
+#include "bench_help.h"
+
+static void runNewFree(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    for (size_t j = 0; j < ops; j++) {
+        sds s = sdsnewlen("0123456789abcdef", 16);
+        BENCH_KEEP(s);
+        sdsfree(s);
+    }
+}
+
+/* Builds strings of 128 appends of 8 bytes, so that the reallocation of the
+ * growing string is measured too. */
+static void runCatLen(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    sds s = sdsempty();
+    for (size_t j = 0; j < ops; j++) {
+        if (j % 128 == 0 && j) {
+            sdsfree(s);
+            s = sdsempty();
+        }
+        s = sdscatlen(s, "01234567", 8);
+    }
+    sdsfree(s);
+}
+
+static void runCatFmt(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    sds s = sdsempty();
+    for (size_t j = 0; j < ops; j++) {
+        sdsclear(s);
+        s = sdscatfmt(s, "%s:%I", "key", (long long)j);
+    }
+    sdsfree(s);
+}
+
+static void runCatPrintf(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    sds s = sdsempty();
+    for (size_t j = 0; j < ops; j++) {
+        sdsclear(s);
+        s = sdscatprintf(s, "%s:%lld", "key", (long long)j);
+    }
+    sdsfree(s);
+}
+
+static void runSplit(void *ctx, size_t ops) {
+    UNUSED(ctx);
+    const char *line = "field1,field2,field3,field4,field5,field6,field7,field8";
+    int count;
+    for (size_t j = 0; j < ops; j++) {
+        sds *tokens = sdssplitlen(line, strlen(line), ",", 1, &count);
+        sdsfreesplitres(tokens, count);
+    }
+}
+
+microBenchmark benchSds[] = {
+    {"new_free", NULL, runNewFree, NULL},
+    {"catlen", NULL, runCatLen, NULL},
+    {"catfmt", NULL, runCatFmt, NULL},
+    {"catprintf", NULL, runCatPrintf, NULL},
+    {"split", NULL, runSplit, NULL},
+    {NULL, NULL, NULL, NULL},
+};
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../server.h"
+#include "bench_help.h"
+
+/* Number of entries of the streams, and of the entries every range reads,
+ * like XRANGE key <id> + COUNT 100. */
+#define BENCH_STREAM_ENTRIES 10000
+#define BENCH_STREAM_RANGE 100
+
+/* Narrow entries have a couple of small fields, wide entries have many
+ * fields with larger values. */
+#define BENCH_STREAM_NARROW_FIELDS 2
+#define BENCH_STREAM_WIDE_FIELDS 32
+
+typedef struct {
+    stream *s;
+    client *c;
+} streamBench;
+
+/* Creates a stream of BENCH_STREAM_ENTRIES entries with 'numfields' fields
+ * each. All the entries have the same fields, as it is common, so they are
+ * compressed against the primary entry of their node. When 'tombstones' is
+ * true every other entry is deleted. */
+static streamBench *createBench(int numfields, size_t value_len, int tombstones) {
+    streamBench *b = zmalloc(sizeof(*b));
+    robj *argv[BENCH_STREAM_WIDE_FIELDS * 2];
+    char buf[64], value[256];
+
+    /* The replies are built out of the shared protocol headers. */
+    if (shared.ok == NULL) createSharedObjects();
+    /* The defaults of stream-node-max-bytes and stream-node-max-entries. */
+    server.stream_node_max_bytes = 4096;
+    server.stream_node_max_entries = 100;
+
+    memset(value, 'v', value_len);
+    for (int j = 0; j < numfields; j++) {
+        int len = snprintf(buf, sizeof(buf), "field:%d", j);
+        argv[j * 2] = createStringObject(buf, len);
+        argv[j * 2 + 1] = createStringObject(value, value_len);
+    }
+
+    b->s = streamNew();
+    for (size_t j = 0; j < BENCH_STREAM_ENTRIES; j++) {
+        streamID id = {1700000000000ULL + j, 0};
+        serverAssert(streamAppendItem(b->s, argv, numfields, NULL, &id, 1) == C_OK);
+    }
+    if (tombstones) {
+        for (size_t j = 0; j < BENCH_STREAM_ENTRIES; j += 2) {
+            streamID id = {1700000000000ULL + j, 0};
+            streamDeleteItem(b->s, &id);
+        }
+    }
+    for (int j = 0; j < numfields * 2; j++) decrRefCount(argv[j]);
+
+    /* A bare client that only accumulates the replies, reset after every
+     * range. Flagged like the module temporary clients, that get replies
+     * without a connection. */
+    b->c = zcalloc(sizeof(client));
+    b->c->buf = zmalloc_usable(PROTO_REPLY_CHUNK_BYTES, &b->c->buf_usable_size);
+    b->c->reply = listCreate();
+    listSetFreeMethod(b->c->reply, freeClientReplyValue);
+    b->c->flag.module = 1;
+    b->c->flag.fake = 1;
+    b->c->resp = 2;
+    return b;
+}
+
+static void freeBench(void *ctx) {
+    streamBench *b = ctx;
+    freeStream(b->s);
+    listRelease(b->c->reply);
+    zfree(b->c->buf);
+    zfree(b->c);
+    zfree(b);
+}
+
+static void *setupNarrow(size_t ops) {
+    UNUSED(ops);
+    return createBench(BENCH_STREAM_NARROW_FIELDS, 16, 0);
+}
+
+static void *setupWide(size_t ops) {
+    UNUSED(ops);
+    return createBench(BENCH_STREAM_WIDE_FIELDS, 64, 0);
+}
+
+static void *setupTombstones(size_t ops) {
+    UNUSED(ops);
+    return createBench(BENCH_STREAM_NARROW_FIELDS, 16, 1);
+}
+
+/* Replies to a range of BENCH_STREAM_RANGE entries starting at a random ID,
+ * the way XRANGE does. */
+static void runRange(void *ctx, size_t ops) {
+    streamBench *b = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t j = 0; j < ops; j++) {
+        streamID start = {1700000000000ULL + benchRandom(&seed) % (BENCH_STREAM_ENTRIES - BENCH_STREAM_RANGE * 2), 0};
+        size_t emitted = streamReplyWithRange(b->c, b->s, &start, NULL, BENCH_STREAM_RANGE, 0, NULL, NULL, 0, NULL);
+        BENCH_KEEP(emitted);
+        b->c->bufpos = 0;
+        listEmpty(b->c->reply);
+        b->c->reply_bytes = 0;
+    }
+}
+
+/* Reads the same ranges with the stream iterator, decoding entry by entry
+ * and field by field, for reference. */
+static void runIterate(void *ctx, size_t ops) {
+    streamBench *b = ctx;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t j = 0; j < ops; j++) {
+        streamID start = {1700000000000ULL + benchRandom(&seed) % (BENCH_STREAM_ENTRIES - BENCH_STREAM_RANGE * 2), 0};
+        streamIterator si;
+        streamID id;
+        int64_t numfields;
+        size_t emitted = 0;
+        streamIteratorStart(&si, b->s, &start, NULL, 0);
+        while (emitted < BENCH_STREAM_RANGE && streamIteratorGetID(&si, &id, &numfields)) {
+            while (numfields--) {
+                unsigned char *field, *value;
+                int64_t field_len, value_len;
+                streamIteratorGetField(&si, &field, &value, &field_len, &value_len);
+                BENCH_KEEP(field);
+                BENCH_KEEP(value);
+            }
+            emitted++;
+        }
+        streamIteratorStop(&si);
+    }
+}
+
+microBenchmark benchStream[] = {
+    {"xrange_narrow", setupNarrow, runRange, freeBench},
+    {"xrange_wide", setupWide, runRange, freeBench},
+    {"xrange_tombstones", setupTombstones, runRange, freeBench},
+    {"iterate_narrow", setupNarrow, runIterate, freeBench},
+    {"iterate_wide", setupWide, runIterate, freeBench},
+    {NULL, NULL, NULL, NULL},
+};
@@ -29,6 +29,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 
 /* -----------------------------------------------------------------------------
  * Helpers and low level bit functions.
@@ -492,6 +493,7 @@ robj *lookupStringForBitCommand(client *c, uint64_t maxbit, int *dirty) {
         o = dbUnshareStringValue(c->db, c->argv[1], o);
         size_t oldlen = sdslen(o->ptr);
         o->ptr = sdsgrowzero(o->ptr, byte + 1);
+        keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
         if (dirty && oldlen != sdslen(o->ptr)) *dirty = 1;
     }
     return o;
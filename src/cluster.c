@@ -75,30 +75,45 @@ unsigned int keyHashSlot(char *key, int keylen) {
  * stringmatchlen() in util.c, only can match keys belonging to a single slot,
  * that slot is returned. Otherwise -1 is returned. */
 int patternHashSlot(char *pattern, int length) {
-    int s = -1; /* index of the first '{' */
-
-    for (int i = 0; i < length; i++) {
-        if (pattern[i] == '*' || pattern[i] == '?' || pattern[i] == '[') {
-            /* Wildcard or character class found. Keys can be in any slot. */
-            return -1;
-        } else if (pattern[i] == '\\') {
-            /* Escaped character. Computing slot in this case is not
-             * implemented. We would need a temp buffer. */
-            return -1;
-        } else if (s == -1 && pattern[i] == '{') {
+    /* The literal part of the pattern preceding any wildcard is unescaped into
+     * 'key', which is the beginning of every key the pattern can match. */
+    char buf[128];
+    char *key = length <= (int)sizeof(buf) ? buf : zmalloc(length);
+    int keylen = 0;
+    int s = -1; /* index of the first '{' in 'key' */
+    int slot = -1, i;
+
+    for (i = 0; i < length; i++) {
+        char ch = pattern[i];
+        if (ch == '*' || ch == '?' || ch == '[') {
+            /* Wildcard or character class found. The rest of the key is
+             * unknown. */
+            break;
+        } else if (ch == '\\' && i + 1 < length) {
+            /* Escaped character, it matches itself. A trailing backslash
+             * matches a backslash, like in stringmatchlen(). */
+            ch = pattern[++i];
+        }
+        key[keylen] = ch;
+        if (s == -1 && ch == '{') {
             /* Opening brace '{' found. */
-            s = i;
-        } else if (s >= 0 && pattern[i] == '}' && i == s + 1) {
+            s = keylen;
+        } else if (s >= 0 && ch == '}' && keylen == s + 1) {
             /* Empty tag '{}' found. The whole key is hashed. Ignore braces. */
             s = -2;
-        } else if (s >= 0 && pattern[i] == '}') {
+        } else if (s >= 0 && ch == '}') {
             /* Non-empty tag '{...}' found. Hash what's between braces. */
-            return crc16(pattern + s + 1, i - s - 1) & 0x3FFF;
+            slot = crc16(key + s + 1, keylen - s - 1) & 0x3FFF;
+            break;
         }
+        keylen++;
     }
 
-    /* The pattern matches a single key. Hash the whole pattern. */
-    return crc16(pattern, length) & 0x3FFF;
+    /* The pattern matches a single key. Hash the whole key. */
+    if (i == length) slot = keyHashSlot(key, keylen);
+
+    if (key != buf) zfree(key);
+    return slot;
 }
 
 ConnectionType *connTypeOfCluster(void) {
@@ -153,8 +153,10 @@ void commandlogPushCurrentCommand(client *c, struct serverCommand *cmd) {
     /* If a script is currently running, the client passed in is a
      * fake client. Or the client passed in is the original client
      * if this is a EVAL or alike, doesn't matter. In this case,
-     * use the original client to get the client information. */
-    c = scriptIsRunning() ? scriptGetCaller() : c;
+     * use the original client to get the client information. Other clients
+     * may run commands while a read-only script is busy, they are logged as
+     * themselves. */
+    c = scriptIsRunning() && c->flag.script ? scriptGetCaller() : c;
 
     commandlogPushEntryIfNeeded(c, argv, argc, c->duration, COMMANDLOG_TYPE_SLOW);
     commandlogPushEntryIfNeeded(c, argv, argc, c->net_input_bytes_curr_cmd, COMMANDLOG_TYPE_LARGE_REQUEST);
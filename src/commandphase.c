@@ -0,0 +1,123 @@
+/* Command phase profiler.
+ *
+ * INFO commandstats tells how much time each command takes, but not where
+ * that time goes. When 'command-phase-sample-ratio' is not zero, one command
+ * every N is timed phase by phase:
+ *
+ * parse:   Parsing the command from the query buffer. This happens in the IO
+ *          threads when they are enabled, and may span multiple reads.
+ * lookup:  Looking up the keys of the command in the keyspace, including the
+ *          lazy expiration of the keys found expired.
+ * execute: The rest of the command implementation.
+ * reply:   Appending the reply to the output buffers of the client.
+ * write:   Writing the output buffers to the socket, in the IO threads when
+ *          they are enabled, until the reply of the command is fully written.
+ *          Pipelined replies written together with it are accounted too.
+ *
+ * Only commands executed directly by clients are sampled: the commands run
+ * by MULTI/EXEC, scripts and modules are accounted to the calling command.
+ * The times are exposed per command by INFO commandphasestats.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Copyright Valkey Contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#include "commandphase.h"
+
+__thread unsigned int cmd_phase_parses_since_sample = 0;
+
+/* Time spent in the lookup and reply phases by the command being executed,
+ * that is always run by the main thread. */
+static uint64_t cmd_phase_ns[CMD_PHASE_NUM];
+static uint64_t cmd_phase_start;
+
+void cmdPhaseAddTime(cmdPhase phase, uint64_t start) {
+    cmd_phase_ns[phase] += cmdPhaseTimeNs() - start;
+}
+
+/* Called by call() before running a sampled command. */
+void cmdPhaseCommandStart(void) {
+    memset(cmd_phase_ns, 0, sizeof(cmd_phase_ns));
+    server.cmd_phase_active = 1;
+    cmd_phase_start = cmdPhaseTimeNs();
+}
+
+/* Called by call() after running a sampled command, to account its phases
+ * to 'cmd'. */
+void cmdPhaseCommandEnd(client *c, struct serverCommand *cmd) {
+    uint64_t total = cmdPhaseTimeNs() - cmd_phase_start;
+    server.cmd_phase_active = 0;
+
+    /* A blocked command will run again, it's not worth tracking partial
+     * executions. */
+    if (c->flag.blocked) return;
+
+    uint64_t lookup = cmd_phase_ns[CMD_PHASE_LOOKUP], reply = cmd_phase_ns[CMD_PHASE_REPLY];
+    cmd->phase_samples++;
+    cmd->phase_ns[CMD_PHASE_PARSE] += c->cmd_phase_parse_ns;
+    cmd->phase_ns[CMD_PHASE_LOOKUP] += lookup;
+    cmd->phase_ns[CMD_PHASE_REPLY] += reply;
+    cmd->phase_ns[CMD_PHASE_EXECUTE] += total > lookup + reply ? total - lookup - reply : 0;
+
+    /* Start timing the writes of the client until the reply is written. If
+     * the reply of a previous sampled command is still pending we keep
+     * accounting the writes to that one. */
+    if (!c->cmd_phase_write_cmd && clientHasPendingReplies(c)) {
+        c->cmd_phase_write_cmd = cmd;
+        c->cmd_phase_write_ns = 0;
+    }
+}
+
+/* Called after the output buffers of a client with a sampled reply were
+ * written, by the main thread. */
+void cmdPhaseWriteDone(client *c) {
+    if (clientHasPendingReplies(c)) return;
+    c->cmd_phase_write_cmd->phase_ns[CMD_PHASE_WRITE] += c->cmd_phase_write_ns;
+    c->cmd_phase_write_cmd = NULL;
+    c->cmd_phase_write_ns = 0;
+}
+
+/* Called before commands are unregistered, with the IO threads drained: the
+ * clients still writing the reply of a sampled command stop referencing it,
+ * and the time of these writes is not accounted. */
+void cmdPhaseForgetPendingWrites(void) {
+    listIter li;
+    listNode *ln;
+    listRewind(server.clients, &li);
+    while ((ln = listNext(&li))) {
+        client *c = listNodeValue(ln);
+        c->cmd_phase_write_cmd = NULL;
+        c->cmd_phase_write_ns = 0;
+    }
+}
+
+sds genCommandPhaseInfoString(sds info, hashtable *commands) {
+    hashtableIterator iter;
+    void *next;
+    hashtableInitIterator(&iter, commands, HASHTABLE_ITER_SAFE);
+    while (hashtableNext(&iter, &next)) {
+        struct serverCommand *c = next;
+        char *tmpsafe;
+        if (c->phase_samples) {
+            double samples = c->phase_samples * 1000.0;
+            info = sdscatprintf(info,
+                                "cmdphasestat_%s:samples=%lld,parse_usec_per_call=%.3f"
+                                ",lookup_usec_per_call=%.3f,execute_usec_per_call=%.3f"
+                                ",reply_usec_per_call=%.3f,write_usec_per_call=%.3f\r\n",
+                                getSafeInfoString(c->fullname, sdslen(c->fullname), &tmpsafe), c->phase_samples,
+                                c->phase_ns[CMD_PHASE_PARSE] / samples, c->phase_ns[CMD_PHASE_LOOKUP] / samples,
+                                c->phase_ns[CMD_PHASE_EXECUTE] / samples, c->phase_ns[CMD_PHASE_REPLY] / samples,
+                                c->phase_ns[CMD_PHASE_WRITE] / samples);
+            if (tmpsafe != NULL) zfree(tmpsafe);
+        }
+        if (c->subcommands_ht) {
+            info = genCommandPhaseInfoString(info, c->subcommands_ht);
+        }
+    }
+    hashtableResetIterator(&iter);
+
+    return info;
+}
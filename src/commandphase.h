@@ -0,0 +1,56 @@
+/*
+ * Copyright Valkey Contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#ifndef __COMMANDPHASE_H__
+#define __COMMANDPHASE_H__
+
+#include "server.h"
+#include <time.h>
+
+/* Commands parsed by this thread since the last sampled one. */
+extern __thread unsigned int cmd_phase_parses_since_sample;
+
+/* Exported API */
+void cmdPhaseAddTime(cmdPhase phase, uint64_t start);
+void cmdPhaseCommandStart(void);
+void cmdPhaseCommandEnd(client *c, struct serverCommand *cmd);
+void cmdPhaseWriteDone(client *c);
+void cmdPhaseForgetPendingWrites(void);
+sds genCommandPhaseInfoString(sds info, hashtable *commands);
+
+/* Most phases take less than a microsecond, so unlike the rest of the
+ * server the profiler needs a nanoseconds clock. */
+static inline uint64_t cmdPhaseTimeNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Called before parsing the query buffer, from the main thread or from an IO
+ * thread. Decides whether the command being parsed is sampled when its first
+ * chunk is seen, and returns the start time of the parsing, or 0 if the
+ * command is not sampled. */
+static inline uint64_t cmdPhaseParseStart(client *c) {
+    if (!c->cmd_phase_sampled) {
+        if (server.command_phase_sample_ratio == 0 || c->argc || c->multibulklen) return 0;
+        if (++cmd_phase_parses_since_sample < (unsigned int)server.command_phase_sample_ratio) return 0;
+        cmd_phase_parses_since_sample = 0;
+        c->cmd_phase_sampled = 1;
+    }
+    return cmdPhaseTimeNs();
+}
+
+static inline void cmdPhaseParseEnd(client *c, uint64_t start) {
+    if (start) c->cmd_phase_parse_ns += cmdPhaseTimeNs() - start;
+}
+
+/* Returns the start time of a phase of the command being executed, or 0 if
+ * it is not sampled, so that the common case costs a single branch. */
+static inline uint64_t cmdPhaseStart(void) {
+    return server.cmd_phase_active ? cmdPhaseTimeNs() : 0;
+}
+
+#endif /* __COMMANDPHASE_H__ */
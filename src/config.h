@@ -349,6 +349,7 @@ void setcpuaffinity(const char *cpulist);
 #endif
 
 #define IO_THREADS_MAX_NUM 256
+#define TLS_HANDSHAKE_THREADS_MAX_NUM 64
 
 #ifndef CACHE_LINE_SIZE
 #if defined(__aarch64__) && defined(__APPLE__)
@@ -34,6 +34,9 @@
 #include "functions.h"
 #include "io_threads.h"
 #include "module.h"
+#include "hotkeys.h"
+#include "commandphase.h"
+#include "keysizes.h"
 
 #include <signal.h>
 #include <ctype.h>
@@ -99,8 +102,10 @@ void updateLFU(robj *val) {
  * expired on replicas even if the primary is lagging expiring our key via DELs
  * in the replication link. */
 robj *lookupKey(serverDb *db, robj *key, int flags) {
+    uint64_t phase_start = cmdPhaseStart();
     int dict_index = getKVStoreIndexForKey(key->ptr);
     robj *val = dbFindWithDictIndex(db, key->ptr, dict_index);
+    if (!(flags & LOOKUP_NOSTATS)) hotkeysTrackLookup(db->id, key);
     if (val) {
         /* Forcing deletion of expired keys on a replica makes the replica
          * inconsistent with the primary. We forbid it on readonly replicas, but
@@ -145,6 +150,7 @@ robj *lookupKey(serverDb *db, robj *key, int flags) {
         /* TODO: Use separate misses stats and notify event for WRITE */
     }
 
+    if (phase_start) cmdPhaseAddTime(CMD_PHASE_LOOKUP, phase_start);
     return val;
 }
 
@@ -194,6 +200,24 @@ robj *lookupKeyWriteOrReply(client *c, robj *key, robj *reply) {
     return o;
 }
 
+/* Prefetch the hashtable entries and values of several keys of the DB that
+ * are about to be looked up, so that the cache misses of the lookups overlap
+ * instead of being paid one key at a time. This has no side effects on the
+ * keys, the lookups themselves still have to be performed. */
+void dbPrefetchKeys(serverDb *db, robj **keys, int numkeys) {
+    hashtable *tables[PREFETCH_KEYS_MAX];
+    void *sds_keys[PREFETCH_KEYS_MAX];
+
+    for (int start = 0; numkeys - start >= 2; start += PREFETCH_KEYS_MAX) {
+        int count = min(numkeys - start, PREFETCH_KEYS_MAX);
+        for (int j = 0; j < count; j++) {
+            sds_keys[j] = keys[start + j]->ptr;
+            tables[j] = kvstoreGetHashtable(db->keys, getKVStoreIndexForKey(sds_keys[j]));
+        }
+        prefetchKeys(tables, sds_keys, count);
+    }
+}
+
 /* Add a key-value entry to the DB.
  *
  * A copy of 'key' is stored in the database. The caller must ensure the
@@ -228,6 +252,7 @@ static void dbAddInternal(serverDb *db, robj *key, robj **valref, int update_if_
     val = objectSetKeyAndExpire(val, key->ptr, -1);
     initObjectLRUOrLFU(val);
     kvstoreHashtableAdd(db->keys, dict_index, val);
+    keysizesUpdate(db, val->type, -1, keysizesObjectLength(val));
     signalKeyAsReady(db, key, val->type);
     notifyKeyspaceEvent(NOTIFY_NEW, "new", key, db->id);
     *valref = val;
@@ -293,6 +318,7 @@ int dbAddRDBLoad(serverDb *db, sds key, robj **valref) {
     val = objectSetKeyAndExpire(val, key, -1);
     kvstoreHashtableInsertAtPosition(db->keys, dict_index, val, &pos);
     initObjectLRUOrLFU(val);
+    keysizesUpdate(db, val->type, -1, keysizesObjectLength(val));
     *valref = val;
     return 1;
 }
@@ -345,6 +371,13 @@ static void dbSetValue(serverDb *db, robj *key, robj **valref, int overwrite, vo
         old = *oldref;
     }
 
+    if (old->type == val->type) {
+        keysizesUpdate(db, val->type, keysizesObjectLength(old), keysizesObjectLength(val));
+    } else {
+        keysizesUpdate(db, old->type, keysizesObjectLength(old), -1);
+        keysizesUpdate(db, val->type, -1, keysizesObjectLength(val));
+    }
+
     if ((old->refcount == 1 && old->encoding != OBJ_ENCODING_EMBSTR) &&
         (val->refcount == 1 && val->encoding != OBJ_ENCODING_EMBSTR)) {
         /* Keep old object in the database. Just swap it's ptr, type and
@@ -481,6 +514,7 @@ int dbGenericDeleteWithDictIndex(serverDb *db, robj *key, int async, int flags,
         decrRefCount(val);
         /* Because of dbUnshareStringValue, the val in de may change. */
         val = *ref;
+        keysizesUpdate(db, val->type, keysizesObjectLength(val), -1);
 
         /* Delete from keys and expires tables. This will not free the object.
          * (The expires table has no destructor callback.) */
@@ -590,6 +624,7 @@ long long emptyDbStructure(serverDb *dbarray, int dbnum, int async, void(callbac
             kvstoreEmpty(dbarray[j].keys, callback);
             kvstoreEmpty(dbarray[j].expires, callback);
         }
+        keysizesHistEmpty(dbarray[j].keysizes);
         /* Because all keys of database are removed, reset average ttl. */
         dbarray[j].avg_ttl = 0;
         dbarray[j].expires_cursor = 0;
@@ -663,6 +698,7 @@ serverDb *initTempDb(void) {
         tempDb[i].id = i;
         tempDb[i].keys = kvstoreCreate(&kvstoreKeysHashtableType, slot_count_bits, flags);
         tempDb[i].expires = kvstoreCreate(&kvstoreExpiresHashtableType, slot_count_bits, flags);
+        tempDb[i].keysizes = keysizesHistCreate();
     }
 
     return tempDb;
@@ -675,6 +711,7 @@ void discardTempDb(serverDb *tempDb) {
     for (int i = 0; i < server.dbnum; i++) {
         kvstoreRelease(tempDb[i].keys);
         kvstoreRelease(tempDb[i].expires);
+        keysizesHistRelease(tempDb[i].keysizes);
     }
 
     zfree(tempDb);
@@ -889,6 +926,19 @@ void keysCommand(client *c) {
     unsigned long numkeys = 0;
     void *replylen = addReplyDeferredLen(c);
     allkeys = (pattern[0] == '*' && plen == 1);
+    stringMatcher matcher;
+    stringMatcherInit(&matcher, pattern, plen, 0);
+    if (matcher.type == STRINGMATCH_EXACT) {
+        /* A pattern without any special character can only match the key
+         * with the same name, no need to iterate the keyspace. */
+        robj *val = dbFind(c->db, pattern);
+        if (val && !objectIsExpired(val)) {
+            addReplyBulkCBuffer(c, pattern, plen);
+            numkeys++;
+        }
+        setDeferredArrayLen(c, replylen, numkeys);
+        return;
+    }
     if (server.cluster_enabled && !allkeys) {
         pslot = patternHashSlot(pattern, plen);
     }
@@ -903,7 +953,7 @@ void keysCommand(client *c) {
     while (kvs_di ? kvstoreHashtableIteratorNext(kvs_di, &next) : kvstoreIteratorNext(kvs_it, &next)) {
         robj *val = next;
         sds key = objectGetKey(val);
-        if (allkeys || stringmatchlen(pattern, plen, key, sdslen(key), 0)) {
+        if (allkeys || stringMatcherMatch(&matcher, key, sdslen(key))) {
             if (!objectIsExpired(val)) {
                 addReplyBulkCBuffer(c, key, sdslen(key));
                 numkeys++;
@@ -918,13 +968,13 @@ void keysCommand(client *c) {
 
 /* Data used by the dict scan callback. */
 typedef struct {
-    list *keys;     /* elements that collect from dict */
-    robj *o;        /* o must be a hash/set/zset object, NULL means current db */
-    serverDb *db;   /* database currently being scanned */
-    long long type; /* the particular type when scan the db */
-    sds pattern;    /* pattern string, NULL means no pattern */
-    long sampled;   /* cumulative number of keys sampled */
-    int only_keys;  /* set to 1 means to return keys only */
+    list *keys;             /* elements that collect from dict */
+    robj *o;                /* o must be a hash/set/zset object, NULL means current db */
+    serverDb *db;           /* database currently being scanned */
+    long long type;         /* the particular type when scan the db */
+    stringMatcher *matcher; /* compiled pattern, NULL means no pattern */
+    long sampled;           /* cumulative number of keys sampled */
+    int only_keys;          /* set to 1 means to return keys only */
 } scanData;
 
 /* Helper function to compare key type in scan commands */
@@ -957,8 +1007,8 @@ void keysScanCallback(void *privdata, void *entry) {
     sds key = objectGetKey(obj);
 
     /* Filter object if its key does not match the pattern. */
-    if (data->pattern) {
-        if (!stringmatchlen(data->pattern, sdslen(data->pattern), key, sdslen(key), 0)) {
+    if (data->matcher) {
+        if (!stringMatcherMatch(data->matcher, key, sdslen(key))) {
             return;
         }
     }
@@ -1009,8 +1059,8 @@ void hashtableScanCallback(void *privdata, void *entry) {
     }
 
     /* Filter element if it does not match the pattern. */
-    if (data->pattern) {
-        if (!stringmatchlen(data->pattern, sdslen(data->pattern), key, sdslen(key), 0)) {
+    if (data->matcher) {
+        if (!stringMatcherMatch(data->matcher, key, sdslen(key))) {
             return;
         }
     }
@@ -1155,6 +1205,10 @@ void scanGenericCommand(client *c, robj *o, unsigned long long cursor) {
         }
     }
 
+    /* The pattern is compiled once and then matched against every element. */
+    stringMatcher matcher;
+    if (use_pattern) stringMatcherInit(&matcher, pat, patlen, 0);
+
     /* Step 2: Iterate the collection.
      *
      * Note that if the object is encoded with a listpack, intset, or any other
@@ -1203,7 +1257,7 @@ void scanGenericCommand(client *c, robj *o, unsigned long long cursor) {
          * it is possible to fetch more data in a type-dependent way;
          * 3. data.type: the specified type scan in the db, LLONG_MAX means
          * type matching is no needed;
-         * 4. data.pattern: the pattern string;
+         * 4. data.matcher: the compiled pattern;
          * 5. data.sampled: the maxiteration limit is there in case we're
          * working on an empty dict, one with a lot of empty buckets, and
          * for the buckets are not empty, we need to limit the spampled number
@@ -1215,7 +1269,7 @@ void scanGenericCommand(client *c, robj *o, unsigned long long cursor) {
             .db = c->db,
             .o = o,
             .type = type,
-            .pattern = use_pattern ? pat : NULL,
+            .matcher = use_pattern ? &matcher : NULL,
             .sampled = 0,
             .only_keys = only_keys,
         };
@@ -1225,15 +1279,23 @@ void scanGenericCommand(client *c, robj *o, unsigned long long cursor) {
         if (o == NULL && use_pattern && server.cluster_enabled) {
             onlydidx = patternHashSlot(pat, patlen);
         }
-        do {
-            /* In cluster mode there is a separate dictionary for each slot.
-             * If cursor is empty, we should try exploring next non-empty slot. */
-            if (o == NULL) {
-                cursor = kvstoreScan(c->db->keys, cursor, onlydidx, keysScanCallback, NULL, &data);
-            } else {
-                cursor = hashtableScan(ht, cursor, hashtableScanCallback, &data);
-            }
-        } while (cursor && maxiterations-- && data.sampled < count);
+        if (o == NULL && use_pattern && matcher.type == STRINGMATCH_EXACT) {
+            /* A pattern without any special character can match only one
+             * key, which is looked up directly and the iteration is complete. */
+            robj *val = dbFind(c->db, pat);
+            if (val) keysScanCallback(&data, val);
+            cursor = 0;
+        } else {
+            do {
+                /* In cluster mode there is a separate dictionary for each slot.
+                 * If cursor is empty, we should try exploring next non-empty slot. */
+                if (o == NULL) {
+                    cursor = kvstoreScan(c->db->keys, cursor, onlydidx, keysScanCallback, NULL, &data);
+                } else {
+                    cursor = hashtableScan(ht, cursor, hashtableScanCallback, &data);
+                }
+            } while (cursor && maxiterations-- && data.sampled < count);
+        }
     } else if (o->type == OBJ_SET) {
         char *str;
         char buf[LONG_STR_SIZE];
@@ -1245,7 +1307,7 @@ void scanGenericCommand(client *c, robj *o, unsigned long long cursor) {
                 len = ll2string(buf, sizeof(buf), llele);
             }
             char *key = str ? str : buf;
-            if (use_pattern && !stringmatchlen(pat, sdslen(pat), key, len, 0)) {
+            if (use_pattern && !stringMatcherMatch(&matcher, key, len)) {
                 continue;
             }
             listAddNodeTail(keys, sdsnewlen(key, len));
@@ -1262,7 +1324,7 @@ void scanGenericCommand(client *c, robj *o, unsigned long long cursor) {
             str = lpGet(p, &len, intbuf);
             /* point to the value */
             p = lpNext(o->ptr, p);
-            if (use_pattern && !stringmatchlen(pat, sdslen(pat), (char *)str, len, 0)) {
+            if (use_pattern && !stringMatcherMatch(&matcher, (char *)str, len)) {
                 /* jump to the next key/val pair */
                 p = lpNext(o->ptr, p);
                 continue;
@@ -1660,11 +1722,13 @@ int dbSwapDatabases(int id1, int id2) {
     db1->expires = db2->expires;
     db1->avg_ttl = db2->avg_ttl;
     db1->expires_cursor = db2->expires_cursor;
+    db1->keysizes = db2->keysizes;
 
     db2->keys = aux.keys;
     db2->expires = aux.expires;
     db2->avg_ttl = aux.avg_ttl;
     db2->expires_cursor = aux.expires_cursor;
+    db2->keysizes = aux.keysizes;
 
     /* Now we need to handle clients blocked on lists: as an effect
      * of swapping the two DBs, a client that was waiting for list
@@ -1702,11 +1766,13 @@ void swapMainDbWithTempDb(serverDb *tempDb) {
         activedb->expires = newdb->expires;
         activedb->avg_ttl = newdb->avg_ttl;
         activedb->expires_cursor = newdb->expires_cursor;
+        activedb->keysizes = newdb->keysizes;
 
         newdb->keys = aux.keys;
         newdb->expires = aux.expires;
         newdb->avg_ttl = aux.avg_ttl;
         newdb->expires_cursor = aux.expires_cursor;
+        newdb->keysizes = aux.keysizes;
 
         /* Now we need to handle clients blocked on lists: as an effect
          * of swapping the two DBs, a client that was waiting for list
@@ -1987,6 +2053,11 @@ static keyStatus expireIfNeededWithDictIndex(serverDb *db, robj *key, robj *val,
      * missing key without actually deleting it, even on primaries. */
     if (flags & EXPIRE_AVOID_DELETE_EXPIRED) return KEY_EXPIRED;
 
+    /* Commands served while a read-only script is busy run inside the script
+     * execution unit, deleting the key would change what the script observes.
+     * It is deleted by the active expire cycle or lazily once the script ends. */
+    if (server.busy_script_read) return KEY_EXPIRED;
+
     /* If 'expire' action is paused, for whatever reason, then don't expire any key.
      * Typically, at the end of the pause we will properly expire the key OR we
      * will have failed over and the new primary will send us the expire. */
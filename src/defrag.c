@@ -644,6 +644,8 @@ static void *defragStreamConsumerPendingEntry(raxIterator *ri, void *privdata) {
         void *prev;
         raxInsert(ctx->cg->pel, ri->key, ri->key_len, newnack, &prev);
         serverAssert(prev == nack);
+        /* and the delivery time index pointer to the nack */
+        streamIndexNACK(ctx->cg, ri->key, newnack);
     }
     return newnack;
 }
@@ -669,6 +671,7 @@ static void *defragStreamConsumerGroup(raxIterator *ri, void *privdata) {
     UNUSED(privdata);
     if (cg->consumers) defragRadixTree(&cg->consumers, 0, defragStreamConsumer, cg);
     if (cg->pel) defragRadixTree(&cg->pel, 0, NULL, NULL);
+    if (cg->pel_by_time) defragRadixTree(&cg->pel_by_time, 0, NULL, NULL);
     return NULL;
 }
 
@@ -0,0 +1,259 @@
+/* Hot keys tracking.
+ *
+ * A sample of the key lookups done by commands (one every
+ * 'hotkeys-sample-ratio' lookups) feeds two Space-Saving heavy hitters
+ * sketches: one counting accesses, and one counting the reply bytes produced
+ * by the commands that accessed the key. Each sketch tracks a fixed number of
+ * keys. When an untracked key is sampled and the sketch is full, it replaces
+ * the key with the smallest count and inherits that count as its error bound,
+ * so any key whose real share of the traffic is above 1/HOTKEYS_TRACKED_KEYS
+ * is guaranteed to be tracked.
+ *
+ * Counts are scaled by the sample ratio, so they are estimates of the real
+ * number of accesses and bytes since the last HOTKEYS RESET.
+ *
+ * The sketches are accessible thanks to the HOTKEYS command.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Copyright Valkey Contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#include "hotkeys.h"
+#include "cluster.h"
+
+typedef enum {
+    HOTKEYS_BY_ACCESSES = 0,
+    HOTKEYS_BY_BYTES,
+    HOTKEYS_BY_NUM
+} hotkeysBy;
+
+typedef struct hotkeyEntry {
+    sds key;
+    int dbid;
+    int slot;
+    unsigned long long value; /* Estimated accesses or reply bytes. */
+    unsigned long long error; /* Upper bound of the overestimation of 'value'. */
+} hotkeyEntry;
+
+typedef struct hotkeysSketch {
+    hotkeyEntry entries[HOTKEYS_TRACKED_KEYS];
+    int len;
+    dict *index; /* Tracked entries, so that we can find a key in O(1). */
+} hotkeysSketch;
+
+/* A key sampled by the command being executed, waiting for the command
+ * reply size. */
+typedef struct hotkeyPending {
+    sds key;
+    int dbid;
+    int slot;
+} hotkeyPending;
+
+static hotkeysSketch sketches[HOTKEYS_BY_NUM];
+static hotkeyPending pending[HOTKEYS_PENDING_KEYS];
+static mstime_t hotkeys_since;
+
+static uint64_t hotkeyEntryHash(const void *key) {
+    const hotkeyEntry *e = key;
+    return dictGenHashFunction(e->key, sdslen(e->key)) ^ (uint64_t)e->dbid;
+}
+
+static int hotkeyEntryCompare(const void *key1, const void *key2) {
+    const hotkeyEntry *e1 = key1, *e2 = key2;
+    return e1->dbid == e2->dbid && sdslen(e1->key) == sdslen(e2->key) &&
+           memcmp(e1->key, e2->key, sdslen(e1->key)) == 0;
+}
+
+/* Tracked entries are owned by the sketch array, the index only points to
+ * them. */
+static dictType hotkeyEntryDictType = {
+    hotkeyEntryHash,    /* hash function */
+    NULL,               /* key dup */
+    hotkeyEntryCompare, /* key compare */
+    NULL,               /* key destructor */
+    NULL,               /* val destructor */
+    NULL                /* allow to expand */
+};
+
+void hotkeysInit(void) {
+    for (int j = 0; j < HOTKEYS_BY_NUM; j++) {
+        sketches[j].len = 0;
+        sketches[j].index = dictCreate(&hotkeyEntryDictType);
+    }
+    hotkeys_since = mstime();
+}
+
+static void hotkeysReset(void) {
+    for (int j = 0; j < HOTKEYS_BY_NUM; j++) {
+        hotkeysSketch *sketch = &sketches[j];
+        for (int i = 0; i < sketch->len; i++) sdsfree(sketch->entries[i].key);
+        sketch->len = 0;
+        dictEmpty(sketch->index, NULL);
+    }
+    hotkeys_since = mstime();
+}
+
+/* Add 'weight' to the count of the key in the sketch, following the
+ * Space-Saving algorithm. */
+static void hotkeysSketchUpdate(hotkeysSketch *sketch, sds key, int dbid, int slot, unsigned long long weight) {
+    hotkeyEntry probe = {.key = key, .dbid = dbid};
+    dictEntry *de = dictFind(sketch->index, &probe);
+    if (de) {
+        hotkeyEntry *e = dictGetKey(de);
+        e->value += weight;
+        return;
+    }
+
+    hotkeyEntry *e;
+    unsigned long long error = 0;
+    if (sketch->len < HOTKEYS_TRACKED_KEYS) {
+        e = &sketch->entries[sketch->len++];
+    } else {
+        /* Evict the entry with the smallest count. The sketch is small and
+         * this only runs for sampled lookups of untracked keys, so a linear
+         * scan is cheaper than maintaining a heap on every update. */
+        e = &sketch->entries[0];
+        for (int i = 1; i < sketch->len; i++) {
+            if (sketch->entries[i].value < e->value) e = &sketch->entries[i];
+        }
+        error = e->value;
+        dictDelete(sketch->index, e);
+        sdsfree(e->key);
+    }
+    e->key = sdsdup(key);
+    e->dbid = dbid;
+    e->slot = slot;
+    e->value = error + weight;
+    e->error = error;
+    dictAdd(sketch->index, e, NULL);
+}
+
+/* Called for one every 'hotkeys-sample-ratio' key lookups. */
+void hotkeysSampleLookup(int dbid, robj *key) {
+    if (!sdsEncodedObject(key)) return;
+    sds name = key->ptr;
+    int slot = keyHashSlot(name, sdslen(name));
+    hotkeysSketchUpdate(&sketches[HOTKEYS_BY_ACCESSES], name, dbid, slot, server.hotkeys_sample_ratio);
+
+    /* Lookups done outside of a command proc have no reply to attribute: the
+     * ones of module timers, or of the post notification jobs that run once
+     * the command completed, would otherwise be charged the reply of the next
+     * command. */
+    client *c = server.executing_client;
+    if (!c || !c->flag.executing_command || server.hotkeys_pending_keys == HOTKEYS_PENDING_KEYS) return;
+    hotkeyPending *p = &pending[server.hotkeys_pending_keys++];
+    p->key = sdsdup(name);
+    p->dbid = dbid;
+    p->slot = slot;
+}
+
+/* Called after a command that sampled some of its key lookups has run,
+ * splitting the size of its reply among the sampled keys. */
+void hotkeysFlushPendingReplyBytes(long long reply_bytes) {
+    unsigned long long weight = 0;
+    if (reply_bytes > 0 && server.hotkeys_sample_ratio > 0)
+        weight = (unsigned long long)reply_bytes * server.hotkeys_sample_ratio / server.hotkeys_pending_keys;
+
+    for (int j = 0; j < server.hotkeys_pending_keys; j++) {
+        hotkeyPending *p = &pending[j];
+        if (weight) hotkeysSketchUpdate(&sketches[HOTKEYS_BY_BYTES], p->key, p->dbid, p->slot, weight);
+        sdsfree(p->key);
+        p->key = NULL;
+    }
+    server.hotkeys_pending_keys = 0;
+}
+
+static int hotkeyEntryCompareDesc(const void *a, const void *b) {
+    const hotkeyEntry *e1 = *(const hotkeyEntry **)a, *e2 = *(const hotkeyEntry **)b;
+    if (e1->value == e2->value) return 0;
+    return e1->value < e2->value ? 1 : -1;
+}
+
+static void hotkeysGetReply(client *c, hotkeysBy by, long count, int slot) {
+    hotkeysSketch *sketch = &sketches[by];
+    hotkeyEntry *sorted[HOTKEYS_TRACKED_KEYS];
+    int len = 0;
+
+    for (int j = 0; j < sketch->len; j++) {
+        if (slot != -1 && sketch->entries[j].slot != slot) continue;
+        sorted[len++] = &sketch->entries[j];
+    }
+    qsort(sorted, len, sizeof(hotkeyEntry *), hotkeyEntryCompareDesc);
+    if (count > len) count = len;
+
+    addReplyArrayLen(c, count);
+    for (long j = 0; j < count; j++) {
+        hotkeyEntry *e = sorted[j];
+        addReplyMapLen(c, 5);
+        addReplyBulkCString(c, "key");
+        addReplyBulkCBuffer(c, e->key, sdslen(e->key));
+        addReplyBulkCString(c, "db");
+        addReplyLongLong(c, e->dbid);
+        addReplyBulkCString(c, "slot");
+        addReplyLongLong(c, e->slot);
+        addReplyBulkCString(c, by == HOTKEYS_BY_ACCESSES ? "accesses" : "bytes");
+        addReplyLongLong(c, e->value);
+        addReplyBulkCString(c, "error");
+        addReplyLongLong(c, e->error);
+    }
+}
+
+/* The HOTKEYS command. Implements all the subcommands needed to inspect the
+ * hot keys sketches. */
+void hotkeysCommand(client *c) {
+    if (c->argc == 2 && !strcasecmp(c->argv[1]->ptr, "help")) {
+        const char *help[] = {
+            "GET [COUNT <count>] [BY ACCESSES|BYTES] [SLOT <slot>]",
+            "    Return the top <count> (default: 10) keys by estimated number of accesses",
+            "    (the default), or by estimated reply bytes, optionally only for <slot>.",
+            "    Entries are made of:",
+            "    key, db, slot, estimated accesses or bytes, maximum overestimation",
+            "RESET",
+            "    Reset the hot keys statistics.",
+            "SINCE",
+            "    Return the unix time in milliseconds of the last reset.",
+            NULL,
+        };
+        addReplyHelp(c, help);
+    } else if (c->argc == 2 && !strcasecmp(c->argv[1]->ptr, "reset")) {
+        hotkeysReset();
+        addReply(c, shared.ok);
+    } else if (c->argc == 2 && !strcasecmp(c->argv[1]->ptr, "since")) {
+        addReplyLongLong(c, hotkeys_since);
+    } else if (c->argc >= 2 && !strcasecmp(c->argv[1]->ptr, "get")) {
+        long count = 10, slot = -1;
+        hotkeysBy by = HOTKEYS_BY_ACCESSES;
+
+        for (int j = 2; j < c->argc; j++) {
+            int moreargs = j + 1 < c->argc;
+            if (!strcasecmp(c->argv[j]->ptr, "count") && moreargs) {
+                if (getRangeLongFromObjectOrReply(c, c->argv[++j], 0, LONG_MAX, &count,
+                                                  "count should be greater than or equal to 0") != C_OK)
+                    return;
+            } else if (!strcasecmp(c->argv[j]->ptr, "by") && moreargs) {
+                j++;
+                if (!strcasecmp(c->argv[j]->ptr, "accesses")) {
+                    by = HOTKEYS_BY_ACCESSES;
+                } else if (!strcasecmp(c->argv[j]->ptr, "bytes")) {
+                    by = HOTKEYS_BY_BYTES;
+                } else {
+                    addReplyError(c, "BY should be one of the following: accesses, bytes");
+                    return;
+                }
+            } else if (!strcasecmp(c->argv[j]->ptr, "slot") && moreargs) {
+                if (getRangeLongFromObjectOrReply(c, c->argv[++j], 0, CLUSTER_SLOTS - 1, &slot,
+                                                  "Invalid or out of range slot") != C_OK)
+                    return;
+            } else {
+                addReplyErrorObject(c, shared.syntaxerr);
+                return;
+            }
+        }
+        hotkeysGetReply(c, by, count, slot);
+    } else {
+        addReplySubcommandSyntaxError(c);
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright Valkey Contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#ifndef __HOTKEYS_H__
+#define __HOTKEYS_H__
+
+#include "server.h"
+
+/* Number of keys each hot keys sketch can track. */
+#define HOTKEYS_TRACKED_KEYS 128
+/* Maximum number of sampled keys a single command can attribute its reply
+ * bytes to. */
+#define HOTKEYS_PENDING_KEYS 8
+
+/* Exported API */
+void hotkeysInit(void);
+void hotkeysSampleLookup(int dbid, robj *key);
+void hotkeysFlushPendingReplyBytes(long long reply_bytes);
+
+/* Sampling a key lookup is done inline so that the common, non sampled, case
+ * costs a single branch. */
+static inline void hotkeysTrackLookup(int dbid, robj *key) {
+    if (server.hotkeys_sample_ratio == 0) return;
+    if (++server.hotkeys_lookups_since_sample < (unsigned long long)server.hotkeys_sample_ratio) return;
+    server.hotkeys_lookups_since_sample = 0;
+    hotkeysSampleLookup(dbid, key);
+}
+
+#endif /* __HOTKEYS_H__ */
@@ -30,6 +30,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 #include "intrinsics.h"
 
 #include <stdint.h>
@@ -1449,14 +1450,20 @@ void pfaddCommand(client *c) {
         if (isHLLObjectOrReply(c, o) != C_OK) return;
         o = dbUnshareStringValue(c->db, c->argv[1], o);
     }
-    /* Perform the low level ADD operation for every element. */
+    /* Perform the low level ADD operation for every element. Adding to a
+     * sparse HLL may grow it or convert it to the dense representation. */
+    size_t oldlen = sdslen(o->ptr);
     for (j = 2; j < c->argc; j++) {
         int retval = hllAdd(o, (unsigned char *)c->argv[j]->ptr, sdslen(c->argv[j]->ptr));
         switch (retval) {
         case 1: updated++; break;
-        case -1: addReplyError(c, invalid_hll_err); return;
+        case -1:
+            keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
+            addReplyError(c, invalid_hll_err);
+            return;
         }
     }
+    keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
     hdr = o->ptr;
     if (updated) {
         HLL_INVALIDATE_CACHE(hdr);
@@ -1607,6 +1614,7 @@ void pfmergeCommand(client *c) {
          * don't check again. */
         o = dbUnshareStringValue(c->db, c->argv[1], o);
     }
+    size_t oldlen = sdslen(o->ptr);
 
     /* Convert the destination object to dense representation if at least
      * one of the inputs was dense. */
@@ -1633,6 +1641,7 @@ void pfmergeCommand(client *c) {
     hdr = o->ptr; /* o->ptr may be different now, as a side effect of
                      last hllSparseSet() call. */
     HLL_INVALIDATE_CACHE(hdr);
+    keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
 
     signalModifiedKey(c, c->db, c->argv[1]);
     /* We generate a PFADD event for PFMERGE for semantical simplicity
@@ -1793,6 +1802,7 @@ void pfdebugCommand(client *c) {
     if (isHLLObjectOrReply(c, o) != C_OK) return;
     o = dbUnshareStringValue(c->db, c->argv[2], o);
     hdr = o->ptr;
+    size_t oldlen = sdslen(o->ptr);
 
     /* PFDEBUG GETREG <key> */
     if (!strcasecmp(cmd, "getreg")) {
@@ -1803,6 +1813,7 @@ void pfdebugCommand(client *c) {
                 addReplyError(c, invalid_hll_err);
                 return;
             }
+            keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
             server.dirty++; /* Force propagation on encoding change. */
         }
 
@@ -1868,6 +1879,7 @@ void pfdebugCommand(client *c) {
                 addReplyError(c, invalid_hll_err);
                 return;
             }
+            keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
             conv = 1;
             server.dirty++; /* Force propagation on encoding change. */
         }
@@ -134,6 +134,8 @@ int getIOThreadID(void) {
     return thread_id;
 }
 
+static void drainTLSHandshakeQueues(void);
+
 /* Drains the I/O threads queue by waiting for all jobs to be processed.
  * This function must be called from the main thread. */
 void drainIOThreadsQueue(void) {
@@ -144,6 +146,7 @@ void drainIOThreadsQueue(void) {
             atomic_thread_fence(memory_order_acquire);
         }
     }
+    drainTLSHandshakeQueues();
 }
 
 /* Wait until the IO-thread is done with the client */
@@ -291,10 +294,201 @@ static void shutdownIOThread(int id) {
     IOJobQueue_cleanup(&io_jobs[id]);
 }
 
+static void killTLSHandshakeThreads(void);
+
 void killIOThreads(void) {
     for (int j = 1; j < server.io_threads_num; j++) { /* We don't kill thread 0, which is the main thread. */
         shutdownIOThread(j);
     }
+    killTLSHandshakeThreads();
+}
+
+/* TLS handshake threads.
+ *
+ * The TLS accept handshakes are expensive (asymmetric crypto), so during a
+ * reconnection storm, handshakes done by the IO threads delay the reads and
+ * writes of the already connected clients. When tls-handshake-threads is set,
+ * the handshakes are done by a separate pool of threads instead. They use the
+ * same job queues as the IO threads. The main thread collects the handshake
+ * results with the other offloaded accepts, and the established connections
+ * are then served by the IO threads as usual. All the handshake threads share
+ * the server SSL_CTX, and so its session cache and session ticket keys.
+ *
+ * Unlike the IO threads, a handshake thread that has no jobs goes to sleep on
+ * a condition variable, and the main thread wakes it up when it pushes a job. */
+#define TLS_HANDSHAKE_SPIN_ITERATIONS 10000
+
+typedef struct tlsHandshakeJob {
+    client *c;
+    monotime queued_time;
+} tlsHandshakeJob;
+
+typedef struct tlsHandshakeThread {
+    pthread_t tid;
+    IOJobQueue jq;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    _Atomic int sleeping;
+    _Atomic long long jobs_processed;
+    _Atomic long long total_latency; /* Time from the queueing to the end of the jobs, in microseconds. */
+} tlsHandshakeThread;
+
+static tlsHandshakeThread *tls_handshake_threads = NULL;
+
+/* Number of jobs in the queue, not including the one being processed. Called
+ * by the main thread. */
+static size_t IOJobQueue_length(const IOJobQueue *jq) {
+    size_t current_head = atomic_load_explicit(&jq->head, memory_order_relaxed);
+    size_t current_tail = atomic_load_explicit(&jq->tail, memory_order_relaxed);
+    return current_head >= current_tail ? current_head - current_tail : jq->size - (current_tail - current_head);
+}
+
+static void tlsHandshakeThreadAccept(void *data) {
+    tlsHandshakeJob *job = data;
+    client *c = job->c;
+    tlsHandshakeThread *t = &tls_handshake_threads[thread_id - IO_THREADS_MAX_NUM];
+    monotime queued_time = job->queued_time;
+    zfree(job);
+
+    connAccept(c->conn, NULL);
+    atomic_fetch_add_explicit(&t->total_latency, getMonotonicUs() - queued_time, memory_order_relaxed);
+    atomic_fetch_add_explicit(&t->jobs_processed, 1, memory_order_relaxed);
+    c->io_read_state = CLIENT_COMPLETED_IO;
+}
+
+static void *tlsHandshakeThreadMain(void *myid) {
+    long id = (long)myid;
+    char thdname[32];
+
+    snprintf(thdname, sizeof(thdname), "tls_hs_%ld", id);
+    valkey_set_thread_title(thdname);
+    serverSetCpuAffinity(server.server_cpulist);
+    makeThreadKillable();
+
+    /* The handshake threads are not IO threads, but they must not be seen as
+     * the main thread either. */
+    thread_id = IO_THREADS_MAX_NUM + (int)id;
+    tlsHandshakeThread *t = &tls_handshake_threads[id];
+    IOJobQueue *jq = &t->jq;
+    while (1) {
+        size_t jobs_to_process = 0;
+        for (int j = 0; j < TLS_HANDSHAKE_SPIN_ITERATIONS; j++) {
+            jobs_to_process = IOJobQueue_availableJobs(jq);
+            if (jobs_to_process) break;
+        }
+
+        if (jobs_to_process == 0) {
+            /* Announce we're going to sleep before checking the queue one last
+             * time. Paired with the fence in trySendAcceptToTLSHandshakeThreads(),
+             * either we see the new job or the main thread sees we're sleeping. */
+            pthread_mutex_lock(&t->mutex);
+            atomic_store_explicit(&t->sleeping, 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            while (IOJobQueue_availableJobs(jq) == 0) pthread_cond_wait(&t->cond, &t->mutex);
+            atomic_store_explicit(&t->sleeping, 0, memory_order_relaxed);
+            pthread_mutex_unlock(&t->mutex);
+            continue;
+        }
+
+        for (size_t j = 0; j < jobs_to_process; j++) {
+            job_handler handler;
+            void *data;
+            IOJobQueue_peek(jq, &handler, &data);
+            handler(data);
+            IOJobQueue_removeJob(jq);
+        }
+        atomic_thread_fence(memory_order_release);
+    }
+    return NULL;
+}
+
+static void initTLSHandshakeThreads(void) {
+    if (server.tls_handshake_threads_num == 0) return;
+
+    tls_handshake_threads = zcalloc(sizeof(tlsHandshakeThread) * server.tls_handshake_threads_num);
+    for (int i = 0; i < server.tls_handshake_threads_num; i++) {
+        tlsHandshakeThread *t = &tls_handshake_threads[i];
+        pthread_mutex_init(&t->mutex, NULL);
+        pthread_cond_init(&t->cond, NULL);
+        IOJobQueue_init(&t->jq, IO_JOB_QUEUE_SIZE);
+        if (pthread_create(&t->tid, NULL, tlsHandshakeThreadMain, (void *)(long)i) != 0) {
+            serverLog(LL_WARNING, "Fatal: Can't initialize TLS handshake thread, pthread_create failed with: %s",
+                      strerror(errno));
+            exit(1);
+        }
+    }
+}
+
+static void killTLSHandshakeThreads(void) {
+    for (int i = 0; i < server.tls_handshake_threads_num && tls_handshake_threads; i++) {
+        int err;
+        pthread_t tid = tls_handshake_threads[i].tid;
+        if (tid == 0 || tid == pthread_self()) continue;
+
+        pthread_cancel(tid);
+        if ((err = pthread_join(tid, NULL)) != 0) {
+            serverLog(LL_WARNING, "TLS handshake thread(tid:%lu) can not be joined: %s", (unsigned long)tid,
+                      strerror(err));
+        } else {
+            serverLog(LL_NOTICE, "TLS handshake thread(tid:%lu) terminated", (unsigned long)tid);
+        }
+    }
+}
+
+static void drainTLSHandshakeQueues(void) {
+    for (int i = 0; i < server.tls_handshake_threads_num && tls_handshake_threads; i++) {
+        while (!IOJobQueue_isEmpty(&tls_handshake_threads[i].jq)) {
+            atomic_thread_fence(memory_order_acquire);
+        }
+    }
+}
+
+/* Attempts to offload the accept of the client's connection to one of the TLS
+ * handshake threads. Returns C_ERR if there are no handshake threads or the
+ * selected thread's queue is full, in which case the caller falls back to the
+ * IO threads. */
+static int trySendAcceptToTLSHandshakeThreads(client *c) {
+    if (server.tls_handshake_threads_num == 0) return C_ERR;
+    if (strcmp(connGetType(c->conn), CONN_TYPE_TLS) != 0) return C_ERR;
+
+    tlsHandshakeThread *t = &tls_handshake_threads[c->id % server.tls_handshake_threads_num];
+    if (IOJobQueue_isFull(&t->jq)) return C_ERR;
+
+    tlsHandshakeJob *job = zmalloc(sizeof(*job));
+    job->c = c;
+    job->queued_time = getMonotonicUs();
+
+    c->io_read_state = CLIENT_PENDING_IO;
+    c->flag.pending_read = 1;
+    listLinkNodeTail(server.clients_pending_io_read, &c->pending_read_list_node);
+    connSetPostponeUpdateState(c->conn, 1);
+    IOJobQueue_push(&t->jq, tlsHandshakeThreadAccept, job);
+
+    /* Wake up the thread if it's sleeping, see tlsHandshakeThreadMain(). */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&t->sleeping, memory_order_relaxed)) {
+        pthread_mutex_lock(&t->mutex);
+        pthread_cond_signal(&t->cond);
+        pthread_mutex_unlock(&t->mutex);
+    }
+    return C_OK;
+}
+
+/* Fills the TLS handshake threads metrics reported by INFO: the number of jobs
+ * waiting in the queues, the number of jobs processed (a handshake needing
+ * several round trips takes several jobs) and their average latency, from the
+ * time they were queued until they were processed, in microseconds. */
+void getTLSHandshakeThreadsStats(size_t *queue_depth, long long *jobs_processed, long long *avg_latency) {
+    long long total_latency = 0;
+    *queue_depth = 0;
+    *jobs_processed = 0;
+    for (int i = 0; i < server.tls_handshake_threads_num && tls_handshake_threads; i++) {
+        tlsHandshakeThread *t = &tls_handshake_threads[i];
+        *queue_depth += IOJobQueue_length(&t->jq);
+        *jobs_processed += atomic_load_explicit(&t->jobs_processed, memory_order_relaxed);
+        total_latency += atomic_load_explicit(&t->total_latency, memory_order_relaxed);
+    }
+    *avg_latency = *jobs_processed ? total_latency / *jobs_processed : 0;
 }
 
 /* Initialize the data structures needed for I/O threads. */
@@ -303,6 +497,9 @@ void initIOThreads(void) {
     server.io_poll_state = AE_IO_STATE_NONE;
     server.io_ae_fired_events = 0;
 
+    /* The TLS handshake threads don't depend on the IO threads. */
+    initTLSHandshakeThreads();
+
     /* Don't spawn any thread if the user selected a single thread:
      * we'll handle I/O directly from the main thread. */
     if (server.io_threads_num == 1) return;
@@ -421,6 +618,225 @@ int trySendWriteToIOThreads(client *c) {
     return C_OK;
 }
 
+/* Pub/Sub fan-out.
+ *
+ * When a message is published to many subscribers, the main thread doesn't
+ * encode and append it to every output buffer: it only queues a reference to
+ * the encoded message in the client push queue. Right after the command (or
+ * before sleeping) the queues are handed to the I/O threads, in batches, and
+ * every I/O thread appends the messages of its clients to their output buffers
+ * and writes them, in parallel.
+ *
+ * While an I/O thread owns a client, new messages are queued for the next
+ * round, and before the main thread adds any other reply to a client with
+ * queued messages it appends them itself (see flushClientPushes()), so the
+ * client gets its replies in order. */
+#define IO_PUSH_MIN_RECEIVERS 8
+#define IO_PUSH_BATCH_SIZE 64
+
+/* The clients handed to an I/O thread are grouped in batches, pushed as a
+ * single job, so that a big fan-out doesn't fill the job queues. */
+typedef struct IOPushBatch {
+    int count;
+    client *clients[IO_PUSH_BATCH_SIZE];
+} IOPushBatch;
+
+static list queued_pushes;                                   /* clientPushQueue nodes, in queuing order. */
+static IOPushBatch *io_push_batches[IO_THREADS_MAX_NUM] = {0}; /* Batches of clients to append and write. */
+
+/* Returns 1 if the messages of a publish to 'receivers' clients should be
+ * queued for the I/O threads with tryQueuePushToIOThreads(). */
+int shouldFanoutPushesToIOThreads(unsigned long receivers) {
+    if (server.io_threads_num == 1 || receivers < IO_PUSH_MIN_RECEIVERS) return 0;
+#ifdef LOG_REQ_RES
+    /* The replies are logged with the offsets of the command reply. */
+    if (server.req_res_logfile) return 0;
+#endif
+    return 1;
+}
+
+/* Returns the number of clients with messages queued for the I/O threads. */
+unsigned long queuedPushesCount(void) {
+    return listLength(&queued_pushes);
+}
+
+/* Queues the Pub/Sub message 'payload' for the I/O thread of the client to
+ * append. Returns C_ERR if the client is not eligible, in which case the caller
+ * should add the message to the client like any other reply. */
+int tryQueuePushToIOThreads(client *c, sharedReplyPayload *payload) {
+    /* Pushes to the current client may need to be postponed after the command
+     * reply, see _addReplyToBufferOrList(). */
+    if (c == server.current_client) return C_ERR;
+    if (!c->conn || c->flag.fake || c->flag.primary || c->flag.lua_debug) return C_ERR;
+    if (c->flag.close_asap || c->flag.close_after_reply || c->reply_sink) return C_ERR;
+    if (getClientType(c) == CLIENT_TYPE_REPLICA) return C_ERR;
+
+    clientPushQueue *q = c->push_queue;
+    if (!q) {
+        q = zmalloc(sizeof(*q));
+        q->client = c;
+        q->queued_bytes = 0;
+        q->reply_bytes = 0;
+        q->count = 0;
+        q->size = sizeof(q->inline_payloads) / sizeof(q->inline_payloads[0]);
+        q->payloads = q->inline_payloads;
+        listInitNode(&q->node, q);
+        listLinkNodeTail(&queued_pushes, &q->node);
+        c->push_queue = q;
+    } else if (q->count == q->size) {
+        q->size *= 2;
+        if (q->payloads == q->inline_payloads) {
+            q->payloads = zmalloc(sizeof(sharedReplyPayload *) * q->size);
+            memcpy(q->payloads, q->inline_payloads, sizeof(q->inline_payloads));
+        } else {
+            q->payloads = zrealloc(q->payloads, sizeof(sharedReplyPayload *) * q->size);
+        }
+    }
+    payload->refcount++;
+    q->payloads[q->count++] = payload;
+    q->queued_bytes += payload->len;
+    /* Accounted like if it was added to the output buffer right now. */
+    c->net_output_bytes_curr_cmd += payload->len;
+    /* The queued bytes count toward the output buffer limits. A client owned
+     * by an I/O thread is checked when the I/O thread is done with it. */
+    if (c->io_write_state == CLIENT_IDLE && c->io_read_state == CLIENT_IDLE) closeClientOnOutputBufferLimitReached(c, 1);
+    return C_OK;
+}
+
+static void freeClientPushQueue(clientPushQueue *q) {
+    for (int j = 0; j < q->count; j++) {
+        if (q->payloads[j]) releaseSharedReplyPayload(q->payloads[j]);
+    }
+    if (q->payloads != q->inline_payloads) zfree(q->payloads);
+    zfree(q);
+}
+
+/* Runs in the I/O thread. Each client is marked as completed as soon as it is
+ * written, after that point the main thread owns it again and we must not
+ * touch it anymore. */
+static void ioThreadAppendPushesBatch(void *data) {
+    IOPushBatch *batch = data;
+    for (int j = 0; j < batch->count; j++) {
+        ioThreadAppendPushes(batch->clients[j]);
+        ioThreadWriteToClient(batch->clients[j]);
+    }
+    zfree(batch);
+}
+
+static void pushIOPushesBatch(size_t tid) {
+    IOPushBatch *batch = io_push_batches[tid];
+    if (!batch) return;
+    io_push_batches[tid] = NULL;
+    IOJobQueue_push(&io_jobs[tid], ioThreadAppendPushesBatch, batch);
+}
+
+/* Hands the push queue of the client to its I/O thread, which appends the
+ * messages and writes the output buffer. Returns C_ERR if it can't. */
+static int trySendPushesToIOThreads(client *c) {
+    if (server.active_io_threads_num <= 1) return C_ERR;
+    if (c->flag.close_asap || c->flag.protected) return C_ERR;
+
+    size_t tid = (c->id % (server.active_io_threads_num - 1)) + 1;
+    /* Keep the client on the thread of its pending read, see trySendWriteToIOThreads(). */
+    if (c->io_read_state == CLIENT_PENDING_IO && c->cur_tid != (uint8_t)tid) tid = c->cur_tid;
+    /* The job queue slot of a batch is checked for when the batch is created:
+     * only the main thread pushes jobs, and nothing else is pushed before
+     * sendQueuedPushesToIOThreads() pushes the batches. */
+    if (!io_push_batches[tid] && IOJobQueue_isFull(&io_jobs[tid])) return C_ERR;
+
+    c->cur_tid = tid;
+    if (c->flag.pending_write) {
+        listUnlinkNode(server.clients_pending_write, &c->clients_pending_write_node);
+    } else {
+        c->flag.pending_write = 1;
+    }
+    serverAssert(c->clients_pending_write_node.prev == NULL && c->clients_pending_write_node.next == NULL);
+    listLinkNodeTail(server.clients_pending_io_write, &c->clients_pending_write_node);
+
+    listUnlinkNode(&queued_pushes, &c->push_queue->node);
+    c->io_push_queue = c->push_queue;
+    c->push_queue = NULL;
+
+    /* The I/O thread sets io_last_reply_block and io_last_bufpos once it
+     * appended the messages. */
+    connSetPostponeUpdateState(c->conn, 1);
+    c->write_flags = 0;
+    c->io_write_state = CLIENT_PENDING_IO;
+
+    IOPushBatch *batch = io_push_batches[tid];
+    if (!batch) {
+        batch = zmalloc(sizeof(*batch));
+        batch->count = 0;
+        io_push_batches[tid] = batch;
+    }
+    batch->clients[batch->count++] = c;
+    if (batch->count == IO_PUSH_BATCH_SIZE) pushIOPushesBatch(tid);
+    return C_OK;
+}
+
+/* Appends the queued messages of the client from the main thread. */
+static void addClientQueuedPushes(client *c) {
+    clientPushQueue *q = c->push_queue;
+    listUnlinkNode(&queued_pushes, &q->node);
+    c->push_queue = NULL;
+    addReplyPushQueue(c, q);
+    freeClientPushQueue(q);
+}
+
+/* Sends the clients with queued messages to the I/O threads. Clients the I/O
+ * threads are still busy with stay queued, the messages are sent when they
+ * are done, and the messages of the clients that can't be sent are appended
+ * by the main thread. */
+void sendQueuedPushesToIOThreads(void) {
+    if (listLength(&queued_pushes) == 0) return;
+
+    listNode *ln, *next = listFirst(&queued_pushes);
+    while ((ln = next)) {
+        next = listNextNode(ln);
+        clientPushQueue *q = listNodeValue(ln);
+        client *c = q->client;
+        if (c->io_write_state != CLIENT_IDLE) continue;
+        if (trySendPushesToIOThreads(c) == C_ERR) addClientQueuedPushes(c);
+    }
+    for (int tid = 1; tid < server.io_threads_num; tid++) pushIOPushesBatch(tid);
+}
+
+/* Called by the main thread before adding a reply to a client with messages
+ * queued for, or being appended by, an I/O thread: waits for the I/O thread
+ * and appends the queued messages first, so they precede the reply. */
+void flushClientPushes(client *c) {
+    if (c->io_push_queue) {
+        waitForClientIO(c);
+        processClientIOPushesDone(c);
+    }
+    if (c->push_queue) addClientQueuedPushes(c);
+}
+
+/* Called by the main thread once the I/O thread appended the messages of the
+ * client push queue: accounts the client for them and releases the queue. */
+void processClientIOPushesDone(client *c) {
+    clientPushQueue *q = c->io_push_queue;
+    if (!q) return;
+    c->io_push_queue = NULL;
+    c->reply_bytes += q->reply_bytes;
+    server.stat_io_pubsub_messages += q->count;
+    freeClientPushQueue(q);
+    closeClientOnOutputBufferLimitReached(c, 1);
+}
+
+/* Releases the push queues of a client being freed, once its I/O is done. */
+void freeClientPushQueues(client *c) {
+    if (c->io_push_queue) {
+        freeClientPushQueue(c->io_push_queue);
+        c->io_push_queue = NULL;
+    }
+    if (c->push_queue) {
+        listUnlinkNode(&queued_pushes, &c->push_queue->node);
+        freeClientPushQueue(c->push_queue);
+        c->push_queue = NULL;
+    }
+}
+
 /* Internal function to free the client's argv in an IO thread. */
 void IOThreadFreeArgv(void *data) {
     robj **argv = (robj **)data;
@@ -589,7 +1005,7 @@ static void ioThreadAccept(void *data) {
  *   conn - The connection object to perform the accept operation on
  */
 int trySendAcceptToIOThreads(connection *conn) {
-    if (server.io_threads_num <= 1) {
+    if (server.io_threads_num <= 1 && server.tls_handshake_threads_num == 0) {
         return C_ERR;
     }
 
@@ -602,6 +1018,12 @@ int trySendAcceptToIOThreads(connection *conn) {
         return C_OK;
     }
 
+    /* Prefer the dedicated handshake threads, so that the handshakes crypto
+     * doesn't delay the IO of the already connected clients. They are used
+     * even when the IO threads are not active, which is when the main thread
+     * would otherwise do the handshakes itself. */
+    if (trySendAcceptToTLSHandshakeThreads(c) == C_OK) return C_OK;
+
     if (server.active_io_threads_num <= 1) {
         return C_ERR;
     }
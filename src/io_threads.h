@@ -8,11 +8,19 @@ void killIOThreads(void);
 int inMainThread(void);
 int trySendReadToIOThreads(client *c);
 int trySendWriteToIOThreads(client *c);
+int shouldFanoutPushesToIOThreads(unsigned long receivers);
+unsigned long queuedPushesCount(void);
+int tryQueuePushToIOThreads(client *c, sharedReplyPayload *payload);
+void sendQueuedPushesToIOThreads(void);
+void flushClientPushes(client *c);
+void processClientIOPushesDone(client *c);
+void freeClientPushQueues(client *c);
 int tryOffloadFreeObjToIOThreads(robj *o);
 int tryOffloadFreeArgvToIOThreads(client *c, int argc, robj **argv);
 void adjustIOThreadsByEventLoad(int numevents, int increase_only);
 void drainIOThreadsQueue(void);
 void trySendPollJobToIOThreads(void);
 int trySendAcceptToIOThreads(connection *conn);
+void getTLSHandshakeThreadsStats(size_t *queue_depth, long long *jobs_processed, long long *avg_latency);
 
 #endif /* IO_THREADS_H */
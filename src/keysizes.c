@@ -0,0 +1,245 @@
+/* Key sizes tracking.
+ *
+ * Finding the big keys of a dataset from the outside means scanning the whole
+ * keyspace and calling MEMORY USAGE for every key. Instead the server keeps:
+ *
+ * - Per type histograms of the number of elements of the keys (their length
+ *   in bytes for strings), with power of two buckets. They are maintained
+ *   online: every command that adds or deletes a key, or changes its length,
+ *   moves the key from the bucket of its old length to the one of its new
+ *   length with keysizesUpdate(). No state is kept per key.
+ *
+ * - Per type histograms of the memory usage of the keys, and the largest keys
+ *   by memory usage. The memory usage of a key can't be tracked cheaply on
+ *   every write, so when 'keysizes-scan-cpu-percent' is not zero the server
+ *   walks its own keyspace incrementally from serverCron, using at most that
+ *   percentage of the CPU time, and estimates it like MEMORY USAGE does with
+ *   the default number of samples. When a pass completes its results replace
+ *   the ones of the previous pass.
+ *
+ * MEMORY KEYSIZES returns both instantly.
+ *
+ * ----------------------------------------------------------------------------
+ *
+ * Copyright Valkey Contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#include "keysizes.h"
+
+typedef struct keysizesBigKey {
+    sds key;
+    int dbid;
+    int type;
+    unsigned long long elements;
+    unsigned long long bytes;
+} keysizesBigKey;
+
+typedef struct keysizesStats {
+    unsigned long long bytes[OBJ_TYPE_MAX][KEYSIZES_BUCKETS];
+    keysizesBigKey biggest[KEYSIZES_BIGGEST_KEYS];
+    int biggest_len;
+} keysizesStats;
+
+/* The pass in progress, and the last completed one. */
+static keysizesStats current, last;
+
+static struct {
+    int in_progress;
+    int dbid;
+    unsigned long long cursor;
+    mstime_t start_time;
+    long long passes;             /* Number of completed passes. */
+    mstime_t last_end_time;       /* Unix time in ms at the end of the last pass. */
+    mstime_t last_duration;       /* Duration in ms of the last pass. */
+} keysizes_scan;
+
+static const char *keysizesTypeName[OBJ_TYPE_MAX] = {"string", "list", "set", "zset", "hash", "module", "stream"};
+
+static unsigned long long keysizesBucketLowerBound(int bucket) {
+    return bucket ? 1ULL << (bucket - 1) : 0;
+}
+
+keysizesHist *keysizesHistCreate(void) {
+    return zcalloc(sizeof(keysizesHist));
+}
+
+void keysizesHistRelease(keysizesHist *hist) {
+    zfree(hist);
+}
+
+/* Called when all the keys of a database are removed. */
+void keysizesHistEmpty(keysizesHist *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+/* The length a key is counted with in the histograms. */
+long long keysizesObjectLength(robj *o) {
+    switch (o->type) {
+    case OBJ_STRING: return stringObjectLen(o);
+    case OBJ_LIST: return listTypeLength(o);
+    case OBJ_SET: return setTypeSize(o);
+    case OBJ_ZSET: return zsetLength(o);
+    case OBJ_HASH: return hashTypeLength(o);
+    case OBJ_STREAM: return streamLength(o);
+    default: return 0;
+    }
+}
+
+static void keysizesTrackBiggest(keysizesStats *stats, robj *val, int dbid, unsigned long long elements,
+                                 unsigned long long bytes) {
+    keysizesBigKey *k;
+    if (stats->biggest_len < KEYSIZES_BIGGEST_KEYS) {
+        k = &stats->biggest[stats->biggest_len++];
+    } else {
+        /* Replace the smallest of the biggest keys, if this one is bigger. */
+        k = &stats->biggest[0];
+        for (int j = 1; j < stats->biggest_len; j++) {
+            if (stats->biggest[j].bytes < k->bytes) k = &stats->biggest[j];
+        }
+        if (k->bytes >= bytes) return;
+        sdsfree(k->key);
+    }
+    k->key = sdsdup(objectGetKey(val));
+    k->dbid = dbid;
+    k->type = val->type;
+    k->elements = elements;
+    k->bytes = bytes;
+}
+
+static void keysizesScanCallback(void *privdata, void *entry) {
+    serverDb *db = privdata;
+    robj *val = entry;
+    robj keyobj;
+    initStaticStringObject(keyobj, objectGetKey(val));
+
+    unsigned long long elements = keysizesObjectLength(val);
+    unsigned long long bytes = objectComputeSize(&keyobj, val, OBJ_COMPUTE_SIZE_DEF_SAMPLES, db->id);
+    current.bytes[val->type][keysizesBucket((long long)bytes)]++;
+    keysizesTrackBiggest(&current, val, db->id, elements, bytes);
+}
+
+static void keysizesResetStats(keysizesStats *stats) {
+    for (int j = 0; j < stats->biggest_len; j++) sdsfree(stats->biggest[j].key);
+    memset(stats, 0, sizeof(*stats));
+}
+
+static void keysizesEndPass(void) {
+    keysizesResetStats(&last);
+    /* The keys of the biggest entries are moved to 'last'. */
+    last = current;
+    memset(&current, 0, sizeof(current));
+
+    keysizes_scan.in_progress = 0;
+    keysizes_scan.passes++;
+    keysizes_scan.last_end_time = mstime();
+    keysizes_scan.last_duration = keysizes_scan.last_end_time - keysizes_scan.start_time;
+}
+
+/* Called by databasesCron(), scans the keyspace for at most
+ * 'keysizes-scan-cpu-percent' of the time between two calls. A new pass is
+ * started at most once per call, so that small datasets are not scanned in a
+ * loop. */
+void keysizesCron(void) {
+    if (server.keysizes_scan_cpu_percent == 0 || server.loading) return;
+
+    if (!keysizes_scan.in_progress) {
+        keysizesResetStats(&current);
+        keysizes_scan.in_progress = 1;
+        keysizes_scan.dbid = 0;
+        keysizes_scan.cursor = 0;
+        keysizes_scan.start_time = mstime();
+    }
+
+    uint64_t time_limit_us = (uint64_t)server.keysizes_scan_cpu_percent * 1000000 / server.hz / 100;
+    monotime start;
+    elapsedStart(&start);
+    for (long iterations = 1;; iterations++) {
+        serverDb *db = &server.db[keysizes_scan.dbid];
+        keysizes_scan.cursor = kvstoreScan(db->keys, keysizes_scan.cursor, -1, keysizesScanCallback, NULL, db);
+        if (keysizes_scan.cursor == 0 && ++keysizes_scan.dbid == server.dbnum) {
+            keysizesEndPass();
+            break;
+        }
+        /* Checking the time is not free, do it once in a while. */
+        if ((iterations % 16) == 0 && elapsedUs(start) >= time_limit_us) break;
+    }
+}
+
+static void keysizesAddReplyHistogram(client *c, unsigned long long *histogram) {
+    int len = 0;
+    for (int j = 0; j < KEYSIZES_BUCKETS; j++) len += histogram[j] != 0;
+    addReplyArrayLen(c, len);
+    for (int j = 0; j < KEYSIZES_BUCKETS; j++) {
+        if (!histogram[j]) continue;
+        addReplyArrayLen(c, 2);
+        addReplyLongLong(c, keysizesBucketLowerBound(j));
+        addReplyLongLong(c, histogram[j]);
+    }
+}
+
+static int keysizesBigKeyCompareDesc(const void *a, const void *b) {
+    const keysizesBigKey *k1 = a, *k2 = b;
+    if (k1->bytes == k2->bytes) return 0;
+    return k1->bytes < k2->bytes ? 1 : -1;
+}
+
+/* The reply of MEMORY KEYSIZES: the current histograms of the number of
+ * elements, and the results of the last completed pass of the scan. */
+void keysizesReply(client *c) {
+    unsigned long long elements[OBJ_TYPE_MAX][KEYSIZES_BUCKETS] = {{0}};
+    unsigned long long keys[OBJ_TYPE_MAX] = {0};
+    int scanned[OBJ_TYPE_MAX] = {0};
+    int types = 0;
+    for (int j = 0; j < OBJ_TYPE_MAX; j++) {
+        for (int b = 0; b < KEYSIZES_BUCKETS; b++) {
+            for (int dbid = 0; dbid < server.dbnum; dbid++) {
+                elements[j][b] += server.db[dbid].keysizes->elements[j][b];
+            }
+            keys[j] += elements[j][b];
+            scanned[j] |= last.bytes[j][b] != 0;
+        }
+        types += keys[j] || scanned[j];
+    }
+
+    addReplyMapLen(c, 5);
+    addReplyBulkCString(c, "passes");
+    addReplyLongLong(c, keysizes_scan.passes);
+    addReplyBulkCString(c, "last-pass-end-time");
+    addReplyLongLong(c, keysizes_scan.last_end_time);
+    addReplyBulkCString(c, "last-pass-duration");
+    addReplyLongLong(c, keysizes_scan.last_duration);
+
+    addReplyBulkCString(c, "types");
+    addReplyMapLen(c, types);
+    for (int j = 0; j < OBJ_TYPE_MAX; j++) {
+        if (!keys[j] && !scanned[j]) continue;
+        addReplyBulkCString(c, keysizesTypeName[j]);
+        addReplyMapLen(c, 3);
+        addReplyBulkCString(c, "keys");
+        addReplyLongLong(c, keys[j]);
+        addReplyBulkCString(c, "elements");
+        keysizesAddReplyHistogram(c, elements[j]);
+        addReplyBulkCString(c, "bytes");
+        keysizesAddReplyHistogram(c, last.bytes[j]);
+    }
+
+    qsort(last.biggest, last.biggest_len, sizeof(keysizesBigKey), keysizesBigKeyCompareDesc);
+    addReplyBulkCString(c, "biggest-keys");
+    addReplyArrayLen(c, last.biggest_len);
+    for (int j = 0; j < last.biggest_len; j++) {
+        keysizesBigKey *k = &last.biggest[j];
+        addReplyMapLen(c, 5);
+        addReplyBulkCString(c, "key");
+        addReplyBulkCBuffer(c, k->key, sdslen(k->key));
+        addReplyBulkCString(c, "db");
+        addReplyLongLong(c, k->dbid);
+        addReplyBulkCString(c, "type");
+        addReplyBulkCString(c, keysizesTypeName[k->type]);
+        addReplyBulkCString(c, "elements");
+        addReplyLongLong(c, k->elements);
+        addReplyBulkCString(c, "bytes");
+        addReplyLongLong(c, k->bytes);
+    }
+}
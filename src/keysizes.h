@@ -0,0 +1,50 @@
+/*
+ * Copyright Valkey Contributors.
+ * All rights reserved.
+ * SPDX-License-Identifier: BSD 3-Clause
+ */
+
+#ifndef __KEYSIZES_H__
+#define __KEYSIZES_H__
+
+#include "server.h"
+
+/* Number of power of two buckets of the histograms, enough for any size. */
+#define KEYSIZES_BUCKETS 65
+/* Number of largest keys, by memory usage, reported by MEMORY KEYSIZES. */
+#define KEYSIZES_BIGGEST_KEYS 32
+
+/* Per type histograms of the number of elements of the keys of a database
+ * (the length in bytes for strings), kept up to date by every command that
+ * adds or deletes a key or changes its length. */
+typedef struct keysizesHist {
+    unsigned long long elements[OBJ_TYPE_MAX][KEYSIZES_BUCKETS];
+} keysizesHist;
+
+/* Bucket 0 counts the zeros, bucket N the values in [2^(N-1), 2^N), and -1
+ * stands for a key that doesn't exist. */
+static inline int keysizesBucket(long long len) {
+    if (len <= 0) return len < 0 ? -1 : 0;
+    return 64 - __builtin_clzll((unsigned long long)len);
+}
+
+/* Move a key of type 'type' of the database 'db' in the histogram when its
+ * length changes from 'oldlen' to 'newlen'. Pass -1 as 'oldlen' when the key
+ * is added, and -1 as 'newlen' when it is deleted. Only the two lengths are
+ * needed since the bucket is derived from them, no state is kept per key. */
+static inline void keysizesUpdate(serverDb *db, int type, long long oldlen, long long newlen) {
+    int oldbucket = keysizesBucket(oldlen), newbucket = keysizesBucket(newlen);
+    if (oldbucket == newbucket) return;
+    if (oldbucket >= 0) db->keysizes->elements[type][oldbucket]--;
+    if (newbucket >= 0) db->keysizes->elements[type][newbucket]++;
+}
+
+/* Exported API */
+keysizesHist *keysizesHistCreate(void);
+void keysizesHistRelease(keysizesHist *hist);
+void keysizesHistEmpty(keysizesHist *hist);
+long long keysizesObjectLength(robj *o);
+void keysizesCron(void);
+void keysizesReply(client *c);
+
+#endif /* __KEYSIZES_H__ */
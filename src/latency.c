@@ -775,3 +775,86 @@ void durationAddSample(int type, monotime duration) {
         ds->max = duration;
     }
 }
+
+/* ---------------------- Event loop phase profiling ------------------------ */
+
+static const char *el_phase_names[EL_PHASE_NUM] = {
+    "process_events", "io_reads_done", "conn_pending_data", "cluster",       "blocked_clients", "active_expire",
+    "modules",        "replication",   "tracking",          "aof",           "pending_writes",  "io_writes_done",
+    "free_clients",   "evict_clients", "server_cron",       "databases_cron", "clients_cron",
+};
+
+static const char *el_phase_events[EL_PHASE_NUM] = {
+    "eventloop-process-events", "eventloop-io-reads-done", "eventloop-conn-pending-data", "eventloop-cluster",
+    "eventloop-blocked-clients", "eventloop-active-expire", "eventloop-modules", "eventloop-replication",
+    "eventloop-tracking", "eventloop-aof", "eventloop-pending-writes", "eventloop-io-writes-done",
+    "eventloop-free-clients", "eventloop-evict-clients", "eventloop-server-cron", "eventloop-databases-cron",
+    "eventloop-clients-cron",
+};
+
+/* Time spent in each phase during the current iteration, and the phases that
+ * ran, as a bitmap. */
+static monotime el_phase_iteration[EL_PHASE_NUM];
+static uint32_t el_phase_ran = 0;
+
+void elPhaseAddTime(int phase, monotime duration) {
+    el_phase_iteration[phase] += duration;
+    el_phase_ran |= 1U << phase;
+}
+
+/* Accounts the time between the end of the poll and beforeSleep() to the
+ * processing of the fired events, minus the crons that ran meanwhile and are
+ * accounted to their own phases. */
+void elPhaseAddEventsTime(monotime duration) {
+    monotime crons = el_phase_iteration[EL_PHASE_SERVER_CRON] + el_phase_iteration[EL_PHASE_DATABASES_CRON] +
+                     el_phase_iteration[EL_PHASE_CLIENTS_CRON];
+    elPhaseAddTime(EL_PHASE_EVENTS, duration > crons ? duration - crons : 0);
+}
+
+/* Called at the end of every event loop iteration, to account the time spent
+ * in each phase during the iteration. */
+void elPhaseEndIteration(void) {
+    if (!el_phase_ran) return;
+    for (int j = 0; j < EL_PHASE_NUM; j++) {
+        if (!(el_phase_ran & (1U << j))) continue;
+        elPhaseStats *ps = &server.el_phase_stats[j];
+        monotime duration = el_phase_iteration[j];
+        ps->calls++;
+        ps->sum += duration;
+        if (duration > ps->max || ps->calls == 1) {
+            ps->max = duration;
+            ps->max_time = server.mstime;
+        }
+        updateCommandLatencyHistogram(&ps->latency_hist, duration * 1000);
+        latencyAddSampleIfNeeded(el_phase_events[j], (mstime_t)(duration / 1000));
+        el_phase_iteration[j] = 0;
+    }
+    el_phase_ran = 0;
+}
+
+void elPhaseResetStats(void) {
+    for (int j = 0; j < EL_PHASE_NUM; j++) {
+        elPhaseStats *ps = &server.el_phase_stats[j];
+        if (ps->latency_hist) hdr_close(ps->latency_hist);
+        memset(ps, 0, sizeof(*ps));
+    }
+}
+
+/* The Eventloopstats INFO section. */
+sds genEventloopInfoString(sds info) {
+    for (int j = 0; j < EL_PHASE_NUM; j++) {
+        elPhaseStats *ps = &server.el_phase_stats[j];
+        if (!ps->calls) continue;
+        info = sdscatprintf(info,
+                            "eventloop_phase_%s:calls=%llu,usec=%llu,usec_per_call=%.2f,max_usec=%llu,"
+                            "max_usec_time=%lld\r\n",
+                            el_phase_names[j], ps->calls, ps->sum, (double)ps->sum / ps->calls, ps->max,
+                            ps->max_time);
+        if (ps->latency_hist) {
+            sds name = sdscatfmt(sdsempty(), "eventloop_phase_%s", el_phase_names[j]);
+            info = fillPercentileDistributionLatencies(info, name, ps->latency_hist);
+            sdsfree(name);
+        }
+    }
+    return info;
+}
@@ -107,4 +107,59 @@ typedef enum {
 
 void durationAddSample(int type, monotime duration);
 
+/* Event loop phase profiling.
+ *
+ * When eventloop-profiling is enabled, the time spent in every phase of an
+ * event loop iteration is accumulated while the iteration runs, and at the
+ * end of the iteration it is added to the statistics of each phase that ran:
+ * cumulative time, a histogram of the time per iteration, and the worst
+ * iteration. Phases slower than latency-monitor-threshold are also reported
+ * as "eventloop-<phase>" latency events. */
+typedef enum {
+    EL_PHASE_EVENTS = 0,     /* Processing of the fired events, excluding the crons below. */
+    EL_PHASE_IO_READS,       /* processIOThreadsReadDone() */
+    EL_PHASE_CONN_PENDING,   /* connTypeProcessPendingData() */
+    EL_PHASE_CLUSTER,        /* clusterBeforeSleep() */
+    EL_PHASE_BLOCKED,        /* blockedBeforeSleep() */
+    EL_PHASE_ACTIVE_EXPIRE,  /* Fast activeExpireCycle() */
+    EL_PHASE_MODULES,        /* Modules before sleep event. */
+    EL_PHASE_REPLICATION,    /* Replica ACKs, failover status and backlog trimming. */
+    EL_PHASE_TRACKING,       /* Client side caching broadcast invalidation. */
+    EL_PHASE_AOF,            /* flushAppendOnlyFile() */
+    EL_PHASE_WRITES,         /* handleClientsWithPendingWrites() */
+    EL_PHASE_IO_WRITES,      /* processIOThreadsWriteDone() */
+    EL_PHASE_FREE_CLIENTS,   /* freeClientsInAsyncFreeQueue() */
+    EL_PHASE_EVICT_CLIENTS,  /* evictClients() */
+    EL_PHASE_SERVER_CRON,    /* serverCron(), excluding databasesCron(). */
+    EL_PHASE_DATABASES_CRON, /* databasesCron() */
+    EL_PHASE_CLIENTS_CRON,   /* The clients cron timer. */
+    EL_PHASE_NUM
+} elPhase;
+
+typedef struct elPhaseStats {
+    unsigned long long calls;           /* Iterations the phase ran in. */
+    unsigned long long sum;             /* Cumulative time in microseconds. */
+    unsigned long long max;             /* Slowest iteration, in microseconds. */
+    long long max_time;                 /* Unix time in milliseconds of the slowest iteration. */
+    struct hdr_histogram *latency_hist; /* Time per iteration, in nanoseconds. */
+} elPhaseStats;
+
+void elPhaseAddTime(int phase, monotime duration);
+void elPhaseAddEventsTime(monotime duration);
+void elPhaseEndIteration(void);
+void elPhaseResetStats(void);
+sds genEventloopInfoString(sds info);
+
+/* Start timing phases of the event loop, if profiling is enabled. */
+#define elPhaseStartMonitor(var) var = server.eventloop_profiling ? getMonotonicUs() : 0;
+
+/* Attribute the time elapsed since 'var' to 'phase', and restart the timer,
+ * so that consecutive phases only cost a clock read each. */
+#define elPhaseEndMonitor(phase, var)                   \
+    if (var) {                                          \
+        monotime elphase_now = getMonotonicUs();        \
+        elPhaseAddTime((phase), elphase_now - (var));   \
+        var = elphase_now;                              \
+    }
+
 #endif /* __LATENCY_H */
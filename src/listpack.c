@@ -658,6 +658,26 @@ unsigned char *lpGet(unsigned char *p, int64_t *count, unsigned char *intbuf) {
     return lpGetWithSize(p, count, intbuf, NULL);
 }
 
+/* Like lpGet(), but also moves '*p' to the element that follows, or sets it
+ * to NULL once the end of the listpack is reached. This is meant for callers
+ * decoding a whole listpack front to back, where lpGet() plus lpNext() would
+ * parse every encoding header twice and re-read the listpack total size each
+ * time. 'lpbytes' is the value returned by lpBytes(), read once by the caller. */
+unsigned char *lpGetNext(unsigned char *lp, size_t lpbytes, unsigned char **p, int64_t *count, unsigned char *intbuf) {
+    uint64_t entry_size = 123456789; /* initialized to avoid warning. */
+    unsigned char *value = lpGetWithSize(*p, count, intbuf, &entry_size);
+    unsigned char *next = *p + entry_size;
+
+    /* The next call to lpGetWithSize could read at most 8 bytes past 'next',
+     * use the slower validation call only when necessary, as lpFind() does. */
+    if (next + 8 >= lp + lpbytes)
+        lpAssertValidEntry(lp, lpbytes, next);
+    else
+        assert(next >= lp + LP_HDR_SIZE && next < lp + lpbytes);
+    *p = (next[0] == LP_EOF) ? NULL : next;
+    return value;
+}
+
 /* This is just a wrapper to lpGet() that is able to get entry value directly.
  * When the function returns NULL, it populates the integer value by reference in 'lval'.
  * Otherwise if the element is encoded as a string a pointer to the string (pointing
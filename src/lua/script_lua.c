@@ -902,6 +902,38 @@ void freeLuaServerArgv(robj **argv, int argc, int argv_len) {
     }
 }
 
+/* Scalar replies of commands called by scripts are captured here, so that
+ * they are pushed on the Lua stack without a RESP round trip. */
+static clientReplySink lua_reply_sink = {REPLY_SINK_EMPTY, 0, NULL, 0};
+
+/* Push the reply captured by the reply sink on the Lua stack, the same way
+ * redisProtocolToLuaType() would have converted its RESP encoding. */
+static void luaPushSinkReply(lua_State *lua, client *c, clientReplySink *sink) {
+    if (!lua_checkstack(lua, 1)) {
+        /* Increase the Lua stack if needed, to make sure there is enough room
+         * to push elements to the stack. On failure, exit with panic. */
+        serverPanic("lua stack limit reach when parsing server.call reply");
+    }
+    switch (sink->type) {
+    case REPLY_SINK_BULK: lua_pushlstring(lua, sink->bulk, sdslen(sink->bulk)); break;
+    case REPLY_SINK_INTEGER: lua_pushnumber(lua, (lua_Number)sink->ll); break;
+    case REPLY_SINK_NULL:
+        if (c->resp == 2)
+            lua_pushboolean(lua, 0);
+        else
+            lua_pushnil(lua);
+        break;
+    default: serverPanic("Unknown reply sink type");
+    }
+    sink->type = REPLY_SINK_EMPTY;
+
+    /* Don't keep a big buffer around after a big reply. */
+    if (sdsalloc(sink->bulk) > PROTO_REPLY_CHUNK_BYTES) {
+        sdsfree(sink->bulk);
+        sink->bulk = NULL;
+    }
+}
+
 static int luaServerGenericCommand(lua_State *lua, int raise_error) {
     int j;
     scriptRunCtx *rctx = luaGetFromRegistry(lua, REGISTRY_RUN_CTX_NAME);
@@ -945,8 +977,16 @@ static int luaServerGenericCommand(lua_State *lua, int raise_error) {
         ldbLog(cmdlog);
     }
 
+    /* Scalar replies are captured by the sink, unless the debugger needs
+     * to log the reply protocol. */
+    if (!ldbIsEnabled()) {
+        if (lua_reply_sink.bulk == NULL) lua_reply_sink.bulk = sdsempty();
+        c->reply_sink = &lua_reply_sink;
+    }
     scriptCall(rctx, &err);
+    c->reply_sink = NULL;
     if (err) {
+        lua_reply_sink.type = REPLY_SINK_EMPTY;
         luaPushError(lua, err);
         sdsfree(err);
         /* push a field indicate to ignore updating the stats on this error
@@ -957,6 +997,13 @@ static int luaServerGenericCommand(lua_State *lua, int raise_error) {
         goto cleanup;
     }
 
+    if (lua_reply_sink.type != REPLY_SINK_EMPTY) {
+        /* The reply was captured by the sink, it can't be an error. */
+        luaPushSinkReply(lua, c, &lua_reply_sink);
+        raise_error = 0;
+        goto cleanup;
+    }
+
     /* Convert the result of the command into a suitable Lua type.
      * The first thing we need is to create a single string from the client
      * output buffers. */
@@ -970,12 +1017,7 @@ static int luaServerGenericCommand(lua_State *lua, int raise_error) {
     } else {
         reply = sdsnewlen(c->buf, c->bufpos);
         c->bufpos = 0;
-        while (listLength(c->reply)) {
-            clientReplyBlock *o = listNodeValue(listFirst(c->reply));
-
-            reply = sdscatlen(reply, o->buf, o->used);
-            listDelNode(c->reply, listFirst(c->reply));
-        }
+        reply = catClientReplyList(reply, c);
     }
     if (raise_error && reply[0] != '-') raise_error = 0;
     redisProtocolToLuaType(lua, reply);
@@ -80,52 +80,53 @@ void onMaxBatchSizeChange(void) {
 }
 
 /* Move to the next key in the batch. */
-static void moveToNextKey(void) {
-    batch->cur_idx = (batch->cur_idx + 1) % batch->key_count;
+static void moveToNextKey(PrefetchCommandsBatch *b) {
+    b->cur_idx = (b->cur_idx + 1) % b->key_count;
 }
 
-static void markKeyAsdone(KeyPrefetchInfo *info) {
+static void markKeyAsdone(PrefetchCommandsBatch *b, KeyPrefetchInfo *info) {
     info->state = PREFETCH_DONE;
-    server.stat_total_prefetch_entries++;
-    batch->keys_done++;
+    /* Only the commands batch is reported in the IO threads stats. */
+    if (b == batch) server.stat_total_prefetch_entries++;
+    b->keys_done++;
 }
 
 /* Returns the next KeyPrefetchInfo structure that needs to be processed. */
-static KeyPrefetchInfo *getNextPrefetchInfo(void) {
-    size_t start_idx = batch->cur_idx;
+static KeyPrefetchInfo *getNextPrefetchInfo(PrefetchCommandsBatch *b) {
+    size_t start_idx = b->cur_idx;
     do {
-        KeyPrefetchInfo *info = &batch->prefetch_info[batch->cur_idx];
+        KeyPrefetchInfo *info = &b->prefetch_info[b->cur_idx];
         if (info->state != PREFETCH_DONE) return info;
-        batch->cur_idx = (batch->cur_idx + 1) % batch->key_count;
-    } while (batch->cur_idx != start_idx);
+        b->cur_idx = (b->cur_idx + 1) % b->key_count;
+    } while (b->cur_idx != start_idx);
     return NULL;
 }
 
-static void initBatchInfo(hashtable **tables) {
+static void initBatchInfo(PrefetchCommandsBatch *b, hashtable **tables) {
     /* Initialize the prefetch info */
-    for (size_t i = 0; i < batch->key_count; i++) {
-        KeyPrefetchInfo *info = &batch->prefetch_info[i];
+    for (size_t i = 0; i < b->key_count; i++) {
+        KeyPrefetchInfo *info = &b->prefetch_info[i];
         if (!tables[i] || hashtableSize(tables[i]) == 0) {
             info->state = PREFETCH_DONE;
-            batch->keys_done++;
+            b->keys_done++;
             continue;
         }
         info->state = PREFETCH_ENTRY;
-        hashtableIncrementalFindInit(&info->hashtab_state, tables[i], batch->keys[i]);
+        hashtableIncrementalFindInit(&info->hashtab_state, tables[i], b->keys[i]);
     }
 }
 
-static void prefetchEntry(KeyPrefetchInfo *info) {
+static void prefetchEntry(PrefetchCommandsBatch *b, KeyPrefetchInfo *info) {
     if (hashtableIncrementalFindStep(&info->hashtab_state) == 1) {
         /* Not done yet */
-        moveToNextKey();
+        moveToNextKey(b);
     } else {
         info->state = PREFETCH_VALUE;
     }
 }
 
 /* Prefetch the entry's value. If the value is found.*/
-static void prefetchValue(KeyPrefetchInfo *info) {
+static void prefetchValue(PrefetchCommandsBatch *b, KeyPrefetchInfo *info) {
     void *entry;
     if (hashtableIncrementalFindGetResult(&info->hashtab_state, &entry)) {
         robj *val = entry;
@@ -134,26 +135,25 @@ static void prefetchValue(KeyPrefetchInfo *info) {
         }
     }
 
-    markKeyAsdone(info);
+    markKeyAsdone(b, info);
 }
 
-/* Prefetch hashtable data for an array of keys.
+/* Prefetch hashtable data for the keys of a batch.
  *
- * This function takes an array of tables and keys, attempting to bring
- * data closer to the L1 cache that might be needed for hashtable operations
- * on those keys.
+ * This function takes an array of tables, one for each of the batch keys,
+ * attempting to bring data closer to the L1 cache that might be needed for
+ * hashtable operations on those keys, including the key's value data.
  *
+ * b - The batch holding the keys and their prefetch state.
  * tables - An array of hashtables to prefetch data from.
- * prefetch_value - If true, we prefetch the value data for each key.
- * to bring the key's value data closer to the L1 cache as well.
  */
-static void hashtablePrefetch(hashtable **tables) {
-    initBatchInfo(tables);
+static void hashtablePrefetch(PrefetchCommandsBatch *b, hashtable **tables) {
+    initBatchInfo(b, tables);
     KeyPrefetchInfo *info;
-    while ((info = getNextPrefetchInfo())) {
+    while ((info = getNextPrefetchInfo(b))) {
         switch (info->state) {
-        case PREFETCH_ENTRY: prefetchEntry(info); break;
-        case PREFETCH_VALUE: prefetchValue(info); break;
+        case PREFETCH_ENTRY: prefetchEntry(b, info); break;
+        case PREFETCH_VALUE: prefetchValue(b, info); break;
         default: serverPanic("Unknown prefetch state %d", info->state);
         }
     }
@@ -201,7 +201,7 @@ static void prefetchCommands(void) {
     if (batch->key_count > 1) {
         server.stat_total_prefetch_batches++;
         /* Prefetch keys from the main hashtable */
-        hashtablePrefetch(batch->keys_tables);
+        hashtablePrefetch(batch, batch->keys_tables);
     }
 }
 
@@ -278,3 +278,25 @@ void removeClientFromPendingCommandsBatch(client *c) {
         }
     }
 }
+
+/* Prefetch the hashtable entries and values of 'count' keys outside of the
+ * commands batch, for callers that are about to look up several keys in a row,
+ * such as modules opening multiple keys at once.
+ *
+ * tables - The hashtable each key lives in (NULL if there is none).
+ * keys - The keys, as sds strings.
+ *
+ * At most PREFETCH_KEYS_MAX keys are prefetched, callers with more keys split
+ * them in several calls. This may run while a commands batch is being
+ * executed, so it uses its own state and leaves the pending batch untouched. */
+void prefetchKeys(hashtable **tables, void **keys, size_t count) {
+    if (count < 2) return;
+    if (count > PREFETCH_KEYS_MAX) count = PREFETCH_KEYS_MAX;
+
+    KeyPrefetchInfo prefetch_info[PREFETCH_KEYS_MAX];
+    PrefetchCommandsBatch b = {0};
+    b.key_count = count;
+    b.keys = keys;
+    b.prefetch_info = prefetch_info;
+    hashtablePrefetch(&b, tables);
+}
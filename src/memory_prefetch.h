@@ -1,11 +1,18 @@
 #ifndef MEMORY_PREFETCH_H
 #define MEMORY_PREFETCH_H
 
+#include <stddef.h>
+
+/* Maximum number of keys prefetchKeys() handles at once. */
+#define PREFETCH_KEYS_MAX 16
+
 struct client;
+struct hashtable;
 
 void prefetchCommandsBatchInit(void);
 void processClientsCommandsBatch(void);
 int addCommandToBatchAndProcessIfFull(struct client *c);
 void removeClientFromPendingCommandsBatch(struct client *c);
+void prefetchKeys(struct hashtable **tables, void **keys, size_t count);
 
 #endif /* MEMORY_PREFETCH_H */
@@ -64,6 +64,8 @@
 #include "module.h"
 #include "io_threads.h"
 #include "scripting_engine.h"
+#include "keysizes.h"
+#include "commandphase.h"
 #include <dlfcn.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
@@ -897,12 +899,7 @@ static CallReply *moduleParseReply(client *c, ValkeyModuleCtx *ctx) {
     /* Convert the result of the command into a module reply. */
     sds proto = sdsnewlen(c->buf, c->bufpos);
     c->bufpos = 0;
-    while (listLength(c->reply)) {
-        clientReplyBlock *o = listNodeValue(listFirst(c->reply));
-
-        proto = sdscatlen(proto, o->buf, o->used);
-        listDelNode(c->reply, listFirst(c->reply));
-    }
+    proto = catClientReplyList(proto, c);
     CallReply *reply = callReplyCreate(proto, c->deferred_reply_errors, ctx);
     c->deferred_reply_errors = NULL; /* now the responsibility of the reply object. */
     return reply;
@@ -4148,6 +4145,29 @@ ValkeyModuleKey *VM_OpenKey(ValkeyModuleCtx *ctx, robj *keyname, int mode) {
     return kp;
 }
 
+/* Open several keys at once, as if VM_OpenKey() was called for each of them
+ * with the same 'mode', but first prefetching the keys and their values from
+ * the keyspace in a batch. Commands that work on several keys should prefer
+ * this API: the memory accesses of the different lookups overlap instead of
+ * stalling on a cache miss for each key in turn.
+ *
+ * 'keynames' is an array of 'numkeys' key names and 'keys' an array of at
+ * least 'numkeys' entries that is populated with the key handles, in the same
+ * order. As with VM_OpenKey(), the entry is NULL when the key doesn't exist and
+ * the mode is just VALKEYMODULE_READ. Every non NULL handle must be closed with
+ * VM_CloseKey().
+ *
+ * The function returns the number of key handles that are not NULL. */
+int VM_OpenKeys(ValkeyModuleCtx *ctx, robj **keynames, int numkeys, int mode, ValkeyModuleKey **keys) {
+    int opened = 0;
+    dbPrefetchKeys(ctx->client->db, keynames, numkeys);
+    for (int j = 0; j < numkeys; j++) {
+        keys[j] = VM_OpenKey(ctx, keynames[j], mode);
+        if (keys[j]) opened++;
+    }
+    return opened;
+}
+
 /**
  * Returns the full OpenKey modes mask, using the return value
  * the module can check if a certain set of OpenKey modes are supported
@@ -4464,6 +4484,7 @@ int VM_StringTruncate(ValkeyModuleKey *key, size_t newlen) {
             if (sdslen(key->value->ptr) < sdsavail(key->value->ptr))
                 key->value->ptr = sdsRemoveFreeSpace(key->value->ptr, 0);
         }
+        keysizesUpdate(key->db, OBJ_STRING, curlen, newlen);
     }
     return VALKEYMODULE_OK;
 }
@@ -4577,6 +4598,8 @@ int VM_ListPush(ValkeyModuleKey *key, int where, ValkeyModuleString *ele) {
     if (key->value == NULL) moduleCreateEmptyKey(key, VALKEYMODULE_KEYTYPE_LIST);
     listTypeTryConversionAppend(key->value, &ele, 0, 0, moduleFreeListIterator, key);
     listTypePush(key->value, ele, (where == VALKEYMODULE_LIST_HEAD) ? LIST_HEAD : LIST_TAIL);
+    long long len = listTypeLength(key->value);
+    keysizesUpdate(key->db, OBJ_LIST, len - 1, len);
     return VALKEYMODULE_OK;
 }
 
@@ -4605,6 +4628,8 @@ ValkeyModuleString *VM_ListPop(ValkeyModuleKey *key, int where) {
     }
     if (key->iter) moduleFreeKeyIterator(key);
     robj *ele = listTypePop(key->value, (where == VALKEYMODULE_LIST_HEAD) ? LIST_HEAD : LIST_TAIL);
+    long long len = listTypeLength(key->value);
+    keysizesUpdate(key->db, OBJ_LIST, len + 1, len);
     robj *decoded = getDecodedObject(ele);
     decrRefCount(ele);
     if (!moduleDelKeyIfEmpty(key)) listTypeTryConversion(key->value, LIST_CONV_SHRINKING, moduleFreeListIterator, key);
@@ -4712,6 +4737,8 @@ int VM_ListInsert(ValkeyModuleKey *key, long index, ValkeyModuleString *value) {
     if (moduleListIteratorSeek(key, index, VALKEYMODULE_WRITE)) {
         int where = index < 0 ? LIST_TAIL : LIST_HEAD;
         listTypeInsert(&key->u.list.entry, value, where);
+        long long len = listTypeLength(key->value);
+        keysizesUpdate(key->db, OBJ_LIST, len - 1, len);
         /* A note in quicklist.c forbids use of iterator after insert. */
         moduleFreeKeyIterator(key);
         return VALKEYMODULE_OK;
@@ -4734,6 +4761,8 @@ int VM_ListInsert(ValkeyModuleKey *key, long index, ValkeyModuleString *value) {
 int VM_ListDelete(ValkeyModuleKey *key, long index) {
     if (moduleListIteratorSeek(key, index, VALKEYMODULE_WRITE)) {
         listTypeDelete(key->iter, &key->u.list.entry);
+        long long len = listTypeLength(key->value);
+        keysizesUpdate(key->db, OBJ_LIST, len + 1, len);
         if (moduleDelKeyIfEmpty(key)) return VALKEYMODULE_OK;
         listTypeTryConversion(key->value, LIST_CONV_SHRINKING, moduleFreeListIterator, key);
         if (!key->iter) return VALKEYMODULE_OK; /* Return ASAP if iterator has been freed */
@@ -4829,6 +4858,10 @@ int VM_ZsetAdd(ValkeyModuleKey *key, double score, ValkeyModuleString *ele, int
         moduleDelKeyIfEmpty(key);
         return VALKEYMODULE_ERR;
     }
+    if (out_flags & ZADD_OUT_ADDED) {
+        long long len = zsetLength(key->value);
+        keysizesUpdate(key->db, OBJ_ZSET, len - 1, len);
+    }
     if (flagsptr) *flagsptr = moduleZsetAddFlagsFromCoreFlags(out_flags);
     return VALKEYMODULE_OK;
 }
@@ -4858,6 +4891,10 @@ int VM_ZsetIncrby(ValkeyModuleKey *key, double score, ValkeyModuleString *ele, i
         moduleDelKeyIfEmpty(key);
         return VALKEYMODULE_ERR;
     }
+    if (out_flags & ZADD_OUT_ADDED) {
+        long long len = zsetLength(key->value);
+        keysizesUpdate(key->db, OBJ_ZSET, len - 1, len);
+    }
     if (flagsptr) *flagsptr = moduleZsetAddFlagsFromCoreFlags(out_flags);
     return VALKEYMODULE_OK;
 }
@@ -4884,6 +4921,8 @@ int VM_ZsetRem(ValkeyModuleKey *key, ValkeyModuleString *ele, int *deleted) {
     if (!(key->mode & VALKEYMODULE_WRITE)) return VALKEYMODULE_ERR;
     if (key->value && key->value->type != OBJ_ZSET) return VALKEYMODULE_ERR;
     if (key->value != NULL && zsetDel(key->value, ele->ptr)) {
+        long long len = zsetLength(key->value);
+        keysizesUpdate(key->db, OBJ_ZSET, len + 1, len);
         if (deleted) *deleted = 1;
         moduleDelKeyIfEmpty(key);
     } else {
@@ -5294,6 +5333,7 @@ int VM_HashSet(ValkeyModuleKey *key, int flags, ...) {
     }
     if (key->value == NULL) moduleCreateEmptyKey(key, VALKEYMODULE_KEYTYPE_HASH);
 
+    long long oldlen = hashTypeLength(key->value);
     int count = 0;
     va_start(ap, flags);
     while (1) {
@@ -5344,6 +5384,7 @@ int VM_HashSet(ValkeyModuleKey *key, int flags, ...) {
         }
     }
     va_end(ap);
+    keysizesUpdate(key->db, OBJ_HASH, oldlen, hashTypeLength(key->value));
     moduleDelKeyIfEmpty(key);
     if (count == 0) errno = ENOENT;
     return count;
@@ -5526,6 +5567,7 @@ int VM_StreamAdd(ValkeyModuleKey *key, int flags, ValkeyModuleStreamID *id, Valk
         if (created) moduleDelKeyIfEmpty(key);
         return VALKEYMODULE_ERR;
     }
+    keysizesUpdate(key->db, OBJ_STREAM, s->length - 1, s->length);
     /* Postponed signalKeyAsReady(). Done implicitly by moduleCreateEmptyKey()
      * so not needed if the stream has just been created. */
     if (!created) key->u.stream.signalready = 1;
@@ -5570,6 +5612,7 @@ int VM_StreamDelete(ValkeyModuleKey *key, ValkeyModuleStreamID *id) {
     stream *s = key->value->ptr;
     streamID streamid = {id->ms, id->seq};
     if (streamDeleteItem(s, &streamid)) {
+        keysizesUpdate(key->db, OBJ_STREAM, s->length + 1, s->length);
         return VALKEYMODULE_OK;
     } else {
         errno = ENOENT; /* no entry with this id */
@@ -5831,6 +5874,8 @@ int VM_StreamIteratorDelete(ValkeyModuleKey *key) {
     }
     streamIterator *si = key->iter;
     streamIteratorRemoveEntry(si, &key->u.stream.currentid);
+    stream *s = key->value->ptr;
+    keysizesUpdate(key->db, OBJ_STREAM, s->length + 1, s->length);
     key->u.stream.currentid.ms = 0; /* Make sure repeated Delete() fails */
     key->u.stream.currentid.seq = 0;
     key->u.stream.numfieldsleft = 0; /* Make sure NextField() fails */
@@ -5864,7 +5909,10 @@ long long VM_StreamTrimByLength(ValkeyModuleKey *key, int flags, long long lengt
         return -1;
     }
     int approx = flags & VALKEYMODULE_STREAM_TRIM_APPROX ? 1 : 0;
-    return streamTrimByLength((stream *)key->value->ptr, length, approx);
+    stream *s = key->value->ptr;
+    int64_t deleted = streamTrimByLength(s, length, approx);
+    keysizesUpdate(key->db, OBJ_STREAM, s->length + deleted, s->length);
+    return deleted;
 }
 
 /* Trim a stream by ID, similar to XTRIM with MINID.
@@ -5895,7 +5943,10 @@ long long VM_StreamTrimByID(ValkeyModuleKey *key, int flags, ValkeyModuleStreamI
     }
     int approx = flags & VALKEYMODULE_STREAM_TRIM_APPROX ? 1 : 0;
     streamID minid = (streamID){id->ms, id->seq};
-    return streamTrimByID((stream *)key->value->ptr, minid, approx);
+    stream *s = key->value->ptr;
+    int64_t deleted = streamTrimByID(s, minid, approx);
+    keysizesUpdate(key->db, OBJ_STREAM, s->length + deleted, s->length);
+    return deleted;
 }
 
 /* --------------------------------------------------------------------------
@@ -12198,6 +12249,8 @@ int moduleFreeCommand(struct ValkeyModule *module, struct serverCommand *cmd) {
 void moduleUnregisterCommands(struct ValkeyModule *module) {
     /* Drain IO queue before modifying commands dictionary to prevent concurrent access while modifying it. */
     drainIOThreadsQueue();
+    /* Clients may still be writing the reply of a sampled module command. */
+    cmdPhaseForgetPendingWrites();
     /* Unregister all the commands registered by this module. */
     hashtableIterator iter;
     void *next;
@@ -13791,6 +13844,7 @@ void moduleRegisterCoreAPI(void) {
     REGISTER_API(SelectDb);
     REGISTER_API(KeyExists);
     REGISTER_API(OpenKey);
+    REGISTER_API(OpenKeys);
     REGISTER_API(GetOpenKeyModesAll);
     REGISTER_API(CloseKey);
     REGISTER_API(KeyType);
@@ -37,6 +37,7 @@
 #include "fmtargs.h"
 #include "io_threads.h"
 #include "module.h"
+#include "commandphase.h"
 #include <strings.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
@@ -107,12 +108,16 @@ size_t getStringObjectLen(robj *o) {
 /* Client.reply list dup and free methods. */
 void *dupClientReplyValue(void *o) {
     clientReplyBlock *old = o;
-    clientReplyBlock *buf = zmalloc(sizeof(clientReplyBlock) + old->size);
-    memcpy(buf, o, sizeof(clientReplyBlock) + old->size);
+    size_t bufsize = old->payload ? 0 : old->size;
+    clientReplyBlock *buf = zmalloc(sizeof(clientReplyBlock) + bufsize);
+    memcpy(buf, o, sizeof(clientReplyBlock) + bufsize);
+    if (buf->payload) buf->payload->refcount++;
     return buf;
 }
 
 void freeClientReplyValue(void *o) {
+    clientReplyBlock *block = o;
+    if (block && block->payload) releaseSharedReplyPayload(block->payload);
     zfree(o);
 }
 
@@ -207,6 +212,7 @@ client *createClient(connection *conn) {
     c->reply = listCreate();
     c->deferred_reply_errors = NULL;
     c->reply_bytes = 0;
+    c->reply_sink = NULL;
     c->obuf_soft_limit_reached_time = 0;
     listSetFreeMethod(c->reply, freeClientReplyValue);
     listSetDupMethod(c->reply, dupClientReplyValue);
@@ -234,8 +240,14 @@ client *createClient(connection *conn) {
     c->net_output_bytes = 0;
     c->net_output_bytes_curr_cmd = 0;
     c->commands_processed = 0;
+    c->cmd_phase_sampled = 0;
+    c->cmd_phase_parse_ns = 0;
+    c->cmd_phase_write_cmd = NULL;
+    c->cmd_phase_write_ns = 0;
     c->io_last_reply_block = NULL;
     c->io_last_bufpos = 0;
+    c->push_queue = NULL;
+    c->io_push_queue = NULL;
     return c;
 }
 
@@ -307,6 +319,9 @@ int prepareClientToWrite(client *c) {
      * handler since there is no socket at all. */
     if (c->flag.script || c->flag.module) return C_OK;
 
+    /* Pub/Sub messages queued for the I/O threads come first. */
+    if (c->push_queue || c->io_push_queue) flushClientPushes(c);
+
     /* If CLIENT_CLOSE_ASAP flag is set, we need not write anything. */
     if (c->flag.close_asap) return C_ERR;
 
@@ -345,7 +360,7 @@ sds aggregateClientOutputBuffer(client *c) {
     serverAssert(c->bufpos == 0);
     while ((ln = listNext(&li)) != NULL) {
         val_block = (clientReplyBlock *)listNodeValue(ln);
-        cmd_response = sdscatlen(cmd_response, val_block->buf, val_block->used);
+        cmd_response = sdscatlen(cmd_response, replyBlockData(val_block), val_block->used);
     }
     return cmd_response;
 }
@@ -401,9 +416,10 @@ size_t _addReplyToBuffer(client *c, const char *s, size_t len) {
     return reply_len;
 }
 
-/* Adds the reply to the reply linked list.
- * Note: some edits to this function need to be relayed to AddReplyFromClient. */
-void _addReplyProtoToList(client *c, list *reply_list, const char *s, size_t len) {
+/* Appends the protocol to the reply list 's', and returns the size of the
+ * new node it had to create, if any. Unlike _addReplyProtoToList() the
+ * client is not accounted for it, so this can be used by the I/O threads. */
+static size_t _addProtoToReplyList(list *reply_list, const char *s, size_t len) {
     listNode *ln = listLast(reply_list);
     clientReplyBlock *tail = ln ? listNodeValue(ln) : NULL;
 
@@ -415,26 +431,35 @@ void _addReplyProtoToList(client *c, list *reply_list, const char *s, size_t len
     if (tail) {
         /* Copy the part we can fit into the tail, and leave the rest for a
          * new node */
-        size_t avail = tail->size - tail->used;
+        size_t avail = replyBlockAvail(tail);
         size_t copy = avail >= len ? len : avail;
         memcpy(tail->buf + tail->used, s, copy);
         tail->used += copy;
         s += copy;
         len -= copy;
     }
-    if (len) {
-        /* Create a new node, make sure it is allocated to at
-         * least PROTO_REPLY_CHUNK_BYTES */
-        size_t usable_size;
-        size_t size = len < PROTO_REPLY_CHUNK_BYTES ? PROTO_REPLY_CHUNK_BYTES : len;
-        tail = zmalloc_usable(size + sizeof(clientReplyBlock), &usable_size);
-        /* take over the allocation's internal fragmentation */
-        tail->size = usable_size - sizeof(clientReplyBlock);
-        tail->used = len;
-        memcpy(tail->buf, s, len);
-        listAddNodeTail(reply_list, tail);
-        c->reply_bytes += tail->size;
+    if (len == 0) return 0;
+
+    /* Create a new node, make sure it is allocated to at
+     * least PROTO_REPLY_CHUNK_BYTES */
+    size_t usable_size;
+    size_t size = len < PROTO_REPLY_CHUNK_BYTES ? PROTO_REPLY_CHUNK_BYTES : len;
+    tail = zmalloc_usable(size + sizeof(clientReplyBlock), &usable_size);
+    /* take over the allocation's internal fragmentation */
+    tail->size = usable_size - sizeof(clientReplyBlock);
+    tail->used = len;
+    tail->payload = NULL;
+    memcpy(tail->buf, s, len);
+    listAddNodeTail(reply_list, tail);
+    return tail->size;
+}
 
+/* Adds the reply to the reply linked list.
+ * Note: some edits to this function need to be relayed to AddReplyFromClient. */
+void _addReplyProtoToList(client *c, list *reply_list, const char *s, size_t len) {
+    size_t added = _addProtoToReplyList(reply_list, s, len);
+    if (added) {
+        c->reply_bytes += added;
         closeClientOnOutputBufferLimitReached(c, 1);
     }
 }
@@ -448,7 +473,47 @@ int cmdHasPushAsReply(struct serverCommand *cmd) {
            cmd->proc == punsubscribeCommand || cmd->proc == ssubscribeCommand || cmd->proc == sunsubscribeCommand;
 }
 
+/* Capture a scalar reply in the reply sink of the client, if it has one and
+ * the reply is the first output of the command. Returns 1 if the reply was
+ * captured, in that case nothing must be added to the output buffer. */
+static int addReplyToSink(client *c, replySinkType type, const char *p, size_t len, long long ll) {
+    clientReplySink *sink = c->reply_sink;
+    if (sink == NULL || sink->type != REPLY_SINK_EMPTY || c->bufpos || listLength(c->reply)) return 0;
+
+    sink->type = type;
+    if (type == REPLY_SINK_BULK) {
+        sink->bulk = sdscpylen(sink->bulk, p, len);
+        sink->proto_len = 1 + digits10(len) + 2 + len + 2;
+    } else if (type == REPLY_SINK_INTEGER) {
+        sink->ll = ll;
+        sink->proto_len = 1 + sdigits10(ll) + 2;
+    } else {
+        sink->proto_len = c->resp == 2 ? 5 : 3;
+    }
+    c->net_output_bytes_curr_cmd += sink->proto_len;
+    return 1;
+}
+
+/* The command emits more output after the reply captured by the sink, so
+ * the captured reply is added to the output buffer first. */
+static void spillReplySink(client *c) {
+    clientReplySink *sink = c->reply_sink;
+    replySinkType type = sink->type;
+
+    sink->type = REPLY_SINK_EMPTY;
+    c->net_output_bytes_curr_cmd -= sink->proto_len;
+    c->reply_sink = NULL;
+    switch (type) {
+    case REPLY_SINK_BULK: addReplyBulkCBuffer(c, sink->bulk, sdslen(sink->bulk)); break;
+    case REPLY_SINK_INTEGER: addReplyLongLong(c, sink->ll); break;
+    case REPLY_SINK_NULL: addReplyNull(c); break;
+    default: serverPanic("Unknown reply sink type");
+    }
+    c->reply_sink = sink;
+}
+
 void _addReplyToBufferOrList(client *c, const char *s, size_t len) {
+    if (c->reply_sink && c->reply_sink->type != REPLY_SINK_EMPTY) spillReplySink(c);
     if (c->flag.close_after_reply) return;
 
     /* Replicas should normally not cause any writes to the reply buffer. In case a rogue replica sent a command on the
@@ -480,8 +545,10 @@ void _addReplyToBufferOrList(client *c, const char *s, size_t len) {
         return;
     }
 
+    uint64_t phase_start = cmdPhaseStart();
     size_t reply_len = _addReplyToBuffer(c, s, len);
     if (len > reply_len) _addReplyProtoToList(c, c->reply, s + reply_len, len - reply_len);
+    if (phase_start) cmdPhaseAddTime(CMD_PHASE_REPLY, phase_start);
 }
 
 /* -----------------------------------------------------------------------------
@@ -769,7 +836,7 @@ void trimReplyUnusedTailSpace(client *c) {
 
     /* Note that 'tail' may be NULL even if we have a tail node, because when
      * addReplyDeferredLen() is used */
-    if (!tail) return;
+    if (!tail || tail->payload) return;
 
     /* We only try to trim the space is relatively high (more than a 1/4 of the
      * allocation), otherwise there's a high chance realloc will NOP.
@@ -788,6 +855,130 @@ void trimReplyUnusedTailSpace(client *c) {
     }
 }
 
+/* Create a payload holding a copy of the protocol 's', that can be added to
+ * the output buffer of many clients with addReplySharedPayload() without
+ * copying it again. 'sharers' is the number of clients expected to reference
+ * it: each one of them is charged an equal share of its memory.
+ *
+ * The caller owns the returned payload and should release it with
+ * releaseSharedReplyPayload() once done adding it to clients. */
+sharedReplyPayload *createSharedReplyPayload(const char *s, size_t len, unsigned long sharers) {
+    size_t usable_size;
+    sharedReplyPayload *payload = zmalloc_usable(sizeof(sharedReplyPayload) + len, &usable_size);
+    payload->refcount = 1;
+    payload->len = len;
+    if (sharers == 0) sharers = 1;
+    payload->share = (usable_size + sharers - 1) / sharers;
+    memcpy(payload->buf, s, len);
+    return payload;
+}
+
+void releaseSharedReplyPayload(sharedReplyPayload *payload) {
+    serverAssert(payload->refcount > 0);
+    if (--payload->refcount == 0) zfree(payload);
+}
+
+/* Add a shared payload to the client output buffer. Instead of copying the
+ * protocol, a reply block referencing the payload is appended to the reply
+ * list, and later written with writev() like any other block. */
+void addReplySharedPayload(client *c, sharedReplyPayload *payload) {
+    if (prepareClientToWrite(c) != C_OK) return;
+
+    /* Push messages to the current client may need to be postponed after the
+     * command reply, and replicas are not supposed to get replies at all: let
+     * the regular path handle both, copying the payload. */
+    if (c->flag.close_after_reply || getClientType(c) == CLIENT_TYPE_REPLICA ||
+        (c->flag.pushing && c == server.current_client)) {
+        _addReplyToBufferOrList(c, payload->buf, payload->len);
+        return;
+    }
+
+    c->net_output_bytes_curr_cmd += payload->len;
+
+    /* We call it here because this function may affect the reply
+     * buffer offset (see function comment) */
+    reqresSaveClientReplyOffset(c);
+
+    /* The tail node won't be appended to anymore, trim its unused space. */
+    trimReplyUnusedTailSpace(c);
+
+    clientReplyBlock *block = zmalloc(sizeof(clientReplyBlock));
+    block->size = payload->share;
+    block->used = payload->len;
+    block->payload = payload;
+    payload->refcount++;
+    listAddNodeTail(c->reply, block);
+    c->reply_bytes += block->size;
+
+    closeClientOnOutputBufferLimitReached(c, 1);
+}
+
+/* Append the blocks of the reply list of the client to 's', and remove them
+ * from the list. Used to collect the reply of a command executed by a fake
+ * client, whose reply list may hold shared payloads like any other. */
+sds catClientReplyList(sds s, client *c) {
+    while (listLength(c->reply)) {
+        clientReplyBlock *o = listNodeValue(listFirst(c->reply));
+
+        s = sdscatlen(s, replyBlockData(o), o->used);
+        listDelNode(c->reply, listFirst(c->reply));
+    }
+    return s;
+}
+
+/* Appends the messages of a push queue to the client output buffer, and
+ * returns the number of bytes it added to the reply list. The client isn't
+ * accounted for them and the queue references of the payloads appended as
+ * reply blocks are handed over to the blocks, so this can be used by the I/O
+ * threads. */
+static size_t _addPushQueueToReply(client *c, clientPushQueue *q) {
+    size_t reply_bytes = 0;
+    for (int j = 0; j < q->count; j++) {
+        sharedReplyPayload *payload = q->payloads[j];
+        if (payload->len >= PROTO_REPLY_SHARE_MIN_BYTES) {
+            clientReplyBlock *block = zmalloc(sizeof(clientReplyBlock));
+            block->size = payload->share;
+            block->used = payload->len;
+            block->payload = payload;
+            listAddNodeTail(c->reply, block);
+            q->payloads[j] = NULL;
+            reply_bytes += block->size;
+        } else {
+            size_t reply_len = _addReplyToBuffer(c, payload->buf, payload->len);
+            if (payload->len > reply_len)
+                reply_bytes += _addProtoToReplyList(c->reply, payload->buf + reply_len, payload->len - reply_len);
+        }
+    }
+    return reply_bytes;
+}
+
+/* Adds the Pub/Sub messages queued for an I/O thread to the client output
+ * buffer from the main thread, when the queue can't be handed to an I/O
+ * thread or another reply must follow the messages. The messages were
+ * already accounted as output of the publishing command when queued. */
+void addReplyPushQueue(client *c, clientPushQueue *q) {
+    if (c->flag.close_asap || c->flag.close_after_reply) return;
+    if (!clientHasPendingReplies(c)) putClientInPendingWriteQueue(c);
+    c->reply_bytes += _addPushQueueToReply(c, q);
+    closeClientOnOutputBufferLimitReached(c, 1);
+}
+
+/* Runs in the I/O thread before writing to the client: appends the messages of
+ * its push queue to the output buffer, the main thread accounts the client for
+ * them when the write is done. */
+void ioThreadAppendPushes(client *c) {
+    clientPushQueue *q = c->io_push_queue;
+    q->reply_bytes = _addPushQueueToReply(c, q);
+
+    /* Same as trySendWriteToIOThreads(), now that we know the end of the output. */
+    c->io_last_reply_block = listLast(c->reply);
+    if (c->io_last_reply_block) {
+        c->io_last_bufpos = ((clientReplyBlock *)listNodeValue(c->io_last_reply_block))->used;
+    } else {
+        c->io_last_bufpos = (size_t)c->bufpos;
+    }
+}
+
 /* Adds an empty object to the reply list that will contain the multi bulk
  * length, which is not known when this function is called. */
 void *addReplyDeferredLen(client *c) {
@@ -795,6 +986,7 @@ void *addReplyDeferredLen(client *c) {
      * ready to be sent, since we are sure that before returning to the
      * event loop setDeferredAggregateLen() will be called. */
     if (prepareClientToWrite(c) != C_OK) return NULL;
+    if (c->reply_sink && c->reply_sink->type != REPLY_SINK_EMPTY) spillReplySink(c);
 
     /* Replicas should normally not cause any writes to the reply buffer. In case a rogue replica sent a command on the
      * replication link that caused a reply to be generated we'll simply disconnect it.
@@ -837,9 +1029,9 @@ void setDeferredReply(client *c, void *node, const char *s, size_t length) {
      * - It has enough room already allocated
      * - And not too large (avoid large memmove)
      * - And the client is not in a pending I/O state */
-    if (ln->prev != NULL && (prev = listNodeValue(ln->prev)) && prev->size - prev->used > 0 &&
+    if (ln->prev != NULL && (prev = listNodeValue(ln->prev)) && replyBlockAvail(prev) > 0 &&
         c->io_write_state != CLIENT_PENDING_IO) {
-        size_t len_to_copy = prev->size - prev->used;
+        size_t len_to_copy = replyBlockAvail(prev);
         if (len_to_copy > length) len_to_copy = length;
         memcpy(prev->buf + prev->used, s, len_to_copy);
         prev->used += len_to_copy;
@@ -851,7 +1043,7 @@ void setDeferredReply(client *c, void *node, const char *s, size_t length) {
         s += len_to_copy;
     }
 
-    if (ln->next != NULL && (next = listNodeValue(ln->next)) && next->size - next->used >= length &&
+    if (ln->next != NULL && (next = listNodeValue(ln->next)) && replyBlockAvail(next) >= length &&
         next->used < PROTO_REPLY_CHUNK_BYTES * 4 && c->io_write_state != CLIENT_PENDING_IO) {
         memmove(next->buf + length, next->buf, next->used);
         memcpy(next->buf, s, length);
@@ -864,6 +1056,7 @@ void setDeferredReply(client *c, void *node, const char *s, size_t length) {
         /* Take over the allocation's internal fragmentation */
         buf->size = usable_size - sizeof(clientReplyBlock);
         buf->used = length;
+        buf->payload = NULL;
         memcpy(buf->buf, s, length);
         listNodeValue(ln) = buf;
         c->reply_bytes += buf->size;
@@ -1037,6 +1230,7 @@ static void _addReplyLongLongWithPrefix(client *c, long long ll, char prefix) {
 }
 
 void addReplyLongLong(client *c, long long ll) {
+    if (addReplyToSink(c, REPLY_SINK_INTEGER, NULL, 0, ll)) return;
     if (ll == 0)
         addReply(c, shared.czero);
     else if (ll == 1)
@@ -1093,6 +1287,7 @@ void addReplyPushLen(client *c, long length) {
 }
 
 void addReplyNull(client *c) {
+    if (addReplyToSink(c, REPLY_SINK_NULL, NULL, 0, 0)) return;
     if (c->resp == 2) {
         addReplyProto(c, "$-1\r\n", 5);
     } else {
@@ -1129,6 +1324,15 @@ void addReplyBulkLen(client *c, robj *obj) {
 
 /* Add an Object as a bulk reply */
 void addReplyBulk(client *c, robj *obj) {
+    if (c->reply_sink) {
+        if (sdsEncodedObject(obj)) {
+            if (addReplyToSink(c, REPLY_SINK_BULK, obj->ptr, sdslen(obj->ptr), 0)) return;
+        } else if (obj->encoding == OBJ_ENCODING_INT) {
+            char buf[32];
+            size_t len = ll2string(buf, sizeof(buf), (long)obj->ptr);
+            if (addReplyToSink(c, REPLY_SINK_BULK, buf, len, 0)) return;
+        }
+    }
     addReplyBulkLen(c, obj);
     addReply(c, obj);
     addReplyProto(c, "\r\n", 2);
@@ -1137,6 +1341,7 @@ void addReplyBulk(client *c, robj *obj) {
 /* Add a C buffer as bulk reply */
 void addReplyBulkCBuffer(client *c, const void *p, size_t len) {
     if (prepareClientToWrite(c) != C_OK) return;
+    if (addReplyToSink(c, REPLY_SINK_BULK, p, len, 0)) return;
     _addReplyLongLongWithPrefix(c, len, '$');
     _addReplyToBufferOrList(c, p, len);
     _addReplyToBufferOrList(c, "\r\n", 2);
@@ -1151,7 +1356,7 @@ void addWritePreparedReplyBulkCBuffer(writePreparedClient *wpc, const void *p, s
 
 /* Add sds to reply (takes ownership of sds and frees it) */
 void addReplyBulkSds(client *c, sds s) {
-    if (prepareClientToWrite(c) != C_OK) {
+    if (prepareClientToWrite(c) != C_OK || addReplyToSink(c, REPLY_SINK_BULK, s, sdslen(s), 0)) {
         sdsfree(s);
         return;
     }
@@ -1672,6 +1877,7 @@ void freeClient(client *c) {
 
     /* Wait for IO operations to be done before proceeding */
     waitForClientIO(c);
+    freeClientPushQueues(c);
 
     /* For connected clients, call the disconnection event of modules hooks. */
     if (c->conn) {
@@ -1883,6 +2089,9 @@ void beforeNextClient(client *c) {
      * unless aof_fsync is set to always in which case we need to wait for beforeSleep after writing the aof buffer. */
     if (server.aof_fsync != AOF_FSYNC_ALWAYS) {
         trySendWriteToIOThreads(c);
+        /* Without active I/O threads the queued messages wait for beforeSleep,
+         * which activates the I/O threads according to the load. */
+        if (server.active_io_threads_num > 1) sendQueuedPushesToIOThreads();
     }
 }
 
@@ -2107,7 +2316,7 @@ static int writevToClient(client *c) {
             continue;
         }
 
-        iov[iovcnt].iov_base = o->buf + sentlen;
+        iov[iovcnt].iov_base = replyBlockData(o) + sentlen;
         iov[iovcnt].iov_len = used - sentlen;
         iov_bytes_len += iov[iovcnt++].iov_len;
 
@@ -2246,6 +2455,7 @@ int postWriteToClient(client *c) {
     server.stat_total_writes_processed++;
     if (getClientType(c) != CLIENT_TYPE_REPLICA) {
         _postWriteToClient(c);
+        if (c->cmd_phase_write_cmd) cmdPhaseWriteDone(c);
     } else {
         postWriteToReplica(c);
     }
@@ -2296,7 +2506,9 @@ int writeToClient(client *c) {
     if (getClientType(c) == CLIENT_TYPE_REPLICA) {
         writeToReplica(c);
     } else {
+        uint64_t phase_start = c->cmd_phase_write_cmd ? cmdPhaseTimeNs() : 0;
         _writeToClient(c);
+        if (phase_start) c->cmd_phase_write_ns += cmdPhaseTimeNs() - phase_start;
     }
 
     return postWriteToClient(c);
@@ -2459,6 +2671,12 @@ int processClientIOWriteDone(client *c, int allow_async_writes) {
     listUnlinkNode(server.clients_pending_io_write, &c->clients_pending_write_node);
     c->flag.pending_write = 0;
     c->io_write_state = CLIENT_IDLE;
+    if (c->io_push_queue) {
+        processClientIOPushesDone(c);
+    } else if (c->push_queue) {
+        /* Messages were queued while the I/O thread was writing. */
+        closeClientOnOutputBufferLimitReached(c, 1);
+    }
 
     /* Don't post-process-writes to clients that are going to be closed anyway. */
     if (c->flag.close_asap) return 0;
@@ -2510,6 +2728,8 @@ int processIOThreadsWriteDone(void) {
         processed += processClientIOWriteDone(c, 1);
     }
 
+    /* Messages queued while the I/O threads were writing the clients. */
+    sendQueuedPushesToIOThreads();
     return processed;
 }
 
@@ -2519,13 +2739,15 @@ int processIOThreadsWriteDone(void) {
  * get it called, and so forth. */
 int handleClientsWithPendingWrites(void) {
     int processed = 0;
-    int pending_writes = listLength(server.clients_pending_write);
+    int pending_writes = listLength(server.clients_pending_write) + queuedPushesCount();
     if (pending_writes == 0) return processed; /* Return ASAP if there are no clients. */
 
     /* Adjust the number of I/O threads based on the number of pending writes this is required in case pending_writes >
      * poll_events (for example in pubsub) */
     adjustIOThreadsByEventLoad(pending_writes, 1);
 
+    sendQueuedPushesToIOThreads();
+
     listIter li;
     listNode *ln;
     listRewind(server.clients_pending_write, &li);
@@ -2579,6 +2801,8 @@ void resetClient(client *c) {
     c->flag.executing_command = 0;
     c->flag.replication_done = 0;
     c->net_output_bytes_curr_cmd = 0;
+    c->cmd_phase_sampled = 0;
+    c->cmd_phase_parse_ns = 0;
 
     /* Make sure the duration has been recorded to some command. */
     serverAssert(c->duration == 0);
@@ -3098,6 +3322,8 @@ int processPendingCommandAndInputBuffer(client *c) {
  *
  * Sets the client's read_flags to indicate the parsing outcome */
 void parseCommand(client *c) {
+    uint64_t phase_start = cmdPhaseParseStart(c);
+
     /* Determine request type when unknown. */
     if (!c->reqtype) {
         if (c->querybuf[c->qb_pos] == '*') {
@@ -3114,6 +3340,7 @@ void parseCommand(client *c) {
     } else {
         serverPanic("Unknown request type");
     }
+    cmdPhaseParseEnd(c, phase_start);
 }
 
 int canParseCommand(client *c) {
@@ -4536,7 +4763,11 @@ size_t getClientOutputBufferMemoryUsage(client *c) {
         return repl_buf_size + (repl_node_size * repl_node_num);
     } else {
         size_t list_item_size = sizeof(listNode) + sizeof(clientReplyBlock);
-        return c->reply_bytes + (list_item_size * listLength(c->reply));
+        /* Pub/Sub messages queued for the I/O threads count as soon as they
+         * are queued, so that a slow subscriber can't grow past the limits. */
+        size_t push_bytes = (c->push_queue ? c->push_queue->queued_bytes : 0) +
+                            (c->io_push_queue ? c->io_push_queue->queued_bytes : 0);
+        return c->reply_bytes + push_bytes + (list_item_size * listLength(c->reply));
     }
 }
 
@@ -4678,7 +4909,7 @@ int closeClientOnOutputBufferLimitReached(client *c, int async) {
     serverAssert(c->reply_bytes < SIZE_MAX - (1024 * 64));
     /* Note that c->reply_bytes is irrelevant for replica clients
      * (they use the global repl buffers). */
-    if ((c->reply_bytes == 0 && getClientType(c) != CLIENT_TYPE_REPLICA) ||
+    if ((c->reply_bytes == 0 && !c->push_queue && !c->io_push_queue && getClientType(c) != CLIENT_TYPE_REPLICA) ||
         (c->flag.close_asap && !(c->flag.protected_rdb_channel)))
         return 0;
     if (checkClientOutputBufferLimits(c)) {
@@ -5139,7 +5370,9 @@ void ioThreadWriteToClient(void *data) {
     if (c->write_flags & WRITE_FLAGS_IS_REPLICA) {
         writeToReplica(c);
     } else {
+        uint64_t phase_start = c->cmd_phase_write_cmd ? cmdPhaseTimeNs() : 0;
         _writeToClient(c);
+        if (phase_start) c->cmd_phase_write_ns += cmdPhaseTimeNs() - phase_start;
     }
 
     atomic_thread_fence(memory_order_release);
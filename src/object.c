@@ -35,6 +35,7 @@
 #include "zmalloc.h"
 #include "sds.h"
 #include "module.h"
+#include "keysizes.h"
 #include <math.h>
 #include <ctype.h>
 
@@ -1113,7 +1114,6 @@ char *strEncoding(int encoding) {
  * Note that the returned value is just an approximation, especially in the
  * case of aggregated data types where only "sample_size" elements
  * are checked and averaged to estimate the total size. */
-#define OBJ_COMPUTE_SIZE_DEF_SAMPLES 5 /* Default sample size. */
 size_t objectComputeSize(robj *key, robj *o, size_t sample_size, int dbid) {
     size_t asize = 0, elesize = 0, samples = 0;
 
@@ -1246,6 +1246,7 @@ size_t objectComputeSize(robj *key, robj *o, size_t sample_size, int dbid) {
                 streamCG *cg = ri.data;
                 asize += sizeof(*cg);
                 asize += raxAllocSize(cg->pel);
+                if (cg->pel_by_time) asize += raxAllocSize(cg->pel_by_time);
                 asize += sizeof(streamNACK) * raxSize(cg->pel);
 
                 /* For each consumer we also need to add the basic data
@@ -1658,6 +1659,10 @@ void memoryCommand(client *c) {
         const char *help[] = {
             "DOCTOR",
             "    Return memory problems reports.",
+            "KEYSIZES",
+            "    Return histograms of the number of elements of the keys per type, and the",
+            "    histograms of their memory usage and the biggest keys as of the last pass",
+            "    of the keyspace scan enabled by keysizes-scan-cpu-percent.",
             "MALLOC-STATS",
             "    Return internal statistics report from the memory allocator.",
             "PURGE",
@@ -1823,6 +1828,8 @@ void memoryCommand(client *c) {
             addReply(c, shared.ok);
         else
             addReplyError(c, "Error purging dirty pages");
+    } else if (!strcasecmp(c->argv[1]->ptr, "keysizes") && c->argc == 2) {
+        keysizesReply(c);
     } else {
         addReplySubcommandSyntaxError(c);
     }
@@ -30,6 +30,7 @@
 #include "server.h"
 #include "cluster.h"
 #include "cluster_slot_stats.h"
+#include "io_threads.h"
 
 /* Structure to hold the pubsub related metadata. Currently used
  * for pubsub and pubsubshard feature. */
@@ -135,6 +136,67 @@ void addReplyPubsubPatMessage(client *c, robj *pat, robj *channel, robj *msg) {
     if (!old_flags.pushing) c->flag.pushing = 0;
 }
 
+/* Large messages published to more than one client are encoded only once per
+ * protocol version, into payloads shared by the output buffers of all the
+ * receivers (see addReplySharedPayload()), instead of being copied into each
+ * one of them. */
+typedef struct pubsubSharedMessage {
+    robj *message_bulk;             /* Message type, like shared.messagebulk. */
+    robj *pattern;                  /* Matching pattern, NULL unless "pmessage". */
+    robj *channel;
+    robj *msg;
+    unsigned long receivers;        /* Expected number of receivers. */
+    sharedReplyPayload *payload[2]; /* RESP2 and RESP3 encodings, created on demand. */
+} pubsubSharedMessage;
+
+/* Return true if a message is worth sharing between its receivers. */
+static int pubsubShouldShareMessage(robj *msg, unsigned long receivers) {
+    return receivers > 1 && stringObjectLen(msg) >= PROTO_REPLY_SHARE_MIN_BYTES;
+}
+
+static sds pubsubCatBulk(sds proto, robj *o) {
+    o = getDecodedObject(o);
+    proto = sdscatfmt(proto, "$%U\r\n", (unsigned long long)sdslen(o->ptr));
+    proto = sdscatlen(proto, o->ptr, sdslen(o->ptr));
+    proto = sdscatlen(proto, "\r\n", 2);
+    decrRefCount(o);
+    return proto;
+}
+
+/* Return the payload of the shared message for the given protocol version,
+ * encoding it the same way addReplyPubsubMessage() and
+ * addReplyPubsubPatMessage() do the first time it is needed. */
+static sharedReplyPayload *pubsubGetSharedMessagePayload(pubsubSharedMessage *m, int resp) {
+    int idx = resp == 2 ? 0 : 1;
+    if (m->payload[idx]) return m->payload[idx];
+
+    sds proto = sdsnewlen(resp == 2 ? "*" : ">", 1);
+    proto = sdscatfmt(proto, "%i\r\n", m->pattern ? 4 : 3);
+    proto = sdscatsds(proto, m->message_bulk->ptr);
+    if (m->pattern) proto = pubsubCatBulk(proto, m->pattern);
+    proto = pubsubCatBulk(proto, m->channel);
+    proto = pubsubCatBulk(proto, m->msg);
+    m->payload[idx] = createSharedReplyPayload(proto, sdslen(proto), m->receivers);
+    sdsfree(proto);
+    return m->payload[idx];
+}
+
+static void pubsubReleaseSharedMessage(pubsubSharedMessage *m) {
+    for (int j = 0; j < 2; j++) {
+        if (m->payload[j]) releaseSharedReplyPayload(m->payload[j]);
+        m->payload[j] = NULL;
+    }
+}
+
+/* Send a shared pubsub message of type "message", "smessage" or "pmessage"
+ * to the client. */
+static void addReplyPubsubSharedMessage(client *c, pubsubSharedMessage *m) {
+    struct ClientFlags old_flags = c->flag;
+    c->flag.pushing = 1;
+    addReplySharedPayload(c, pubsubGetSharedMessagePayload(m, c->resp));
+    if (!old_flags.pushing) c->flag.pushing = 0;
+}
+
 /* Send the pubsub subscription notification to the client. */
 void addReplyPubsubSubscribed(client *c, robj *channel, pubsubtype type) {
     struct ClientFlags old_flags = c->flag;
@@ -391,6 +453,109 @@ void pubsubShardUnsubscribeAllChannelsInSlot(unsigned int slot) {
     kvstoreReleaseHashtableIterator(kvs_di);
 }
 
+/*-----------------------------------------------------------------------------
+ * Pattern subscriptions index
+ *
+ * Pattern subscriptions are indexed by their literal prefix, that is the
+ * leading part of the pattern that contains no glob special character. The
+ * index is a radix tree mapping every prefix to a dict of the patterns sharing
+ * it (pattern -> clients dict). When a message is published, only the
+ * patterns whose prefix is also a prefix of the channel need to be evaluated.
+ *----------------------------------------------------------------------------*/
+
+/* Every indexed pattern caches its compiled matcher, so that publishing
+ * doesn't need to parse the pattern again. */
+typedef struct pubsubIndexedPattern {
+    dict *clients;
+    stringMatcher matcher;
+} pubsubIndexedPattern;
+
+/* Add 'pattern' to the index. The index takes its own reference to the
+ * pattern object, while the 'clients' dict is just referenced. */
+void pubsubPatternIndexAdd(rax *index, robj *pattern, dict *clients) {
+    sds p = pattern->ptr;
+    pubsubIndexedPattern *ip = zmalloc(sizeof(*ip));
+    void *found;
+    dict *patterns;
+
+    ip->clients = clients;
+    stringMatcherInit(&ip->matcher, p, sdslen(p), 0);
+    if (raxFind(index, (unsigned char *)p, ip->matcher.prefixlen, &found)) {
+        patterns = found;
+    } else {
+        patterns = dictCreate(&objectKeyHeapPointerValueDictType);
+        raxInsert(index, (unsigned char *)p, ip->matcher.prefixlen, patterns, NULL);
+    }
+    serverAssert(dictAdd(patterns, pattern, ip) == DICT_OK);
+    incrRefCount(pattern);
+}
+
+/* Remove 'pattern' from the index, if present. */
+void pubsubPatternIndexDelete(rax *index, robj *pattern) {
+    sds p = pattern->ptr;
+    stringMatcher matcher;
+    void *found;
+
+    stringMatcherInit(&matcher, p, sdslen(p), 0);
+    if (!raxFind(index, (unsigned char *)p, matcher.prefixlen, &found)) return;
+    dict *patterns = found;
+    dictDelete(patterns, pattern);
+    if (dictSize(patterns) == 0) {
+        raxRemove(index, (unsigned char *)p, matcher.prefixlen, NULL);
+        dictRelease(patterns);
+    }
+}
+
+typedef struct pubsubPatternMatchCtx {
+    sds channel;
+    pubsubPatternMatchCallback callback;
+    void *privdata;
+    int matches;
+} pubsubPatternMatchCtx;
+
+/* raxFindPrefixes() callback: evaluate the patterns of a prefix of the
+ * channel. */
+static void pubsubPatternIndexMatchPrefix(size_t prefixlen, void *data, void *privdata) {
+    pubsubPatternMatchCtx *ctx = privdata;
+    dict *patterns = data;
+    dictIterator *di = dictGetIterator(patterns);
+    dictEntry *de;
+    UNUSED(prefixlen);
+
+    while ((de = dictNext(di)) != NULL) {
+        pubsubIndexedPattern *ip = dictGetVal(de);
+        if (!stringMatcherMatch(&ip->matcher, ctx->channel, sdslen(ctx->channel))) continue;
+        ctx->callback(dictGetKey(de), ip->clients, ctx->privdata);
+        ctx->matches++;
+    }
+    dictReleaseIterator(di);
+}
+
+/* Call 'callback' for every indexed pattern matching 'channel'. Returns the
+ * number of matching patterns.
+ *
+ * The index is walked a single time along the channel name. The patterns are
+ * visited in order of increasing literal prefix length (so "*" comes before
+ * "news.*", that comes before "news.sports.*"), and in no particular order
+ * among the patterns sharing the same prefix. This is the order in which the
+ * pattern messages are delivered. The callback must not modify the index. */
+int pubsubPatternIndexMatch(rax *index, sds channel, pubsubPatternMatchCallback callback, void *privdata) {
+    pubsubPatternMatchCtx ctx = {channel, callback, privdata, 0};
+
+    if (raxSize(index) == 0) return 0;
+    raxFindPrefixes(index, (unsigned char *)channel, sdslen(channel), pubsubPatternIndexMatchPrefix, &ctx);
+    return ctx.matches;
+}
+
+static void pubsubPatternIndexFreeCallback(void *patterns) {
+    dictRelease(patterns);
+}
+
+/* Free the index and release the references it holds to the patterns. */
+void pubsubPatternIndexRelease(rax *index) {
+    raxFreeWithCallback(index, pubsubPatternIndexFreeCallback);
+}
+
 /* Subscribe a client to a pattern. Returns 1 if the operation succeeded, or 0 if the client was already subscribed to
  * that pattern. */
 int pubsubSubscribePattern(client *c, robj *pattern) {
@@ -409,6 +574,7 @@ int pubsubSubscribePattern(client *c, robj *pattern) {
             clients = dictCreate(&clientDictType);
             dictAdd(server.pubsub_patterns, pattern, clients);
             incrRefCount(pattern);
+            pubsubPatternIndexAdd(server.pubsub_patterns_index, pattern, clients);
         } else {
             clients = dictGetVal(de);
         }
@@ -439,6 +605,7 @@ int pubsubUnsubscribePattern(client *c, robj *pattern, int notify) {
         if (dictSize(clients) == 0) {
             /* Free the dict and associated hash entry at all if this was
              * the latest client. */
+            pubsubPatternIndexDelete(server.pubsub_patterns_index, pattern);
             dictDelete(server.pubsub_patterns, pattern);
         }
     }
@@ -508,14 +675,48 @@ int pubsubUnsubscribeAllPatterns(client *c, int notify) {
     return count;
 }
 
+/* State shared with pubsubDeliverPatternMessage() while publishing. */
+typedef struct pubsubPatternDelivery {
+    robj *channel;
+    robj *message;
+    int receivers;
+} pubsubPatternDelivery;
+
+/* Deliver the message to the clients subscribed to a matching pattern. */
+static void pubsubDeliverPatternMessage(robj *pattern, dict *clients, void *privdata) {
+    pubsubPatternDelivery *delivery = privdata;
+    pubsubSharedMessage shared_msg = {.message_bulk = shared.pmessagebulk,
+                                      .pattern = pattern,
+                                      .channel = delivery->channel,
+                                      .msg = delivery->message,
+                                      .receivers = dictSize(clients)};
+    int share = pubsubShouldShareMessage(delivery->message, dictSize(clients));
+    int fanout = shouldFanoutPushesToIOThreads(dictSize(clients));
+    dictEntry *entry;
+    dictIterator *iter = dictGetIterator(clients);
+    while ((entry = dictNext(iter)) != NULL) {
+        client *c = dictGetKey(entry);
+        if (fanout && tryQueuePushToIOThreads(c, pubsubGetSharedMessagePayload(&shared_msg, c->resp)) == C_OK) {
+            delivery->receivers++;
+            continue;
+        }
+        if (share)
+            addReplyPubsubSharedMessage(c, &shared_msg);
+        else
+            addReplyPubsubPatMessage(c, pattern, delivery->channel, delivery->message);
+        updateClientMemUsageAndBucket(c);
+        delivery->receivers++;
+    }
+    dictReleaseIterator(iter);
+    pubsubReleaseSharedMessage(&shared_msg);
+}
+
 /*
  * Publish a message to all the subscribers.
  */
 int pubsubPublishMessageInternal(robj *channel, robj *message, pubsubtype type) {
     int receivers = 0;
     void *element;
-    dictEntry *de;
-    dictIterator *di;
     int slot = -1;
 
     /* Send to clients listening for that channel */
@@ -524,16 +725,33 @@ int pubsubPublishMessageInternal(robj *channel, robj *message, pubsubtype type)
     }
     if (kvstoreHashtableFind(*type.serverPubSubChannels, (slot == -1) ? 0 : slot, channel, &element)) {
         dict *clients = element;
+        pubsubSharedMessage shared_msg = {.message_bulk = *type.messageBulk,
+                                          .channel = channel,
+                                          .msg = message,
+                                          .receivers = dictSize(clients)};
+        int share = pubsubShouldShareMessage(message, dictSize(clients));
+        /* With many subscribers, the I/O threads append the message to the
+         * output buffers, the main thread only encodes it once per protocol. */
+        int fanout = shouldFanoutPushesToIOThreads(dictSize(clients));
         dictEntry *entry;
         dictIterator *iter = dictGetIterator(clients);
         while ((entry = dictNext(iter)) != NULL) {
             client *c = dictGetKey(entry);
-            addReplyPubsubMessage(c, channel, message, *type.messageBulk);
+            if (fanout && tryQueuePushToIOThreads(c, pubsubGetSharedMessagePayload(&shared_msg, c->resp)) == C_OK) {
+                clusterSlotStatsAddNetworkBytesOutForShardedPubSubInternalPropagation(c, slot);
+                receivers++;
+                continue;
+            }
+            if (share)
+                addReplyPubsubSharedMessage(c, &shared_msg);
+            else
+                addReplyPubsubMessage(c, channel, message, *type.messageBulk);
             clusterSlotStatsAddNetworkBytesOutForShardedPubSubInternalPropagation(c, slot);
             updateClientMemUsageAndBucket(c);
             receivers++;
         }
         dictReleaseIterator(iter);
+        pubsubReleaseSharedMessage(&shared_msg);
     }
 
     if (type.shard) {
@@ -542,29 +760,12 @@ int pubsubPublishMessageInternal(robj *channel, robj *message, pubsubtype type)
     }
 
     /* Send to clients listening to matching channels */
-    di = dictGetIterator(server.pubsub_patterns);
-    if (di) {
-        channel = getDecodedObject(channel);
-        while ((de = dictNext(di)) != NULL) {
-            robj *pattern = dictGetKey(de);
-            dict *clients = dictGetVal(de);
-            if (!stringmatchlen((char *)pattern->ptr, sdslen(pattern->ptr), (char *)channel->ptr, sdslen(channel->ptr),
-                                0))
-                continue;
-
-            dictEntry *entry;
-            dictIterator *iter = dictGetIterator(clients);
-            while ((entry = dictNext(iter)) != NULL) {
-                client *c = dictGetKey(entry);
-                addReplyPubsubPatMessage(c, pattern, channel, message);
-                updateClientMemUsageAndBucket(c);
-                receivers++;
-            }
-            dictReleaseIterator(iter);
-        }
-        decrRefCount(channel);
-        dictReleaseIterator(di);
-    }
+    pubsubPatternDelivery delivery = {.message = message, .receivers = 0};
+    delivery.channel = getDecodedObject(channel);
+    pubsubPatternIndexMatch(server.pubsub_patterns_index, delivery.channel->ptr, pubsubDeliverPatternMessage,
+                            &delivery);
+    decrRefCount(delivery.channel);
+    receivers += delivery.receivers;
     return receivers;
 }
 
@@ -917,6 +917,37 @@ int raxFind(rax *rax, unsigned char *s, size_t len, void **value) {
     return 1;
 }
 
+/* Call 'fn' for every element of the radix tree that is a prefix of the
+ * string 's' of 'len' bytes, including 's' itself and the empty string, in
+ * order of increasing length. Unlike calling raxFind() for every possible
+ * prefix, the tree is walked a single time following 's'. The callback
+ * receives the length of the prefix and the associated value, and must not
+ * modify the radix tree. */
+void raxFindPrefixes(rax *rax, unsigned char *s, size_t len, raxPrefixCallback fn, void *privdata) {
+    raxNode *h = rax->head;
+    size_t i = 0; /* Position in the string. */
+
+    while (1) {
+        if (h->iskey) fn(i, raxGetData(h), privdata);
+        if (h->size == 0 || i == len) break;
+
+        size_t j; /* Position in the node children. */
+        if (h->iscompr) {
+            if (h->size > len - i || memcmp(h->data, s + i, h->size) != 0) break;
+            i += h->size;
+            j = 0; /* Compressed node only child is at index 0. */
+        } else {
+            for (j = 0; j < h->size; j++) {
+                if (h->data[j] == s[i]) break;
+            }
+            if (j == h->size) break;
+            i++;
+        }
+        raxNode **children = raxNodeFirstChildPtr(h);
+        memcpy(&h, children + j, sizeof(h));
+    }
+}
+
 /* Return the memory address where the 'parent' node stores the specified
  * 'child' pointer, so that the caller can update the pointer with another
  * one if needed. The function assumes it will find a match, otherwise the
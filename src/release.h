@@ -0,0 +1,5 @@
+#define REDIS_GIT_SHA1 "1277fdc8"
+#define REDIS_GIT_DIRTY "271"
+#define REDIS_BUILD_ID "vm-1792281849"
+#include "version.h"
+#define REDIS_BUILD_ID_RAW SERVER_NAME VALKEY_VERSION REDIS_BUILD_ID REDIS_GIT_DIRTY REDIS_GIT_SHA1
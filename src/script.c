@@ -295,6 +295,18 @@ int scriptIsEval(void) {
     return curr_run_ctx->flags & SCRIPT_EVAL_MODE;
 }
 
+/* Return 1 if the command 'cmd' of another client can be executed while the
+ * current script is timed out, besides the 'allow-busy' commands. If the
+ * script can't write, the read-only commands can't change what it observes,
+ * so they are allowed when busy-script-allow-reads is enabled. Commands that
+ * may run scripts or block are never allowed. */
+int scriptAllowCommandWhileBusy(struct serverCommand *cmd) {
+    if (!server.busy_script_allow_reads || !scriptIsTimedout()) return 0;
+    if (!(curr_run_ctx->flags & SCRIPT_READ_ONLY)) return 0;
+    if (!(cmd->flags & CMD_READONLY)) return 0;
+    return !(cmd->flags & (CMD_WRITE | CMD_MAY_REPLICATE | CMD_NOSCRIPT | CMD_BLOCKING | CMD_MODULE));
+}
+
 /* Kill the current running script */
 void scriptKill(client *c, int is_eval) {
     if (!curr_run_ctx) {
@@ -112,6 +112,7 @@ int scriptIsRunning(void);
 const char *scriptCurrFunction(void);
 int scriptIsEval(void);
 int scriptIsTimedout(void);
+int scriptAllowCommandWhileBusy(struct serverCommand *cmd);
 client *scriptGetClient(void);
 client *scriptGetCaller(void);
 long long scriptRunDuration(void);
@@ -32,6 +32,9 @@
 #include "cluster.h"
 #include "cluster_slot_stats.h"
 #include "commandlog.h"
+#include "hotkeys.h"
+#include "commandphase.h"
+#include "keysizes.h"
 #include "bio.h"
 #include "latency.h"
 #include "mt19937-64.h"
@@ -1234,8 +1237,9 @@ long long clientsTimeProc(struct aeEventLoop *eventLoop, long long id, void *cli
     const int MIN_CLIENTS_PER_CYCLE = 5;
     const int MAX_CLIENTS_PER_CYCLE = 200;
 
-    monotime start_time;
+    monotime start_time, phase_start;
     elapsedStart(&start_time);
+    elPhaseStartMonitor(phase_start);
 
     int numclients = listLength(server.clients);
     int clients_this_cycle = numclients / server.hz; /* Initial computation based on standard hz */
@@ -1258,6 +1262,7 @@ long long clientsTimeProc(struct aeEventLoop *eventLoop, long long id, void *cli
 
     server.clients_hz = 1000 / delay_ms;
     server.el_cron_duration += elapsedUs(start_time);
+    elPhaseEndMonitor(EL_PHASE_CLIENTS_CRON, phase_start);
     return delay_ms;
 }
 
@@ -1278,6 +1283,9 @@ void databasesCron(void) {
     /* Start active defrag cycle or adjust defrag CPU if needed. */
     monitorActiveDefrag();
 
+    /* Scan a part of the keyspace to update the key sizes histograms. */
+    keysizesCron();
+
     /* Perform hash tables rehashing if needed, but only if there are no
      * other processes saving the DB on disk. Otherwise rehashing is bad
      * as will cause a lot of copy-on-write of memory pages. */
@@ -1492,6 +1500,8 @@ long long serverCron(struct aeEventLoop *eventLoop, long long id, void *clientDa
     if (server.pause_cron) return 1000 / server.hz;
 
     monotime cron_start = getMonotonicUs();
+    monotime phase_start;
+    elPhaseStartMonitor(phase_start);
 
     run_with_period(100) {
         monotime current_time = getMonotonicUs();
@@ -1574,7 +1584,9 @@ long long serverCron(struct aeEventLoop *eventLoop, long long id, void *clientDa
     }
 
     /* Handle background operations on databases. */
+    elPhaseEndMonitor(EL_PHASE_SERVER_CRON, phase_start);
     databasesCron();
+    elPhaseEndMonitor(EL_PHASE_DATABASES_CRON, phase_start);
 
     /* Start a scheduled AOF rewrite if this was requested by the user while
      * a BGSAVE was in progress. */
@@ -1698,6 +1710,7 @@ long long serverCron(struct aeEventLoop *eventLoop, long long id, void *clientDa
     server.cronloops++;
 
     server.el_cron_duration += elapsedUs(cron_start);
+    elPhaseEndMonitor(EL_PHASE_SERVER_CRON, phase_start);
 
     return 1000 / server.hz;
 }
@@ -1817,25 +1830,37 @@ void beforeSleep(struct aeEventLoop *eventLoop) {
         return;
     }
 
+    /* Account the time spent processing the events fired in this iteration,
+     * then time each of the phases below. */
+    monotime phase_start;
+    elPhaseStartMonitor(phase_start);
+    if (phase_start && server.el_start > 0) elPhaseAddEventsTime(phase_start - server.el_start);
+
     /* We should handle pending reads clients ASAP after event loop. */
     processIOThreadsReadDone();
+    elPhaseEndMonitor(EL_PHASE_IO_READS, phase_start);
 
     /* Handle pending data(typical TLS). (must be done before flushAppendOnlyFile) */
     connTypeProcessPendingData();
 
     /* If any connection type(typical TLS) still has pending unread data don't sleep at all. */
     int dont_sleep = connTypeHasPendingData();
+    elPhaseEndMonitor(EL_PHASE_CONN_PENDING, phase_start);
 
     /* Call the Cluster before sleep function. Note that this function
      * may change the state of Cluster (from ok to fail or vice versa),
      * so it's a good idea to call it before serving the unblocked clients
      * later in this function, must be done before blockedBeforeSleep. */
-    if (server.cluster_enabled) clusterBeforeSleep();
+    if (server.cluster_enabled) {
+        clusterBeforeSleep();
+        elPhaseEndMonitor(EL_PHASE_CLUSTER, phase_start);
+    }
 
     /* Handle blocked clients.
      * must be done before flushAppendOnlyFile, in case of appendfsync=always,
      * since the unblocked clients may write data. */
     blockedBeforeSleep();
+    elPhaseEndMonitor(EL_PHASE_BLOCKED, phase_start);
 
     /* Record cron time in beforeSleep, which is the sum of active-expire, active-defrag and all other
      * tasks done by cron and beforeSleep, but excluding read, write and AOF, that are counted by other
@@ -1844,10 +1869,14 @@ void beforeSleep(struct aeEventLoop *eventLoop) {
 
     /* Run a fast expire cycle (the called function will return
      * ASAP if a fast cycle is not needed). */
-    if (server.active_expire_enabled && !server.import_mode && iAmPrimary()) activeExpireCycle(ACTIVE_EXPIRE_CYCLE_FAST);
+    if (server.active_expire_enabled && !server.import_mode && iAmPrimary()) {
+        activeExpireCycle(ACTIVE_EXPIRE_CYCLE_FAST);
+        elPhaseEndMonitor(EL_PHASE_ACTIVE_EXPIRE, phase_start);
+    }
 
     if (moduleCount()) {
         moduleFireServerEvent(VALKEYMODULE_EVENT_EVENTLOOP, VALKEYMODULE_SUBEVENT_EVENTLOOP_BEFORE_SLEEP, NULL);
+        elPhaseEndMonitor(EL_PHASE_MODULES, phase_start);
     }
 
     /* Send all the replicas an ACK request if at least one client blocked
@@ -1868,6 +1897,7 @@ void beforeSleep(struct aeEventLoop *eventLoop) {
      * this can't be done where the ACK is received since failover will disconnect
      * our clients. */
     updateFailoverStatus();
+    elPhaseEndMonitor(EL_PHASE_REPLICATION, phase_start);
 
     /* Since we rely on current_client to send scheduled invalidation messages
      * we have to flush them after each command, so when we get here, the list
@@ -1878,6 +1908,7 @@ void beforeSleep(struct aeEventLoop *eventLoop) {
     /* Send the invalidation messages to clients participating to the
      * client side caching protocol in broadcasting (BCAST) mode. */
     trackingBroadcastInvalidationMessages();
+    elPhaseEndMonitor(EL_PHASE_TRACKING, phase_start);
 
     /* Record time consumption of AOF writing. */
     monotime aof_start_time = getMonotonicUs();
@@ -1905,29 +1936,39 @@ void beforeSleep(struct aeEventLoop *eventLoop) {
          * wake them up ASAP. */
         if (listLength(server.clients_waiting_acks) && prev_fsynced_reploff != server.fsynced_reploff) dont_sleep = 1;
     }
+    elPhaseEndMonitor(EL_PHASE_AOF, phase_start);
 
     /* Handle writes with pending output buffers. */
     handleClientsWithPendingWrites();
+    elPhaseEndMonitor(EL_PHASE_WRITES, phase_start);
 
     /* Try to process more IO reads that are ready to be processed. */
     if (server.aof_fsync != AOF_FSYNC_ALWAYS) {
         processIOThreadsReadDone();
+        elPhaseEndMonitor(EL_PHASE_IO_READS, phase_start);
     }
 
     processIOThreadsWriteDone();
+    elPhaseEndMonitor(EL_PHASE_IO_WRITES, phase_start);
 
     /* Record cron time in beforeSleep. This does not include the time consumed by AOF writing and IO writing above. */
     monotime cron_start_time_after_write = getMonotonicUs();
 
     /* Close clients that need to be closed asynchronous */
     freeClientsInAsyncFreeQueue();
+    elPhaseEndMonitor(EL_PHASE_FREE_CLIENTS, phase_start);
 
     /* Incrementally trim replication backlog, 10 times the normal speed is
      * to free replication backlog as much as possible. */
-    if (server.repl_backlog) incrementalTrimReplicationBacklog(10 * REPL_BACKLOG_TRIM_BLOCKS_PER_CALL);
+    if (server.repl_backlog) {
+        incrementalTrimReplicationBacklog(10 * REPL_BACKLOG_TRIM_BLOCKS_PER_CALL);
+        elPhaseEndMonitor(EL_PHASE_REPLICATION, phase_start);
+    }
 
     /* Disconnect some clients if they are consuming too much memory. */
     evictClients();
+    elPhaseEndMonitor(EL_PHASE_EVICT_CLIENTS, phase_start);
+    elPhaseEndIteration();
 
     /* Record cron time in beforeSleep. */
     monotime duration_after_write = getMonotonicUs() - cron_start_time_after_write;
@@ -2215,6 +2256,7 @@ void initServerConfig(void) {
     memset(server.listeners, 0x00, sizeof(server.listeners));
     server.active_expire_enabled = 1;
     server.lazy_expire_disabled = 0;
+    server.busy_script_read = 0;
     server.skip_checksum_validation = 0;
     server.loading = 0;
     server.async_loading = 0;
@@ -2709,8 +2751,10 @@ void resetServerStats(void) {
     server.stat_io_reads_processed = 0;
     server.stat_total_reads_processed = 0;
     server.stat_io_writes_processed = 0;
+    server.stat_io_pubsub_messages = 0;
     server.stat_io_freed_objects = 0;
     server.stat_io_accept_offloaded = 0;
+    server.stat_tls_ktls_send_connections = 0;
     server.stat_poll_processed_by_io_threads = 0;
     server.stat_total_writes_processed = 0;
     server.stat_client_qbuf_limit_disconnections = 0;
@@ -2731,10 +2775,12 @@ void resetServerStats(void) {
     server.stat_unexpected_error_replies = 0;
     server.stat_total_error_replies = 0;
     server.stat_dump_payload_sanitizations = 0;
+    server.stat_tracking_invalidations_batched = 0;
     server.aof_delayed_fsync = 0;
     server.stat_reply_buffer_shrinks = 0;
     server.stat_reply_buffer_expands = 0;
     memset(server.duration_stats, 0, sizeof(durationStats) * EL_DURATION_TYPE_NUM);
+    elPhaseResetStats();
     server.el_cmd_cnt_max = 0;
     lazyfreeResetStats();
 }
@@ -2832,6 +2878,7 @@ void initServer(void) {
         server.db[j].keys = kvstoreCreate(&kvstoreKeysHashtableType, slot_count_bits, flags);
         server.db[j].expires = kvstoreCreate(&kvstoreExpiresHashtableType, slot_count_bits, flags);
         server.db[j].expires_cursor = 0;
+        server.db[j].keysizes = keysizesHistCreate();
         server.db[j].blocking_keys = dictCreate(&keylistDictType);
         server.db[j].blocking_keys_unblock_on_nokey = dictCreate(&objectKeyPointerValueDictType);
         server.db[j].ready_keys = dictCreate(&objectKeyPointerValueDictType);
@@ -2845,6 +2892,7 @@ void initServer(void) {
      * (which has to be kvstore), see pubsubtype.serverPubSubChannels */
     server.pubsub_channels = kvstoreCreate(&kvstoreChannelHashtableType, 0, KVSTORE_ALLOCATE_HASHTABLES_ON_DEMAND);
     server.pubsub_patterns = dictCreate(&objToDictDictType);
+    server.pubsub_patterns_index = raxNew();
     server.pubsubshard_channels = kvstoreCreate(&kvstoreChannelHashtableType, slot_count_bits,
                                                 KVSTORE_ALLOCATE_HASHTABLES_ON_DEMAND | KVSTORE_FREE_EMPTY_HASHTABLES);
     server.pubsub_clients = 0;
@@ -2965,6 +3013,7 @@ void initServer(void) {
     evalInit();
 
     commandlogInit();
+    hotkeysInit();
     latencyMonitorInit();
     initSharedQueryBuf();
 
@@ -3275,6 +3324,8 @@ void resetCommandTableStats(hashtable *commands) {
             hdr_close(c->latency_histogram);
             c->latency_histogram = NULL;
         }
+        c->phase_samples = 0;
+        memset(c->phase_ns, 0, sizeof(c->phase_ns));
         if (c->subcommands_ht) resetCommandTableStats(c->subcommands_ht);
     }
     hashtableResetIterator(&iter);
@@ -3589,6 +3640,27 @@ static void propagatePendingCommands(void) {
     serverOpArrayFree(&server.also_propagate);
 }
 
+/* Run a command that scriptAllowCommandWhileBusy() lets through at a yield
+ * point of a busy read-only script. The command is nested in the script
+ * execution unit, so it gets a time snapshot of its own, it doesn't delete
+ * the expired keys it finds, and whatever it propagates (e.g. from a module
+ * keyspace event) is propagated right after it, not inside the script unit. */
+static void callWhileScriptBusy(client *c, int flags) {
+    mstime_t prev_cmd_time_snapshot = server.cmd_time_snapshot;
+    serverOpArray prev_also_propagate = server.also_propagate;
+
+    updateCachedTime(0);
+    server.cmd_time_snapshot = server.mstime;
+    server.also_propagate = (serverOpArray){0};
+    server.busy_script_read++;
+    call(c, flags);
+    server.busy_script_read--;
+    propagatePendingCommands();
+    zfree(server.also_propagate.ops);
+    server.also_propagate = prev_also_propagate;
+    server.cmd_time_snapshot = prev_cmd_time_snapshot;
+}
+
 /* Performs operations that should be performed after an execution unit ends.
  * Execution unit is a code that should be done atomically.
  * Execution units can be nested and do not necessarily start with a server command.
@@ -3697,6 +3769,10 @@ void call(client *c, int flags) {
      * called. For example this is required for avoiding double logging to monitors.*/
     int reprocessing_command = flags & CMD_CALL_REPROCESSING;
 
+    /* Only the commands executed directly by clients are sampled by the
+     * command phase profiler, the nested ones are accounted to the caller. */
+    int phase_sampled = c->cmd_phase_sampled && update_command_stats && !server.execution_nesting;
+
     /* Initialization: clear the flags that must be set by the command on
      * demand, and initialize the array for additional commands propagation. */
     c->flag.force_aof = 0;
@@ -3732,7 +3808,15 @@ void call(client *c, int flags) {
     monotime monotonic_start = 0;
     if (monotonicGetType() == MONOTONIC_CLOCK_HW) monotonic_start = getMonotonicUs();
 
+    unsigned long long prev_output_bytes = c->net_output_bytes_curr_cmd;
+    if (phase_sampled) cmdPhaseCommandStart();
     c->cmd->proc(c);
+    if (phase_sampled) cmdPhaseCommandEnd(c, real_cmd);
+
+    /* Attribute the reply of the command to the keys it looked up that
+     * were sampled by the hot keys tracking. */
+    if (server.hotkeys_pending_keys)
+        hotkeysFlushPendingReplyBytes((long long)(c->net_output_bytes_curr_cmd - prev_output_bytes));
 
     /* Clear the CLIENT_REPROCESSING_COMMAND flag after the proc is executed. */
     if (reprocessing_command) c->flag.reprocessing_command = 0;
@@ -4317,7 +4401,7 @@ int processCommand(client *c) {
      * the MULTI plus a few initial commands refused, then the timeout
      * condition resolves, and the bottom-half of the transaction gets
      * executed, see Github PR #7022. */
-    if (isInsideYieldingLongCommand() && !(c->cmd->flags & CMD_ALLOW_BUSY)) {
+    if (isInsideYieldingLongCommand() && !(c->cmd->flags & CMD_ALLOW_BUSY) && !scriptAllowCommandWhileBusy(c->cmd)) {
         if (server.busy_module_yield_flags && server.busy_module_yield_reply) {
             rejectCommandFormat(c, "-BUSY %s", server.busy_module_yield_reply);
         } else if (server.busy_module_yield_flags) {
@@ -4355,7 +4439,10 @@ int processCommand(client *c) {
     } else {
         int flags = CMD_CALL_FULL;
         if (client_reprocessing_command) flags |= CMD_CALL_REPROCESSING;
-        call(c, flags);
+        if (isInsideYieldingLongCommand() && scriptAllowCommandWhileBusy(c->cmd))
+            callWhileScriptBusy(c, flags);
+        else
+            call(c, flags);
         if (listLength(server.ready_keys) && !isInsideYieldingLongCommand()) handleClientsBlockedOnKeys();
     }
     return C_OK;
@@ -5945,6 +6032,9 @@ sds genValkeyInfoString(dict *section_dict, int all_sections, int everything) {
             server.stat_last_eviction_exceeded_time ? (long long)elapsedUs(server.stat_last_eviction_exceeded_time) : 0;
         long long current_active_defrag_time =
             server.stat_last_active_defrag_time ? (long long)elapsedUs(server.stat_last_active_defrag_time) : 0;
+        size_t tls_handshake_queue_depth;
+        long long tls_handshake_jobs, tls_handshake_latency;
+        getTLSHandshakeThreadsStats(&tls_handshake_queue_depth, &tls_handshake_jobs, &tls_handshake_latency);
 
         if (sections++) info = sdscat(info, "\r\n");
         info = sdscatprintf(
@@ -5992,6 +6082,7 @@ sds genValkeyInfoString(dict *section_dict, int all_sections, int everything) {
                 "tracking_total_keys:%lld\r\n", (unsigned long long)trackingGetTotalKeys(),
                 "tracking_total_items:%lld\r\n", (unsigned long long)trackingGetTotalItems(),
                 "tracking_total_prefixes:%lld\r\n", (unsigned long long)trackingGetTotalPrefixes(),
+                "tracking_invalidations_batched:%lld\r\n", server.stat_tracking_invalidations_batched,
                 "unexpected_error_replies:%lld\r\n", server.stat_unexpected_error_replies,
                 "total_error_replies:%lld\r\n", server.stat_total_error_replies,
                 "dump_payload_sanitizations:%lld\r\n", server.stat_dump_payload_sanitizations,
@@ -5999,8 +6090,13 @@ sds genValkeyInfoString(dict *section_dict, int all_sections, int everything) {
                 "total_writes_processed:%lld\r\n", server.stat_total_writes_processed,
                 "io_threaded_reads_processed:%lld\r\n", server.stat_io_reads_processed,
                 "io_threaded_writes_processed:%lld\r\n", server.stat_io_writes_processed,
+                "io_threaded_pubsub_messages:%lld\r\n", server.stat_io_pubsub_messages,
                 "io_threaded_freed_objects:%lld\r\n", server.stat_io_freed_objects,
                 "io_threaded_accept_processed:%lld\r\n", server.stat_io_accept_offloaded,
+                "tls_handshake_queue_depth:%zu\r\n", tls_handshake_queue_depth,
+                "tls_handshake_jobs_processed:%lld\r\n", tls_handshake_jobs,
+                "tls_handshake_avg_latency_usec:%lld\r\n", tls_handshake_latency,
+                "tls_ktls_send_connections:%lld\r\n", server.stat_tls_ktls_send_connections,
                 "io_threaded_poll_processed:%lld\r\n", server.stat_poll_processed_by_io_threads,
                 "io_threaded_total_prefetch_batches:%lld\r\n", server.stat_total_prefetch_batches,
                 "io_threaded_total_prefetch_entries:%lld\r\n", server.stat_total_prefetch_entries,
@@ -6198,6 +6294,20 @@ sds genValkeyInfoString(dict *section_dict, int all_sections, int everything) {
         }
     }
 
+    /* Time spent in each phase of the sampled commands */
+    if (all_sections || (dictFind(section_dict, "commandphasestats") != NULL)) {
+        if (sections++) info = sdscat(info, "\r\n");
+        info = sdscatprintf(info, "# Commandphasestats\r\n");
+        info = genCommandPhaseInfoString(info, server.commands);
+    }
+
+    /* Time spent in each phase of the event loop */
+    if (all_sections || (dictFind(section_dict, "eventloopstats") != NULL)) {
+        if (sections++) info = sdscat(info, "\r\n");
+        info = sdscatprintf(info, "# Eventloopstats\r\n");
+        info = genEventloopInfoString(info);
+    }
+
     /* Cluster */
     if (all_sections || (dictFind(section_dict, "cluster") != NULL)) {
         if (sections++) info = sdscat(info, "\r\n");
@@ -6633,7 +6743,7 @@ void dismissClientMemory(client *c) {
             clientReplyBlock *bulk = listNodeValue(ln);
             /* Default bulk size is 16k, actually it has extra data, maybe it
              * occupies 20k according to jemalloc bin size if using jemalloc. */
-            if (bulk) dismissMemory(bulk, bulk->size);
+            if (bulk && !bulk->payload) dismissMemory(bulk, bulk->size);
         }
     }
 }
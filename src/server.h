@@ -197,6 +197,7 @@ struct hdr_histogram;
 #define PROTO_MBULK_BIG_ARG (1024 * 32)
 #define PROTO_RESIZE_THRESHOLD (1024 * 32)     /* Threshold for determining whether to resize query buffer */
 #define PROTO_REPLY_MIN_BYTES (1024)           /* the lower limit on reply buffer size */
+#define PROTO_REPLY_SHARE_MIN_BYTES (1024 * 4) /* Min size of a reply worth sharing between clients */
 #define REDIS_AUTOSYNC_BYTES (1024 * 1024 * 4) /* Sync file every 4MB. */
 
 #define REPLY_BUFFER_DEFAULT_PEAK_RESET_TIME 5000 /* 5 seconds */
@@ -784,13 +785,53 @@ char *getObjectTypeName(robj *);
 
 struct evictionPoolEntry; /* Defined in evict.c */
 
+/* An encoded reply that is built once and shared, read only, by the output
+ * buffers of many clients, like a large Pub/Sub message fanned out to all the
+ * subscribers of a channel. It is created, referenced and released only by
+ * the main thread, the IO threads just read it while writing, or hand over to
+ * a reply block a reference the main thread took for them. */
+typedef struct sharedReplyPayload {
+    unsigned int refcount;
+    size_t share; /* Memory charged to every client referencing it. */
+    size_t len;
+    char buf[];
+} sharedReplyPayload;
+
 /* This structure is used in order to represent the output buffer of a client,
- * which is actually a linked list of blocks like that, that is: client->reply. */
+ * which is actually a linked list of blocks like that, that is: client->reply.
+ *
+ * A block referencing a shared payload has no data of its own: 'used' is the
+ * length of the payload and 'size' the share of it charged to the client. */
 typedef struct clientReplyBlock {
     size_t size, used;
+    sharedReplyPayload *payload;
     char buf[];
 } clientReplyBlock;
 
+/* Return the data of a reply block. */
+static inline char *replyBlockData(clientReplyBlock *o) {
+    return o->payload ? o->payload->buf : o->buf;
+}
+
+/* Return the free space at the end of a reply block. */
+static inline size_t replyBlockAvail(clientReplyBlock *o) {
+    return o->payload ? 0 : o->size - o->used;
+}
+
+/* Pub/Sub messages to append to the output buffer of a client. The messages
+ * are queued by the main thread while fanning out a publish, and appended by
+ * the I/O thread that then writes the client, see tryQueuePushToIOThreads().
+ * Every queued payload holds a reference. */
+typedef struct clientPushQueue {
+    struct client *client;
+    listNode node;                  /* Node of the queued pushes list, while queued. */
+    size_t queued_bytes;            /* Bytes of the queued messages, see getClientOutputBufferMemoryUsage(). */
+    unsigned long long reply_bytes; /* Reply list bytes added by the I/O thread. */
+    int count, size;
+    sharedReplyPayload **payloads; /* Points to 'inline_payloads' until it grows. */
+    sharedReplyPayload *inline_payloads[2];
+} clientPushQueue;
+
 /* Replication buffer blocks is the list of replBufBlock.
  *
  * +--------------+       +--------------+       +--------------+
@@ -833,6 +874,7 @@ typedef struct serverDb {
     int id;                               /* Database ID */
     long long avg_ttl;                    /* Average TTL, just for stats */
     unsigned long expires_cursor;         /* Cursor of the active expire cycle. */
+    struct keysizesHist *keysizes;        /* Histograms of the keys length, see keysizes.c */
 } serverDb;
 
 /* forward declaration for functions ctx */
@@ -1174,6 +1216,25 @@ typedef struct ClientModuleData {
                                                 * unloaded for cleanup. Opaque for the Server Core.*/
 } ClientModuleData;
 
+/* A reply sink can be attached to a client owned by the server, like the
+ * script client, in order to receive a scalar reply of a command as a value
+ * instead of its RESP encoding, that the caller would need to parse. Only a
+ * reply that is the first output of the command is captured, if the command
+ * emits more output the captured reply is encoded in the output buffer. */
+typedef enum {
+    REPLY_SINK_EMPTY = 0,
+    REPLY_SINK_BULK,
+    REPLY_SINK_INTEGER,
+    REPLY_SINK_NULL,
+} replySinkType;
+
+typedef struct clientReplySink {
+    replySinkType type; /* Type of the captured reply. */
+    long long ll;       /* Value of a REPLY_SINK_INTEGER reply. */
+    sds bulk;           /* Value of a REPLY_SINK_BULK reply, reused across replies. */
+    size_t proto_len;   /* Length of the RESP encoding of the reply. */
+} clientReplySink;
+
 typedef struct client {
     /* Basic client information and connection. */
     uint64_t id; /* Client incremental unique ID. */
@@ -1212,7 +1273,10 @@ typedef struct client {
     unsigned long long reply_bytes;      /* Tot bytes of objects in reply list. */
     size_t sentlen;                      /* Amount of bytes already sent in the current buffer or object being sent. */
     listNode clients_pending_write_node; /* list node in clients_pending_write or in clients_pending_io_write list */
+    clientPushQueue *push_queue;         /* Pub/Sub messages queued for an IO thread to append. */
+    clientPushQueue *io_push_queue;      /* Pub/Sub messages the IO thread is appending. */
     int bufpos;
+    clientReplySink *reply_sink; /* If not NULL, scalar replies are captured here. */
     int original_argc;    /* Num of arguments of original command if arguments were rewritten. */
     robj **original_argv; /* Arguments of original command if arguments were rewritten. */
     /* Client flags and state indicators */
@@ -1239,6 +1303,10 @@ typedef struct client {
     unsigned long long net_output_bytes;          /* Total network output bytes sent to this client. */
     unsigned long long commands_processed;        /* Total count of commands this client executed. */
     unsigned long long net_output_bytes_curr_cmd; /* Total network output bytes sent to this client, by the current command. */
+    uint8_t cmd_phase_sampled;                    /* The current command is sampled by the command phase profiler. */
+    unsigned long long cmd_phase_parse_ns;        /* Time spent parsing the current command, if sampled. */
+    struct serverCommand *cmd_phase_write_cmd;    /* Sampled command whose reply is still being written, if any. */
+    unsigned long long cmd_phase_write_ns;        /* Time spent writing the reply of cmd_phase_write_cmd so far. */
     size_t buf_peak;                              /* Peak used size of buffer in last 5 sec interval. */
     int nwritten;                                 /* Number of bytes of the last write. */
     int nread;                                    /* Number of bytes of the last read. */
@@ -1485,6 +1553,7 @@ typedef struct serverTLSContextConfig {
     int session_caching;
     int session_cache_size;
     int session_cache_timeout;
+    int ktls;
 } serverTLSContextConfig;
 
 /*-----------------------------------------------------------------------------
@@ -1657,6 +1726,7 @@ struct valkeyServer {
     int io_threads_num;                       /* Number of IO threads to use. */
     int active_io_threads_num;                /* Current number of active IO threads, includes main thread. */
     int events_per_io_thread;                 /* Number of events on the event loop to trigger IO threads activation. */
+    int tls_handshake_threads_num;            /* Number of threads dedicated to TLS handshakes, 0 to use the IO threads. */
     int prefetch_batch_max_size;              /* Maximum number of keys to prefetch in a single batch */
     long long events_processed_while_blocked; /* processEventsWhileBlocked() */
     int enable_protected_configs;             /* Enable the modification of protected configs, see PROTECTED_ACTION_ALLOWED_* */
@@ -1707,6 +1777,12 @@ struct valkeyServer {
     long long stat_sync_partial_ok;                /* Number of accepted PSYNC requests. */
     long long stat_sync_partial_err;               /* Number of unaccepted PSYNC requests. */
     commandlog commandlog[COMMANDLOG_TYPE_NUM];    /* Logs of commands. */
+    int hotkeys_sample_ratio;                      /* Sample one key lookup every N for hot keys tracking. */
+    unsigned long long hotkeys_lookups_since_sample; /* Key lookups since the last hot keys sample. */
+    int hotkeys_pending_keys;                      /* Keys sampled by the current command, see hotkeys.c */
+    int command_phase_sample_ratio;                /* Time the phases of one command every N. */
+    int cmd_phase_active;                          /* The command being executed is sampled, see commandphase.c */
+    int keysizes_scan_cpu_percent;                 /* CPU percentage used to scan the keyspace, see keysizes.c */
     struct malloc_stats cron_malloc_stats;         /* sampled in serverCron(). */
     long long stat_net_input_bytes;                /* Bytes read from network. */
     long long stat_net_output_bytes;               /* Bytes written to network. */
@@ -1728,10 +1804,13 @@ struct valkeyServer {
         stat_unexpected_error_replies;                 /* Number of unexpected (aof-loading, replica to primary, etc.) error replies */
     long long stat_total_error_replies;                /* Total number of issued error replies ( command + rejected errors ) */
     long long stat_dump_payload_sanitizations;         /* Number deep dump payloads integrity validations. */
+    long long stat_tracking_invalidations_batched;     /* Number of BCAST invalidations merged into another message */
     long long stat_io_reads_processed;                 /* Number of read events processed by IO threads */
     long long stat_io_writes_processed;                /* Number of write events processed by IO threads */
+    long long stat_io_pubsub_messages;                 /* Number of Pub/Sub messages appended by IO threads */
     long long stat_io_freed_objects;                   /* Number of objects freed by IO threads */
     long long stat_io_accept_offloaded;                /* Number of offloaded accepts */
+    long long stat_tls_ktls_send_connections;          /* Number of TLS connections sending with kTLS */
     long long stat_poll_processed_by_io_threads;       /* Total number of poll jobs processed by IO */
     long long stat_total_reads_processed;              /* Total number of read events processed */
     long long stat_total_writes_processed;             /* Total number of write events processed */
@@ -1758,6 +1837,7 @@ struct valkeyServer {
        but excluding read, write and AOF, which are counted by other sets of metrics. */
     monotime el_cron_duration;
     durationStats duration_stats[EL_DURATION_TYPE_NUM];
+    elPhaseStats el_phase_stats[EL_PHASE_NUM]; /* Time spent in each phase of the event loop. */
 
     /* Configuration */
     int verbosity;               /* Loglevel verbosity */
@@ -1767,6 +1847,7 @@ struct valkeyServer {
     int active_expire_enabled;   /* Can be disabled for testing purposes. */
     int active_expire_effort;    /* From 1 (default) to 10, active effort. */
     int lazy_expire_disabled;    /* If > 0, don't trigger lazy expire */
+    int busy_script_read;        /* If > 0, a command is served at a yield point of a busy read-only script */
     int active_defrag_enabled;
     int sanitize_dump_payload;                   /* Enables deep sanitization for ziplist and listpack in RDB and RESTORE. */
     int skip_checksum_validation;                /* Disable checksum validation for RDB and RESTORE payload. */
@@ -1795,6 +1876,7 @@ struct valkeyServer {
     int latency_tracking_enabled;              /* 1 if extended latency tracking is enabled, 0 otherwise. */
     double *latency_tracking_info_percentiles; /* Extended latency tracking info output percentile list configuration. */
     int latency_tracking_info_percentiles_len;
+    int eventloop_profiling;                   /* 1 if the time of each event loop phase is tracked. */
     unsigned int max_new_tls_conns_per_cycle; /* The maximum number of tls connections that will be accepted during each
                                                  invocation of the event loop. */
     unsigned int max_new_conns_per_cycle;     /* The maximum number of tcp connections that will be accepted during each
@@ -2043,6 +2125,7 @@ struct valkeyServer {
     /* Pubsub */
     kvstore *pubsub_channels;      /* Map channels to list of subscribed clients */
     dict *pubsub_patterns;         /* A dict of pubsub_patterns */
+    rax *pubsub_patterns_index;    /* Literal prefix -> dict of patterns, see pubsub.c */
     int notify_keyspace_events;    /* Events to propagate via Pub/Sub. This is an
                                       xor of NOTIFY_... flags. */
     kvstore *pubsubshard_channels; /* Map shard channels in every slot to list of subscribed clients */
@@ -2091,6 +2174,7 @@ struct valkeyServer {
     sds cached_cluster_slot_info[CACHE_CONN_TYPE_MAX]; /* Index in array is a bitwise or of CACHE_CONN_TYPE_* */
     /* Scripting */
     mstime_t busy_reply_threshold;  /* Script / module timeout in milliseconds */
+    int busy_script_allow_reads;    /* Serve read-only commands during busy read-only scripts. */
     int pre_command_oom_state;      /* OOM before command (script?) was started */
     int script_disable_deny_script; /* Allow running commands marked "noscript" inside a script. */
     /* Lazy free */
@@ -2317,6 +2401,17 @@ typedef enum {
 typedef void serverCommandProc(client *c);
 typedef int serverGetKeysProc(struct serverCommand *cmd, robj **argv, int argc, getKeysResult *result);
 
+/* Phases of the execution of a command, as timed by the command phase
+ * profiler. See commandphase.c for what each phase covers. */
+typedef enum {
+    CMD_PHASE_PARSE = 0,
+    CMD_PHASE_LOOKUP,
+    CMD_PHASE_EXECUTE,
+    CMD_PHASE_REPLY,
+    CMD_PHASE_WRITE,
+    CMD_PHASE_NUM
+} cmdPhase;
+
 /* Command structure.
  *
  * Note that the command table is in commands.c and it is auto-generated.
@@ -2468,6 +2563,8 @@ struct serverCommand {
     sds current_name; /* Same as fullname, becomes a separate string if command is renamed. */
     struct hdr_histogram
         *latency_histogram;        /* Points to the command latency command histogram (unit of time nanosecond). */
+    long long phase_samples;       /* Calls sampled by the command phase profiler. */
+    unsigned long long phase_ns[CMD_PHASE_NUM]; /* Time spent in each phase by the sampled calls. */
     keySpec legacy_range_key_spec; /* The legacy (first,last,step) key spec is
                                     * still maintained (if applicable) so that
                                     * we can still support the reply format of
@@ -2661,6 +2758,10 @@ void addReplyNullArray(client *c);
 void addReplyBool(client *c, int b);
 void addReplyVerbatim(client *c, const char *s, size_t len, const char *ext);
 void addReplyProto(client *c, const char *s, size_t len);
+sharedReplyPayload *createSharedReplyPayload(const char *s, size_t len, unsigned long sharers);
+void releaseSharedReplyPayload(sharedReplyPayload *payload);
+void addReplySharedPayload(client *c, sharedReplyPayload *payload);
+sds catClientReplyList(sds s, client *c);
 void AddReplyFromClient(client *c, client *src);
 void addReplyBulk(client *c, robj *obj);
 void addReplyBulkCString(client *c, const char *s);
@@ -2761,6 +2862,8 @@ void deleteCachedResponseClient(client *recording_client);
 void waitForClientIO(client *c);
 void ioThreadReadQueryFromClient(void *data);
 void ioThreadWriteToClient(void *data);
+void ioThreadAppendPushes(client *c);
+void addReplyPushQueue(client *c, clientPushQueue *q);
 int canParseCommand(client *c);
 int processIOThreadsReadDone(void);
 int processIOThreadsWriteDone(void);
@@ -3170,6 +3273,7 @@ void preventCommandAOF(client *c);
 void preventCommandReplication(client *c);
 void commandlogPushCurrentCommand(client *c, struct serverCommand *cmd);
 void updateCommandLatencyHistogram(struct hdr_histogram **latency_histogram, int64_t duration_hist);
+sds fillPercentileDistributionLatencies(sds info, const char *histogram_name, struct hdr_histogram *histogram);
 int prepareForShutdown(client *c, int flags);
 void replyToClientsBlockedOnShutdown(void);
 int abortShutdown(void);
@@ -3203,6 +3307,8 @@ unsigned int getLRUClock(void);
 unsigned int LRU_CLOCK(void);
 const char *evictPolicyToString(void);
 struct serverMemOverhead *getMemoryOverheadData(void);
+#define OBJ_COMPUTE_SIZE_DEF_SAMPLES 5 /* Default sample size. */
+size_t objectComputeSize(robj *key, robj *o, size_t sample_size, int dbid);
 void freeMemoryOverheadData(struct serverMemOverhead *mh);
 void checkChildrenDone(void);
 int setOOMScoreAdj(int process_class);
@@ -3292,6 +3398,11 @@ int serverPubsubShardSubscriptionCount(void);
 size_t pubsubMemOverhead(client *c);
 void unmarkClientAsPubSub(client *c);
 int pubsubTotalSubscriptions(void);
+typedef void (*pubsubPatternMatchCallback)(robj *pattern, dict *clients, void *privdata);
+void pubsubPatternIndexAdd(rax *index, robj *pattern, dict *clients);
+void pubsubPatternIndexDelete(rax *index, robj *pattern);
+int pubsubPatternIndexMatch(rax *index, sds channel, pubsubPatternMatchCallback callback, void *privdata);
+void pubsubPatternIndexRelease(rax *index);
 dict *getClientPubSubChannels(client *c);
 dict *getClientPubSubShardChannels(client *c);
 void initClientPubSubData(client *c);
@@ -3352,6 +3463,7 @@ void initConfigValues(void);
 void removeConfig(sds name);
 sds getConfigDebugInfo(void);
 int allowProtectedAction(int config, client *c);
+void createSharedObjects(void);
 void createSharedObjectsWithCompat(void);
 void initServerClientMemUsageBuckets(void);
 void freeServerClientMemUsageBuckets(void);
@@ -3402,6 +3514,7 @@ robj *lookupKeyReadOrReply(client *c, robj *key, robj *reply);
 robj *lookupKeyWriteOrReply(client *c, robj *key, robj *reply);
 robj *lookupKeyReadWithFlags(serverDb *db, robj *key, int flags);
 robj *lookupKeyWriteWithFlags(serverDb *db, robj *key, int flags);
+void dbPrefetchKeys(serverDb *db, robj **keys, int numkeys);
 robj *objectCommandLookup(client *c, robj *key);
 robj *objectCommandLookupOrReply(client *c, robj *key, robj *reply);
 int objectSetLRUOrLFU(robj *val, long long lfu_freq, long long lru_idle, long long lru_clock, int lru_multiplier);
@@ -3637,6 +3750,7 @@ void bgrewriteaofCommand(client *c);
 void shutdownCommand(client *c);
 void slowlogCommand(client *c);
 void commandlogCommand(client *c);
+void hotkeysCommand(client *c);
 void moveCommand(client *c);
 void copyCommand(client *c);
 void renameCommand(client *c);
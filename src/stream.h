@@ -70,6 +70,11 @@ typedef struct streamCG {
     rax *consumers;         /* A radix tree representing the consumers by name
                                and their associated representation in the form
                                of streamConsumer structures. */
+    rax *pel_by_time;       /* The same NACKs of 'pel' keyed by delivery time
+                               and ID, so that idle entries are found without
+                               walking the whole PEL. NULL unless the PEL is
+                               large and was queried by idle time. Not
+                               persisted. See streamIndexNACK(). */
 } streamCG;
 
 /* A specific consumer in a consumer group.  */
@@ -140,6 +145,9 @@ streamConsumer *streamLookupConsumer(streamCG *cg, sds name);
 streamConsumer *streamCreateConsumer(streamCG *cg, sds name, robj *key, int dbid, int flags);
 streamCG *streamCreateCG(stream *s, char *name, size_t namelen, streamID *id, long long entries_read);
 streamNACK *streamCreateNACK(streamConsumer *consumer);
+void streamIndexNACK(streamCG *cg, unsigned char *pelkey, streamNACK *nack);
+void streamUnindexNACK(streamCG *cg, unsigned char *pelkey, streamNACK *nack);
+void streamSetNACKDeliveryTime(streamCG *cg, unsigned char *pelkey, streamNACK *nack, mstime_t delivery_time);
 void streamDecodeID(void *buf, streamID *id);
 int streamCompareID(streamID *a, streamID *b);
 void streamFreeNACK(streamNACK *na);
@@ -28,6 +28,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 #include <math.h>
 
 /*-----------------------------------------------------------------------------
@@ -645,6 +646,7 @@ void hsetnxCommand(client *c) {
     } else {
         hashTypeTryConversion(o, c->argv, 2, 3);
         hashTypeSet(o, c->argv[2]->ptr, c->argv[3]->ptr, HASH_SET_COPY);
+        keysizesUpdate(c->db, OBJ_HASH, hashTypeLength(o) - 1, hashTypeLength(o));
         addReply(c, shared.cone);
         signalModifiedKey(c, c->db, c->argv[1]);
         notifyKeyspaceEvent(NOTIFY_HASH, "hset", c->argv[1], c->db->id);
@@ -665,6 +667,7 @@ void hsetCommand(client *c) {
     hashTypeTryConversion(o, c->argv, 2, c->argc - 1);
 
     for (i = 2; i < c->argc; i += 2) created += !hashTypeSet(o, c->argv[i]->ptr, c->argv[i + 1]->ptr, HASH_SET_COPY);
+    keysizesUpdate(c->db, OBJ_HASH, hashTypeLength(o) - created, hashTypeLength(o));
 
     /* HMSET (deprecated) and HSET return value is different. */
     char *cmdname = c->argv[0]->ptr;
@@ -708,7 +711,8 @@ void hincrbyCommand(client *c) {
     }
     value += incr;
     new = sdsfromlonglong(value);
-    hashTypeSet(o, c->argv[2]->ptr, new, HASH_SET_TAKE_VALUE);
+    if (!hashTypeSet(o, c->argv[2]->ptr, new, HASH_SET_TAKE_VALUE))
+        keysizesUpdate(c->db, OBJ_HASH, hashTypeLength(o) - 1, hashTypeLength(o));
     addReplyLongLong(c, value);
     signalModifiedKey(c, c->db, c->argv[1]);
     notifyKeyspaceEvent(NOTIFY_HASH, "hincrby", c->argv[1], c->db->id);
@@ -751,7 +755,8 @@ void hincrbyfloatCommand(client *c) {
     char buf[MAX_LONG_DOUBLE_CHARS];
     int len = ld2string(buf, sizeof(buf), value, LD_STR_HUMAN);
     new = sdsnewlen(buf, len);
-    hashTypeSet(o, c->argv[2]->ptr, new, HASH_SET_TAKE_VALUE);
+    if (!hashTypeSet(o, c->argv[2]->ptr, new, HASH_SET_TAKE_VALUE))
+        keysizesUpdate(c->db, OBJ_HASH, hashTypeLength(o) - 1, hashTypeLength(o));
     addReplyBulkCBuffer(c, buf, len);
     signalModifiedKey(c, c->db, c->argv[1]);
     notifyKeyspaceEvent(NOTIFY_HASH, "hincrbyfloat", c->argv[1], c->db->id);
@@ -817,10 +822,12 @@ void hdelCommand(client *c) {
 
     if ((o = lookupKeyWriteOrReply(c, c->argv[1], shared.czero)) == NULL || checkType(c, o, OBJ_HASH)) return;
 
+    unsigned long oldlen = hashTypeLength(o);
     for (j = 2; j < c->argc; j++) {
         if (hashTypeDelete(o, c->argv[j]->ptr)) {
             deleted++;
             if (hashTypeLength(o) == 0) {
+                keysizesUpdate(c->db, OBJ_HASH, oldlen, 0);
                 dbDelete(c->db, c->argv[1]);
                 keyremoved = 1;
                 break;
@@ -828,6 +835,7 @@ void hdelCommand(client *c) {
         }
     }
     if (deleted) {
+        if (!keyremoved) keysizesUpdate(c->db, OBJ_HASH, oldlen, oldlen - deleted);
         signalModifiedKey(c, c->db, c->argv[1]);
         notifyKeyspaceEvent(NOTIFY_HASH, "hdel", c->argv[1], c->db->id);
         if (keyremoved) notifyKeyspaceEvent(NOTIFY_GENERIC, "del", c->argv[1], c->db->id);
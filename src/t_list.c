@@ -28,6 +28,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 
 /*-----------------------------------------------------------------------------
  * List API
@@ -474,11 +475,13 @@ void pushGenericCommand(client *c, int where, int xx) {
         dbAdd(c->db, c->argv[1], &lobj);
     }
 
+    long oldlen = listTypeLength(lobj);
     listTypeTryConversionAppend(lobj, c->argv, 2, c->argc - 1, NULL, NULL);
     for (j = 2; j < c->argc; j++) {
         listTypePush(lobj, c->argv[j], where);
         server.dirty++;
     }
+    keysizesUpdate(c->db, OBJ_LIST, oldlen, listTypeLength(lobj));
 
     addReplyLongLong(c, listTypeLength(lobj));
 
@@ -539,6 +542,7 @@ void linsertCommand(client *c) {
     while (listTypeNext(iter, &entry)) {
         if (listTypeEqual(&entry, c->argv[3])) {
             listTypeInsert(&entry, c->argv[4], where);
+            keysizesUpdate(c->db, OBJ_LIST, listTypeLength(subject) - 1, listTypeLength(subject));
             inserted = 1;
             break;
         }
@@ -642,6 +646,7 @@ void listPopRangeAndReplyWithKey(client *c, robj *o, robj *key, int where, long
 
     /* Pop these elements. */
     listTypeDelRange(o, rangestart, rangelen);
+    keysizesUpdate(c->db, OBJ_LIST, llen, llen - rangelen);
     /* Maintain the notifications and dirty. */
     listElementsRemoved(c, key, where, o, rangelen, signal, deleted);
 }
@@ -779,6 +784,7 @@ void popGenericCommand(client *c, int where) {
          * with a bulk string. */
         value = listTypePop(o, where);
         serverAssert(value != NULL);
+        keysizesUpdate(c->db, OBJ_LIST, listTypeLength(o) + 1, listTypeLength(o));
         addReplyBulk(c, value);
         decrRefCount(value);
         listElementsRemoved(c, c->argv[1], where, o, 1, 1, NULL);
@@ -793,6 +799,7 @@ void popGenericCommand(client *c, int where) {
 
         addListRangeReply(c, o, rangestart, rangeend, reverse);
         listTypeDelRange(o, rangestart, rangelen);
+        keysizesUpdate(c->db, OBJ_LIST, llen, llen - rangelen);
         listElementsRemoved(c, c->argv[1], where, o, rangelen, 1, NULL);
     }
 }
@@ -900,6 +907,7 @@ void ltrimCommand(client *c) {
         serverPanic("Unknown list encoding");
     }
 
+    keysizesUpdate(c->db, OBJ_LIST, llen, listTypeLength(o));
     notifyKeyspaceEvent(NOTIFY_LIST, "ltrim", c->argv[1], c->db->id);
     if (listTypeLength(o) == 0) {
         dbDelete(c->db, c->argv[1]);
@@ -1051,6 +1059,7 @@ void lremCommand(client *c) {
     listTypeReleaseIterator(li);
 
     if (removed) {
+        keysizesUpdate(c->db, OBJ_LIST, listTypeLength(subject) + removed, listTypeLength(subject));
         notifyKeyspaceEvent(NOTIFY_LIST, "lrem", c->argv[1], c->db->id);
         if (listTypeLength(subject) == 0) {
             dbDelete(c->db, c->argv[1]);
@@ -1072,6 +1081,7 @@ void lmoveHandlePush(client *c, robj *dstkey, robj *dstobj, robj *value, int whe
     }
     listTypeTryConversionAppend(dstobj, &value, 0, 0, NULL, NULL);
     listTypePush(dstobj, value, where);
+    keysizesUpdate(c->db, OBJ_LIST, listTypeLength(dstobj) - 1, listTypeLength(dstobj));
     signalModifiedKey(c, c->db, dstkey);
     notifyKeyspaceEvent(NOTIFY_LIST, where == LIST_HEAD ? "lpush" : "rpush", dstkey, c->db->id);
     /* Always send the pushed value to the client. */
@@ -1115,6 +1125,9 @@ void lmoveGenericCommand(client *c, int wherefrom, int whereto) {
         if (checkType(c, dobj, OBJ_LIST)) return;
         value = listTypePop(sobj, wherefrom);
         serverAssert(value); /* assertion for valgrind (avoid NPD) */
+        /* Account for the pop before the push, the source and the destination
+         * may be the same list. */
+        keysizesUpdate(c->db, OBJ_LIST, listTypeLength(sobj) + 1, listTypeLength(sobj));
         lmoveHandlePush(c, c->argv[2], dobj, value, whereto);
         listElementsRemoved(c, touchedkey, wherefrom, sobj, 1, 1, NULL);
 
@@ -1202,6 +1215,7 @@ void blockingPopGenericCommand(client *c, robj **keys, int numkeys, int where, i
         /* Non empty list, this is like a normal [LR]POP. */
         robj *value = listTypePop(o, where);
         serverAssert(value != NULL);
+        keysizesUpdate(c->db, OBJ_LIST, llen, llen - 1);
 
         addReplyArrayLen(c, 2);
         addReplyBulk(c, key);
@@ -28,6 +28,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 #include "hashtable.h"
 #include "intset.h" /* Compact integer set structure */
 
@@ -603,10 +604,12 @@ void saddCommand(client *c) {
         setTypeMaybeConvert(set, c->argc - 2);
     }
 
+    unsigned long oldlen = setTypeSize(set);
     for (j = 2; j < c->argc; j++) {
         if (setTypeAdd(set, c->argv[j]->ptr)) added++;
     }
     if (added) {
+        keysizesUpdate(c->db, OBJ_SET, oldlen, oldlen + added);
         signalModifiedKey(c, c->db, c->argv[1]);
         notifyKeyspaceEvent(NOTIFY_SET, "sadd", c->argv[1], c->db->id);
     }
@@ -620,10 +623,12 @@ void sremCommand(client *c) {
 
     if ((set = lookupKeyWriteOrReply(c, c->argv[1], shared.czero)) == NULL || checkType(c, set, OBJ_SET)) return;
 
+    unsigned long oldlen = setTypeSize(set);
     for (j = 2; j < c->argc; j++) {
         if (setTypeRemove(set, c->argv[j]->ptr)) {
             deleted++;
             if (setTypeSize(set) == 0) {
+                keysizesUpdate(c->db, OBJ_SET, oldlen, 0);
                 dbDelete(c->db, c->argv[1]);
                 keyremoved = 1;
                 break;
@@ -631,6 +636,7 @@ void sremCommand(client *c) {
         }
     }
     if (deleted) {
+        if (!keyremoved) keysizesUpdate(c->db, OBJ_SET, oldlen, oldlen - deleted);
         signalModifiedKey(c, c->db, c->argv[1]);
         notifyKeyspaceEvent(NOTIFY_SET, "srem", c->argv[1], c->db->id);
         if (keyremoved) notifyKeyspaceEvent(NOTIFY_GENERIC, "del", c->argv[1], c->db->id);
@@ -666,6 +672,7 @@ void smoveCommand(client *c) {
         addReply(c, shared.czero);
         return;
     }
+    keysizesUpdate(c->db, OBJ_SET, setTypeSize(srcset) + 1, setTypeSize(srcset));
     notifyKeyspaceEvent(NOTIFY_SET, "srem", c->argv[1], c->db->id);
 
     /* Remove the src set from the database when empty */
@@ -685,6 +692,7 @@ void smoveCommand(client *c) {
 
     /* An extra key has changed when ele was successfully added to dstset */
     if (setTypeAdd(dstset, ele->ptr)) {
+        keysizesUpdate(c->db, OBJ_SET, setTypeSize(dstset) - 1, setTypeSize(dstset));
         server.dirty++;
         signalModifiedKey(c, c->db, c->argv[2]);
         notifyKeyspaceEvent(NOTIFY_SET, "sadd", c->argv[2], c->db->id);
@@ -843,6 +851,7 @@ void spopWithCountCommand(client *c) {
         lp = lpBatchDelete(lp, ps, count);
         zfree(ps);
         set->ptr = lp;
+        keysizesUpdate(c->db, OBJ_SET, size, remaining);
     } else if (remaining * SPOP_MOVE_STRATEGY_MUL > count) {
         for (unsigned long i = 0; i < count; i++) {
             propargv[propindex] = setTypePopRandom(set);
@@ -857,6 +866,7 @@ void spopWithCountCommand(client *c) {
                 propindex = 2;
             }
         }
+        keysizesUpdate(c->db, OBJ_SET, size, remaining);
     } else {
         /* CASE 3: The number of elements to return is very big, approaching
          * the size of the set itself. After some time extracting random elements
@@ -921,7 +931,9 @@ void spopWithCountCommand(client *c) {
         }
         setTypeReleaseIterator(si);
 
-        /* Assign the new set as the key value. */
+        /* Assign the new set as the key value. The old one holds the popped
+         * elements by now. */
+        keysizesUpdate(c->db, OBJ_SET, size, setTypeSize(set));
         dbReplaceValue(c->db, c->argv[1], &newset);
     }
 
@@ -961,6 +973,7 @@ void spopCommand(client *c) {
 
     /* Pop a random element from the set */
     ele = setTypePopRandom(set);
+    keysizesUpdate(c->db, OBJ_SET, setTypeSize(set) + 1, setTypeSize(set));
 
     notifyKeyspaceEvent(NOTIFY_SET, "spop", c->argv[1], c->db->id);
 
@@ -28,6 +28,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 #include "endianconv.h"
 #include "stream.h"
 
@@ -43,6 +44,11 @@
  * avoid malloc allocation.*/
 #define STREAMID_STATIC_VECTOR_LEN 8
 
+/* When looking for idle PEL entries, XPENDING gives up on the delivery time
+ * index, and scans the PEL in ID order, once more than this many times the
+ * requested count of entries are idle. */
+#define STREAM_PEL_SCAN_FACTOR 10
+
 /* Max pre-allocation for listpack. This is done to avoid abuse of a user
  * setting stream_node_max_bytes to a huge number. */
 #define STREAM_LISTPACK_MAX_PRE_ALLOCATE 4096
@@ -61,6 +67,7 @@ size_t streamReplyWithRangeFromConsumerPEL(client *c,
                                            streamID *start,
                                            streamID *end,
                                            size_t count,
+                                           streamCG *group,
                                            streamConsumer *consumer);
 int streamParseStrictIDOrReply(client *c, robj *o, streamID *id, uint64_t missing_seq, int *seq_given);
 int streamParseIDOrReply(client *c, robj *o, streamID *id, uint64_t missing_seq);
@@ -1363,7 +1370,12 @@ sds createStreamIDString(streamID *id) {
  * in the standard <ms>-<seq> format, using the simple string protocol
  * of REPL. */
 void addReplyStreamID(client *c, streamID *id) {
-    addReplyBulkSds(c, createStreamIDString(id));
+    /* Format on the stack: this is called for every entry of range replies. */
+    char buf[STREAM_ID_STR_LEN];
+    int len = ull2string(buf, sizeof(buf), id->ms);
+    buf[len++] = '-';
+    len += ull2string(buf + len, sizeof(buf) - len, id->seq);
+    addReplyBulkCBuffer(c, buf, len);
 }
 
 void setDeferredReplyStreamID(client *c, void *dr, streamID *id) {
@@ -1593,6 +1605,209 @@ void streamPropagateConsumerCreation(client *c, robj *key, robj *groupname, sds
     decrRefCount(argv[4]);
 }
 
+/* Number of primary entry fields streamReplyNodeRange() decodes on the stack,
+ * nodes with more primary fields than this use a heap allocated array. */
+#define STREAM_BULK_PRIMARY_FIELDS 16
+
+/* Size the protocol accumulated by streamReplyNodeRange() reaches before it
+ * is added to the client reply. Half a reply block, so that the blocks are
+ * filled up instead of being sized after oversized appends. */
+#define STREAM_BULK_BATCH_BYTES (PROTO_REPLY_CHUNK_BYTES / 2)
+
+/* A primary entry field decoded once per node, so that entries flagged with
+ * STREAM_ITEM_FLAG_SAMEFIELDS don't have to decode it again and again. */
+typedef struct streamBulkField {
+    unsigned char *ptr;
+    int64_t len;
+    unsigned char buf[LP_INTBUF_SIZE];
+} streamBulkField;
+
+/* Appends the RESP header '<prefix><len>\r\n' to 'batch'. */
+static inline sds streamBatchAddHeader(sds batch, char prefix, long long len) {
+    batch = sdsMakeRoomFor(batch, LONG_STR_SIZE + 3);
+    char *dst = batch + sdslen(batch);
+    dst[0] = prefix;
+    int n = ll2string(dst + 1, LONG_STR_SIZE, len);
+    dst[n + 1] = '\r';
+    dst[n + 2] = '\n';
+    sdsIncrLen(batch, n + 3);
+    return batch;
+}
+
+/* Appends the bulk string 'p' of 'len' bytes to 'batch', reserving the room
+ * for the header and the payload at once. */
+static inline sds streamBatchAddBulk(sds batch, const unsigned char *p, int64_t len) {
+    batch = sdsMakeRoomFor(batch, LONG_STR_SIZE + 5 + len);
+    char *dst = batch + sdslen(batch);
+    dst[0] = '$';
+    int n = ll2string(dst + 1, LONG_STR_SIZE, len);
+    dst += n + 1;
+    dst[0] = '\r';
+    dst[1] = '\n';
+    memcpy(dst + 2, p, len);
+    dst[len + 2] = '\r';
+    dst[len + 3] = '\n';
+    sdsIncrLen(batch, n + 5 + len);
+    return batch;
+}
+
+/* Like lpGetInteger(), but for the single pass decoding below: returns the
+ * integer at '*p' and moves '*p' to the next listpack element. */
+static inline int64_t streamNodeNextInteger(unsigned char *lp, size_t lpbytes, unsigned char **p) {
+    int64_t v;
+    unsigned char *e = lpGetNext(lp, lpbytes, p, &v, NULL);
+    if (e == NULL) return v;
+    long long ll;
+    serverAssert(string2ll((char *)e, v, &ll) != 0);
+    return ll;
+}
+
+/* Skips 'count' listpack elements starting at '*p'. */
+static inline void streamNodeSkip(unsigned char *lp, size_t lpbytes, unsigned char **p, int64_t count) {
+    int64_t len;
+    while (count--) lpGetNext(lp, lpbytes, p, &len, NULL);
+}
+
+/* Emit to the client the entries of the stream node 'lp', whose primary ID is
+ * 'primary_id', that are within 'start' and 'end' inclusive, and are not
+ * deleted. No more than 'count' entries are emitted, unless 'count' is zero.
+ *
+ * This is the forward, no consumer group, path of streamReplyWithRange(): the
+ * listpack is walked once from the head, decoding every element a single time.
+ * The primary entry fields are decoded once per node, tombstones and entries
+ * before 'start' are skipped without decoding their fields. The protocol of
+ * the entries is accumulated in '*batch', that is added to the client reply
+ * once it reaches STREAM_BULK_BATCH_BYTES, instead of adding every field and
+ * value on its own. The function sets '*done' to 1 when the iteration can
+ * stop, because an entry after 'end' was found or 'count' was reached.
+ *
+ * Returns the number of entries emitted. */
+static size_t streamReplyNodeRange(client *c,
+                                   sds *batch,
+                                   unsigned char *lp,
+                                   streamID *primary_id,
+                                   streamID *start,
+                                   streamID *end,
+                                   size_t count,
+                                   int *done) {
+    size_t lpbytes = lpBytes(lp);
+    unsigned char *p = lpFirst(lp);
+    size_t emitted = 0;
+
+    /* Header: valid entries count, deleted entries count, primary fields. */
+    int64_t valid = streamNodeNextInteger(lp, lpbytes, &p);
+    streamNodeSkip(lp, lpbytes, &p, 1);
+    int64_t primary_fields_count = streamNodeNextInteger(lp, lpbytes, &p);
+    serverAssert(primary_fields_count >= 0);
+    if (valid == 0) return 0; /* Only tombstones in this node. */
+
+    streamBulkField static_fields[STREAM_BULK_PRIMARY_FIELDS];
+    streamBulkField *fields = static_fields;
+    if (primary_fields_count > STREAM_BULK_PRIMARY_FIELDS)
+        fields = zmalloc(sizeof(streamBulkField) * primary_fields_count);
+    for (int64_t i = 0; i < primary_fields_count; i++) {
+        fields[i].ptr = lpGetNext(lp, lpbytes, &p, &fields[i].len, fields[i].buf);
+    }
+    streamNodeSkip(lp, lpbytes, &p, 1); /* The primary entry terminator. */
+
+    unsigned char field_buf[LP_INTBUF_SIZE], value_buf[LP_INTBUF_SIZE];
+    while (p) {
+        int64_t flags = streamNodeNextInteger(lp, lpbytes, &p);
+        streamID id = *primary_id;
+        id.ms += streamNodeNextInteger(lp, lpbytes, &p);
+        id.seq += streamNodeNextInteger(lp, lpbytes, &p);
+
+        int samefields = flags & STREAM_ITEM_FLAG_SAMEFIELDS;
+        int64_t numfields = samefields ? primary_fields_count : streamNodeNextInteger(lp, lpbytes, &p);
+        serverAssert(numfields >= 0);
+
+        if ((flags & STREAM_ITEM_FLAG_DELETED) || streamCompareID(&id, start) < 0) {
+            /* Skip the field-value pairs (or just the values) and the
+             * lp-count of this entry. */
+            streamNodeSkip(lp, lpbytes, &p, (samefields ? numfields : numfields * 2) + 1);
+            continue;
+        }
+        if (streamCompareID(&id, end) > 0) {
+            *done = 1;
+            break;
+        }
+
+        char idbuf[STREAM_ID_STR_LEN];
+        int idlen = ull2string(idbuf, sizeof(idbuf), id.ms);
+        idbuf[idlen++] = '-';
+        idlen += ull2string(idbuf + idlen, sizeof(idbuf) - idlen, id.seq);
+        *batch = sdscatlen(*batch, "*2\r\n", 4);
+        *batch = streamBatchAddBulk(*batch, (unsigned char *)idbuf, idlen);
+        *batch = streamBatchAddHeader(*batch, '*', numfields * 2);
+        for (int64_t i = 0; i < numfields; i++) {
+            unsigned char *field, *value;
+            int64_t field_len, value_len;
+            if (samefields) {
+                field = fields[i].ptr;
+                field_len = fields[i].len;
+            } else {
+                field = lpGetNext(lp, lpbytes, &p, &field_len, field_buf);
+            }
+            value = lpGetNext(lp, lpbytes, &p, &value_len, value_buf);
+            *batch = streamBatchAddBulk(*batch, field, field_len);
+            *batch = streamBatchAddBulk(*batch, value, value_len);
+        }
+        streamNodeSkip(lp, lpbytes, &p, 1); /* lp-count */
+        if (sdslen(*batch) >= STREAM_BULK_BATCH_BYTES) {
+            addReplyProto(c, *batch, sdslen(*batch));
+            sdsclear(*batch);
+        }
+
+        emitted++;
+        if (count && count == emitted) {
+            *done = 1;
+            break;
+        }
+    }
+
+    if (fields != static_fields) zfree(fields);
+    return emitted;
+}
+
+/* Forward, no consumer group, implementation of streamReplyWithRange(): see
+ * streamReplyNodeRange(). The nodes are visited the same way
+ * streamIteratorStart() and streamIteratorGetID() do. Returns the number of
+ * entries emitted, the caller takes care of the array length. */
+static size_t streamReplyWithRangeBulk(client *c, stream *s, streamID *start, streamID *end, size_t count) {
+    streamID min_id = {0, 0}, max_id = {UINT64_MAX, UINT64_MAX}, primary_id;
+    size_t arraylen = 0;
+    int done = 0;
+    raxIterator ri;
+
+    if (!start) start = &min_id;
+    if (!end) end = &max_id;
+
+    sds batch = sdsnewlen(SDS_NOINIT, STREAM_BULK_BATCH_BYTES * 2);
+    sdssetlen(batch, 0);
+    raxStart(&ri, s->rax);
+    if (start->ms || start->seq) {
+        unsigned char start_key[sizeof(streamID)];
+        streamEncodeID(start_key, start);
+        raxSeek(&ri, "<=", start_key, sizeof(start_key));
+        if (raxEOF(&ri)) raxSeek(&ri, "^", NULL, 0);
+    } else {
+        raxSeek(&ri, "^", NULL, 0);
+    }
+    while (!done && raxNext(&ri)) {
+        serverAssert(ri.key_len == sizeof(streamID));
+        streamDecodeID(ri.key, &primary_id);
+        /* Nodes are sorted by ID, and every entry ID in a node is greater
+         * or equal than its primary ID. */
+        if (streamCompareID(&primary_id, end) > 0) break;
+        arraylen +=
+            streamReplyNodeRange(c, &batch, ri.data, &primary_id, start, end, count ? count - arraylen : 0, &done);
+    }
+    raxStop(&ri);
+    if (sdslen(batch)) addReplyProto(c, batch, sdslen(batch));
+    sdsfree(batch);
+    return arraylen;
+}
+
 /* Send the stream items in the specified range to the client 'c'. The range
  * the client will receive is between start and end inclusive, if 'count' is
  * non zero, no more than 'count' elements are sent.
@@ -1670,10 +1885,19 @@ size_t streamReplyWithRange(client *c,
      * the history of messages delivered to it and not yet confirmed
      * as delivered. */
     if (group && (flags & STREAM_RWR_HISTORY)) {
-        return streamReplyWithRangeFromConsumerPEL(c, s, start, end, count, consumer);
+        return streamReplyWithRangeFromConsumerPEL(c, s, start, end, count, group, consumer);
     }
 
     if (!(flags & STREAM_RWR_RAWENTRIES)) arraylen_ptr = addReplyDeferredLen(c);
+
+    /* Without a group there is no per entry bookkeeping: plain forward ranges
+     * are served decoding each node in a single pass. */
+    if (!group && !rev) {
+        arraylen = streamReplyWithRangeBulk(c, s, start, end, count);
+        if (arraylen_ptr) setDeferredArrayLen(c, arraylen_ptr, arraylen);
+        return arraylen;
+    }
+
     streamIteratorStart(&si, s, start, end, rev);
     while (streamIteratorGetID(&si, &id, &numfields)) {
         /* Update the group last_id if needed. */
@@ -1730,6 +1954,7 @@ size_t streamReplyWithRange(client *c,
             streamNACK *nack = streamCreateNACK(consumer);
             int group_inserted = raxTryInsert(group->pel, buf, sizeof(buf), nack, NULL);
             int consumer_inserted = raxTryInsert(consumer->pel, buf, sizeof(buf), nack, NULL);
+            if (group_inserted) streamIndexNACK(group, buf, nack);
 
             /* Now we can check if the entry was already busy, and
              * in that case reassign the entry to the new consumer,
@@ -1743,7 +1968,7 @@ size_t streamReplyWithRange(client *c,
                 raxRemove(nack->consumer->pel, buf, sizeof(buf), NULL);
                 /* Update the consumer and NACK metadata. */
                 nack->consumer = consumer;
-                nack->delivery_time = commandTimeSnapshot();
+                streamSetNACKDeliveryTime(group, buf, nack, commandTimeSnapshot());
                 nack->delivery_count = 1;
                 /* Add the entry in the new consumer local PEL. */
                 raxInsert(consumer->pel, buf, sizeof(buf), nack, NULL);
@@ -1790,6 +2015,7 @@ size_t streamReplyWithRangeFromConsumerPEL(client *c,
                                            streamID *start,
                                            streamID *end,
                                            size_t count,
+                                           streamCG *group,
                                            streamConsumer *consumer) {
     raxIterator ri;
     unsigned char startkey[sizeof(streamID)];
@@ -1815,7 +2041,7 @@ size_t streamReplyWithRangeFromConsumerPEL(client *c,
             addReplyNullArray(c);
         } else {
             streamNACK *nack = ri.data;
-            nack->delivery_time = commandTimeSnapshot();
+            streamSetNACKDeliveryTime(group, ri.key, nack, commandTimeSnapshot());
             nack->delivery_count++;
         }
         arraylen++;
@@ -2028,13 +2254,16 @@ void xaddCommand(client *c) {
     }
     sds replyid = createStreamIDString(&id);
     addReplyBulkCBuffer(c, replyid, sdslen(replyid));
+    keysizesUpdate(c->db, OBJ_STREAM, s->length - 1, s->length);
 
     notifyKeyspaceEvent(NOTIFY_STREAM, "xadd", c->argv[1], c->db->id);
     server.dirty++;
 
     /* Trim if needed. */
     if (parsed_args.trim_strategy != TRIM_STRATEGY_NONE) {
-        if (streamTrim(s, &parsed_args)) {
+        int64_t trimmed = streamTrim(s, &parsed_args);
+        if (trimmed) {
+            keysizesUpdate(c->db, OBJ_STREAM, s->length + trimmed, s->length);
             notifyKeyspaceEvent(NOTIFY_STREAM, "xtrim", c->argv[1], c->db->id);
         }
         if (parsed_args.approx_trim) {
@@ -2438,6 +2667,133 @@ streamNACK *streamCreateNACK(streamConsumer *consumer) {
     return nack;
 }
 
+/* The key of a NACK in the delivery time index of its group: the delivery
+ * time as a 64 bit big endian number, with the sign bit flipped so that
+ * negative times sort first, followed by the key of the NACK in the PEL
+ * (the encoded ID), so that NACKs delivered at the same time are in ID order.
+ * The value is the NACK itself, like in the PEL. */
+#define STREAM_PEL_TIME_KEY_LEN (sizeof(uint64_t) + sizeof(streamID))
+
+/* The delivery time index costs a rax key for every pending entry, so a
+ * group only has one once an idle query was made while its PEL had at least
+ * STREAM_PEL_TIME_INDEX_MIN_SIZE entries. Smaller PELs are cheap to scan. The
+ * index is dropped when the PEL shrinks below half of that. */
+#define STREAM_PEL_TIME_INDEX_MIN_SIZE 1024
+
+static void streamEncodePELTimeKey(unsigned char *buf, mstime_t delivery_time, unsigned char *pelkey) {
+    uint64_t t = htonu64((uint64_t)delivery_time ^ (1ULL << 63));
+    memcpy(buf, &t, sizeof(t));
+    memcpy(buf + sizeof(t), pelkey, sizeof(streamID));
+}
+
+/* Add the NACK with the key 'pelkey' in the PEL of 'cg' to the delivery time
+ * index of the group, if it has one, or update the NACK pointer if it's
+ * already there. Called when the NACK is added to the PEL. */
+void streamIndexNACK(streamCG *cg, unsigned char *pelkey, streamNACK *nack) {
+    if (!cg->pel_by_time) return;
+    unsigned char key[STREAM_PEL_TIME_KEY_LEN];
+    streamEncodePELTimeKey(key, nack->delivery_time, pelkey);
+    raxInsert(cg->pel_by_time, key, sizeof(key), nack, NULL);
+}
+
+/* Remove the NACK from the delivery time index, if the group has one.
+ * Called before the NACK is removed from the PEL. */
+void streamUnindexNACK(streamCG *cg, unsigned char *pelkey, streamNACK *nack) {
+    if (!cg->pel_by_time) return;
+    unsigned char key[STREAM_PEL_TIME_KEY_LEN];
+    streamEncodePELTimeKey(key, nack->delivery_time, pelkey);
+    raxRemove(cg->pel_by_time, key, sizeof(key), NULL);
+    if (raxSize(cg->pel_by_time) < STREAM_PEL_TIME_INDEX_MIN_SIZE / 2) {
+        raxFree(cg->pel_by_time);
+        cg->pel_by_time = NULL;
+    }
+}
+
+/* Returns true if idle queries on 'pel', the PEL of 'cg' or of one of its
+ * consumers, should use the delivery time index. The index is built the first
+ * time it is needed. */
+static int streamUsePELTimeIndex(streamCG *cg, rax *pel) {
+    if (raxSize(pel) < STREAM_PEL_TIME_INDEX_MIN_SIZE) return 0;
+    if (!cg->pel_by_time) {
+        cg->pel_by_time = raxNew();
+        raxIterator ri;
+        raxStart(&ri, cg->pel);
+        raxSeek(&ri, "^", NULL, 0);
+        while (raxNext(&ri)) streamIndexNACK(cg, ri.key, ri.data);
+        raxStop(&ri);
+    }
+    return 1;
+}
+
+/* Set the delivery time of a NACK of the PEL of 'cg', updating its key in
+ * the delivery time index. */
+void streamSetNACKDeliveryTime(streamCG *cg, unsigned char *pelkey, streamNACK *nack, mstime_t delivery_time) {
+    if (nack->delivery_time == delivery_time) return;
+    streamUnindexNACK(cg, pelkey, nack);
+    nack->delivery_time = delivery_time;
+    streamIndexNACK(cg, pelkey, nack);
+}
+
+/* A PEL entry returned by streamCollectIdleNACKs(). */
+typedef struct streamIdleNACK {
+    streamID id;
+    streamNACK *nack;
+} streamIdleNACK;
+
+static int streamIdleNACKCompare(const void *a, const void *b) {
+    return streamCompareID(&((streamIdleNACK *)a)->id, &((streamIdleNACK *)b)->id);
+}
+
+/* Collect the NACKs of the PEL of 'cg' that are idle for at least 'minidle'
+ * milliseconds at the time 'now', with an ID between 'start' and 'end'
+ * inclusive, and delivered to 'consumer' if not NULL. The entries are
+ * returned sorted by ID, in an array to be released with zfree(), and their
+ * number is stored in '*numnacks'.
+ *
+ * The delivery time index is walked from the oldest delivery, and the walk
+ * stops at the first NACK that is not idle enough, so only idle NACKs are
+ * visited. However if more than 'limit' NACKs are idle NULL is returned: the
+ * idle entries are then dense enough that the caller is better off scanning
+ * the PEL in ID order. */
+static streamIdleNACK *streamCollectIdleNACKs(streamCG *cg,
+                                              streamConsumer *consumer,
+                                              mstime_t now,
+                                              mstime_t minidle,
+                                              streamID *start,
+                                              streamID *end,
+                                              size_t limit,
+                                              size_t *numnacks) {
+    size_t len = 0, size = 16, visited = 0;
+    streamIdleNACK *nacks = zmalloc(sizeof(*nacks) * size);
+    raxIterator ri;
+    raxStart(&ri, cg->pel_by_time);
+    raxSeek(&ri, "^", NULL, 0);
+    while (raxNext(&ri)) {
+        streamNACK *nack = ri.data;
+        if (now - nack->delivery_time < minidle) break;
+        if (visited++ == limit) {
+            zfree(nacks);
+            nacks = NULL;
+            break;
+        }
+        if (consumer && nack->consumer != consumer) continue;
+        streamID id;
+        streamDecodeID(ri.key + sizeof(uint64_t), &id);
+        if (streamCompareID(&id, start) < 0 || streamCompareID(&id, end) > 0) continue;
+        if (len == size) {
+            size *= 2;
+            nacks = zrealloc(nacks, sizeof(*nacks) * size);
+        }
+        nacks[len].id = id;
+        nacks[len].nack = nack;
+        len++;
+    }
+    raxStop(&ri);
+    if (nacks) qsort(nacks, len, sizeof(*nacks), streamIdleNACKCompare);
+    *numnacks = len;
+    return nacks;
+}
+
 /* Free a NACK entry. */
 void streamFreeNACK(streamNACK *na) {
     zfree(na);
@@ -2471,6 +2827,7 @@ streamCG *streamCreateCG(stream *s, char *name, size_t namelen, streamID *id, lo
     streamCG *cg = zmalloc(sizeof(*cg));
     cg->pel = raxNew();
     cg->consumers = raxNew();
+    cg->pel_by_time = NULL;
     cg->last_id = *id;
     cg->entries_read = entries_read;
     raxInsert(s->cgroups, (unsigned char *)name, namelen, cg, NULL);
@@ -2481,6 +2838,7 @@ streamCG *streamCreateCG(stream *s, char *name, size_t namelen, streamID *id, lo
 void streamFreeCG(streamCG *cg) {
     raxFreeWithCallback(cg->pel, zfree);
     raxFreeWithCallback(cg->consumers, streamFreeConsumerVoid);
+    if (cg->pel_by_time) raxFree(cg->pel_by_time); /* Same NACKs of the PEL. */
     zfree(cg);
 }
 
@@ -2538,6 +2896,7 @@ void streamDelConsumer(streamCG *cg, streamConsumer *consumer) {
     raxSeek(&ri, "^", NULL, 0);
     while (raxNext(&ri)) {
         streamNACK *nack = ri.data;
+        streamUnindexNACK(cg, ri.key, nack);
         raxRemove(cg->pel, ri.key, ri.key_len, NULL);
         streamFreeNACK(nack);
     }
@@ -2830,6 +3189,7 @@ void xackCommand(client *c) {
         void *result;
         if (raxFind(group->pel, buf, sizeof(buf), &result)) {
             streamNACK *nack = result;
+            streamUnindexNACK(group, buf, nack);
             raxRemove(group->pel, buf, sizeof(buf), NULL);
             raxRemove(nack->consumer->pel, buf, sizeof(buf), NULL);
             streamFreeNACK(nack);
@@ -2842,6 +3202,25 @@ cleanup:
     if (ids != static_ids) zfree(ids);
 }
 
+/* Emit a pending entry of the XPENDING extended form. */
+static void xpendingReplyEntry(client *c, streamID *id, streamNACK *nack, mstime_t now) {
+    addReplyArrayLen(c, 4);
+
+    /* Entry ID. */
+    addReplyStreamID(c, id);
+
+    /* Consumer name. */
+    addReplyBulkCBuffer(c, nack->consumer->name, sdslen(nack->consumer->name));
+
+    /* Milliseconds elapsed since last delivery. */
+    mstime_t elapsed = now - nack->delivery_time;
+    if (elapsed < 0) elapsed = 0;
+    addReplyLongLong(c, elapsed);
+
+    /* Number of deliveries. */
+    addReplyLongLong(c, nack->delivery_count);
+}
+
 /* XPENDING <key> <group> [[IDLE <idle>] <start> <stop> <count> [<consumer>]]
  *
  * If start and stop are omitted, the command just outputs information about
@@ -2974,48 +3353,54 @@ void xpendingCommand(client *c) {
             }
         }
 
-        rax *pel = consumer ? consumer->pel : group->pel;
-        unsigned char startkey[sizeof(streamID)];
-        unsigned char endkey[sizeof(streamID)];
-        raxIterator ri;
         mstime_t now = commandTimeSnapshot();
-
-        streamEncodeID(startkey, &startid);
-        streamEncodeID(endkey, &endid);
-        raxStart(&ri, pel);
-        raxSeek(&ri, ">=", startkey, sizeof(startkey));
         void *arraylen_ptr = addReplyDeferredLen(c);
         size_t arraylen = 0;
 
-        while (count && raxNext(&ri) && memcmp(ri.key, endkey, ri.key_len) <= 0) {
-            streamNACK *nack = ri.data;
-
-            if (minidle) {
-                mstime_t this_idle = now - nack->delivery_time;
-                if (this_idle < minidle) continue;
+        /* With a minimum idle time and a large PEL the idle entries are found
+         * with the delivery time index, unless there are so many of them that
+         * the PEL scan below finds 'count' of them faster. Both return the
+         * same. */
+        rax *pel = consumer ? consumer->pel : group->pel;
+        streamIdleNACK *nacks = NULL;
+        size_t numnacks = 0;
+        if (minidle && streamUsePELTimeIndex(group, pel)) {
+            size_t limit = (size_t)count > SIZE_MAX / STREAM_PEL_SCAN_FACTOR ? SIZE_MAX
+                                                                             : (size_t)count * STREAM_PEL_SCAN_FACTOR;
+            nacks = streamCollectIdleNACKs(group, consumer, now, minidle, &startid, &endid, limit, &numnacks);
+        }
+        if (nacks) {
+            for (size_t j = 0; j < numnacks && count; j++, count--) {
+                xpendingReplyEntry(c, &nacks[j].id, nacks[j].nack, now);
+                arraylen++;
             }
+            zfree(nacks);
+        } else {
+            unsigned char startkey[sizeof(streamID)];
+            unsigned char endkey[sizeof(streamID)];
+            raxIterator ri;
 
-            arraylen++;
-            count--;
-            addReplyArrayLen(c, 4);
+            streamEncodeID(startkey, &startid);
+            streamEncodeID(endkey, &endid);
+            raxStart(&ri, pel);
+            raxSeek(&ri, ">=", startkey, sizeof(startkey));
 
-            /* Entry ID. */
-            streamID id;
-            streamDecodeID(ri.key, &id);
-            addReplyStreamID(c, &id);
+            while (count && raxNext(&ri) && memcmp(ri.key, endkey, ri.key_len) <= 0) {
+                streamNACK *nack = ri.data;
 
-            /* Consumer name. */
-            addReplyBulkCBuffer(c, nack->consumer->name, sdslen(nack->consumer->name));
-
-            /* Milliseconds elapsed since last delivery. */
-            mstime_t elapsed = now - nack->delivery_time;
-            if (elapsed < 0) elapsed = 0;
-            addReplyLongLong(c, elapsed);
+                if (minidle) {
+                    mstime_t this_idle = now - nack->delivery_time;
+                    if (this_idle < minidle) continue;
+                }
 
-            /* Number of deliveries. */
-            addReplyLongLong(c, nack->delivery_count);
+                arraylen++;
+                count--;
+                streamID id;
+                streamDecodeID(ri.key, &id);
+                xpendingReplyEntry(c, &id, nack, now);
+            }
+            raxStop(&ri);
         }
-        raxStop(&ri);
         setDeferredArrayLen(c, arraylen_ptr, arraylen);
     }
 }
@@ -3214,6 +3599,7 @@ void xclaimCommand(client *c) {
                 propagate_last_id = 0; /* Will be propagated by XCLAIM itself. */
                 server.dirty++;
                 /* Release the NACK */
+                streamUnindexNACK(group, buf, nack);
                 raxRemove(group->pel, buf, sizeof(buf), NULL);
                 raxRemove(nack->consumer->pel, buf, sizeof(buf), NULL);
                 streamFreeNACK(nack);
@@ -3230,6 +3616,7 @@ void xclaimCommand(client *c) {
             /* Create the NACK. */
             nack = streamCreateNACK(NULL);
             raxInsert(group->pel, buf, sizeof(buf), nack, NULL);
+            streamIndexNACK(group, buf, nack);
         }
 
         if (nack != NULL) {
@@ -3250,7 +3637,7 @@ void xclaimCommand(client *c) {
                  * NACK above because of the FORCE option. */
                 if (nack->consumer) raxRemove(nack->consumer->pel, buf, sizeof(buf), NULL);
             }
-            nack->delivery_time = deliverytime;
+            streamSetNACKDeliveryTime(group, buf, nack, deliverytime);
             /* Set the delivery attempts counter if given, otherwise
              * autoincrement unless JUSTID option provided */
             if (retrycount >= 0) {
@@ -3400,6 +3787,7 @@ void xautoclaimCommand(client *c) {
             decrRefCount(idstr);
             server.dirty++;
             /* Clear this entry from the PEL, it no longer exists */
+            streamUnindexNACK(group, ri.key, nack);
             raxRemove(group->pel, ri.key, ri.key_len, NULL);
             raxRemove(nack->consumer->pel, ri.key, ri.key_len, NULL);
             streamFreeNACK(nack);
@@ -3423,7 +3811,7 @@ void xautoclaimCommand(client *c) {
         }
 
         /* Update the consumer and idle time. */
-        nack->delivery_time = now;
+        streamSetNACKDeliveryTime(group, ri.key, nack, now);
         /* Increment the delivery attempts counter unless JUSTID option provided */
         if (!justid) nack->delivery_count++;
 
@@ -3517,6 +3905,7 @@ void xdelCommand(client *c) {
 
     /* Update the stream's first ID. */
     if (deleted) {
+        keysizesUpdate(c->db, OBJ_STREAM, s->length + deleted, s->length);
         if (s->length == 0) {
             s->first_id.ms = 0;
             s->first_id.seq = 0;
@@ -3575,6 +3964,7 @@ void xtrimCommand(client *c) {
     /* Perform the trimming. */
     int64_t deleted = streamTrim(s, &parsed_args);
     if (deleted) {
+        keysizesUpdate(c->db, OBJ_STREAM, s->length + deleted, s->length);
         notifyKeyspaceEvent(NOTIFY_STREAM, "xtrim", c->argv[1], c->db->id);
         if (parsed_args.approx_trim) {
             /* In case our trimming was limited (by LIMIT or by ~) we must
@@ -28,6 +28,7 @@
  */
 
 #include "server.h"
+#include "keysizes.h"
 #include <math.h> /* isnan(), isinf() */
 
 /* Forward declarations */
@@ -539,8 +540,10 @@ void setrangeCommand(client *c) {
     }
 
     if (sdslen(value) > 0) {
+        size_t oldlen = sdslen(o->ptr);
         o->ptr = sdsgrowzero(o->ptr, offset + sdslen(value));
         memcpy((char *)o->ptr + offset, value, sdslen(value));
+        keysizesUpdate(c->db, OBJ_STRING, oldlen, sdslen(o->ptr));
         signalModifiedKey(c, c->db, c->argv[1]);
         notifyKeyspaceEvent(NOTIFY_STRING,
                             "setrange", c->argv[1], c->db->id);
@@ -668,8 +671,10 @@ void incrDecrCommand(client *c, long long incr) {
 
     if (o && o->refcount == 1 && o->encoding == OBJ_ENCODING_INT &&
         value >= LONG_MIN && value <= LONG_MAX) {
+        size_t oldlen = stringObjectLen(o);
         new = o;
         o->ptr = (void *)((long)value);
+        keysizesUpdate(c->db, OBJ_STRING, oldlen, stringObjectLen(o));
     } else {
         new = createStringObjectFromLongLongForValue(value);
         if (o) {
@@ -769,6 +774,7 @@ void appendCommand(client *c) {
         o = dbUnshareStringValue(c->db, c->argv[1], o);
         o->ptr = sdscatlen(o->ptr, append->ptr, sdslen(append->ptr));
         totlen = sdslen(o->ptr);
+        keysizesUpdate(c->db, OBJ_STRING, totlen - sdslen(append->ptr), totlen);
     }
     signalModifiedKey(c, c->db, c->argv[1]);
     notifyKeyspaceEvent(NOTIFY_STRING, "append", c->argv[1], c->db->id);
@@ -57,6 +57,7 @@
  * from tail to head, useful for ZREVRANGE. */
 
 #include "server.h"
+#include "keysizes.h"
 #include "intset.h" /* Compact integer set structure */
 #include <math.h>
 
@@ -1869,6 +1870,7 @@ reply_to_client:
 
 cleanup:
     zfree(scores);
+    if (added) keysizesUpdate(c->db, OBJ_ZSET, zsetLength(zobj) - added, zsetLength(zobj));
     if (added || updated) {
         signalModifiedKey(c, c->db, key);
         notifyKeyspaceEvent(NOTIFY_ZSET, incr ? "zincr" : "zadd", key, c->db->id);
@@ -1890,9 +1892,11 @@ void zremCommand(client *c) {
 
     if ((zobj = lookupKeyWriteOrReply(c, key, shared.czero)) == NULL || checkType(c, zobj, OBJ_ZSET)) return;
 
+    unsigned long oldlen = zsetLength(zobj);
     for (j = 2; j < c->argc; j++) {
         if (zsetDel(zobj, c->argv[j]->ptr)) deleted++;
         if (zsetLength(zobj) == 0) {
+            keysizesUpdate(c->db, OBJ_ZSET, oldlen, 0);
             dbDelete(c->db, key);
             keyremoved = 1;
             break;
@@ -1900,6 +1904,7 @@ void zremCommand(client *c) {
     }
 
     if (deleted) {
+        if (!keyremoved) keysizesUpdate(c->db, OBJ_ZSET, oldlen, oldlen - deleted);
         notifyKeyspaceEvent(NOTIFY_ZSET, "zrem", key, c->db->id);
         if (keyremoved) notifyKeyspaceEvent(NOTIFY_GENERIC, "del", key, c->db->id);
         signalModifiedKey(c, c->db, key);
@@ -1920,7 +1925,7 @@ void zremrangeGenericCommand(client *c, zrange_type rangetype) {
     robj *key = c->argv[1];
     robj *zobj;
     int keyremoved = 0;
-    unsigned long deleted = 0;
+    unsigned long deleted = 0, oldlen;
     zrangespec range;
     zlexrangespec lexrange;
     long start, end, llen;
@@ -1968,6 +1973,7 @@ void zremrangeGenericCommand(client *c, zrange_type rangetype) {
     }
 
     /* Step 3: Perform the range deletion operation. */
+    oldlen = zsetLength(zobj);
     if (zobj->encoding == OBJ_ENCODING_LISTPACK) {
         switch (rangetype) {
         case ZRANGE_AUTO:
@@ -1975,6 +1981,7 @@ void zremrangeGenericCommand(client *c, zrange_type rangetype) {
         case ZRANGE_SCORE: zobj->ptr = zzlDeleteRangeByScore(zobj->ptr, &range, &deleted); break;
         case ZRANGE_LEX: zobj->ptr = zzlDeleteRangeByLex(zobj->ptr, &lexrange, &deleted); break;
         }
+        keysizesUpdate(c->db, OBJ_ZSET, oldlen, oldlen - deleted);
         if (zzlLength(zobj->ptr) == 0) {
             dbDelete(c->db, key);
             keyremoved = 1;
@@ -1989,6 +1996,7 @@ void zremrangeGenericCommand(client *c, zrange_type rangetype) {
         case ZRANGE_LEX: deleted = zslDeleteRangeByLex(zs->zsl, &lexrange, zs->ht); break;
         }
         hashtableResumeAutoShrink(zs->ht);
+        keysizesUpdate(c->db, OBJ_ZSET, oldlen, oldlen - deleted);
         if (hashtableSize(zs->ht) == 0) {
             dbDelete(c->db, key);
             keyremoved = 1;
@@ -3915,6 +3923,7 @@ void genericZpopCommand(client *c,
         sdsfree(ele);
         ++result_count;
     } while (--rangelen);
+    keysizesUpdate(c->db, OBJ_ZSET, llen, zsetLength(zobj));
 
     /* Remove the key, if indeed needed. */
     if (zsetLength(zobj) == 0) {
@@ -236,6 +236,13 @@ static SSL_CTX *createSSLContext(serverTLSContextConfig *ctx_config, int protoco
     SSL_CTX_set_options(ctx, SSL_OP_NO_COMPRESSION);
 #endif
 
+#ifdef SSL_OP_ENABLE_KTLS
+    /* Let OpenSSL hand the session keys to the kernel after the handshake.
+     * This silently falls back to user space encryption when the kernel, or
+     * the negotiated cipher, doesn't support it. */
+    if (ctx_config->ktls) SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+
     SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
     SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
 
@@ -445,6 +452,8 @@ static ConnectionType CT_TLS;
 #define TLS_CONN_FLAG_HAS_PENDING (1 << 4)
 #define TLS_CONN_FLAG_ACCEPT_ERROR (1 << 5)
 #define TLS_CONN_FLAG_ACCEPT_SUCCESS (1 << 6)
+#define TLS_CONN_FLAG_KTLS_SEND (1 << 7)
+#define TLS_CONN_FLAG_KTLS_SSL_WRITE (1 << 8)
 
 typedef struct tls_connection {
     connection c;
@@ -649,9 +658,44 @@ static void updateSSLEvent(tls_connection *conn) {
     if (!need_write && (mask & AE_WRITABLE)) aeDeleteFileEvent(server.el, conn->c.fd, AE_WRITABLE);
 }
 
+/* Once the handshake completed, check whether OpenSSL managed to offload the
+ * encryption of the outgoing records to the kernel (kTLS). If so, the
+ * connection is written to with plain write() and writev() calls, avoiding
+ * the user space encryption and the coalescing of the iovecs of a writev.
+ * Called from the main thread only. */
+static void updateKTLSState(tls_connection *conn) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    if (BIO_get_ktls_send(SSL_get_wbio(conn->ssl))) {
+        conn->flags |= TLS_CONN_FLAG_KTLS_SEND;
+        server.stat_tls_ktls_send_connections++;
+    }
+#else
+    UNUSED(conn);
+#endif
+}
+
+/* Returns true if a write to a kTLS connection can bypass OpenSSL.
+ *
+ * TLS 1.3 post-handshake messages, like the KeyUpdate a peer may request, are
+ * processed by SSL_read() but only sent by the next SSL_write(), which also
+ * switches the kernel to the new key. While such a message is pending, or an
+ * SSL_write() has to be retried, writes keep going through SSL_write(): on a
+ * kTLS connection it hands the plain text to the kernel as well, so only the
+ * iovec coalescing is lost. */
+static int canWriteKTLS(tls_connection *conn) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    if (!(conn->flags & TLS_CONN_FLAG_KTLS_SEND) || (conn->flags & TLS_CONN_FLAG_KTLS_SSL_WRITE)) return 0;
+    return !SSL_in_init(conn->ssl) && SSL_get_key_update_type(conn->ssl) == SSL_KEY_UPDATE_NONE;
+#else
+    UNUSED(conn);
+    return 0;
+#endif
+}
+
 static int TLSHandleAcceptResult(tls_connection *conn, int call_handler_on_error) {
     serverAssert(conn->c.state == CONN_STATE_ACCEPTING);
     if (conn->flags & TLS_CONN_FLAG_ACCEPT_SUCCESS) {
+        updateKTLSState(conn);
         conn->c.state = CONN_STATE_CONNECTED;
     } else if (conn->flags & TLS_CONN_FLAG_ACCEPT_ERROR) {
         conn->c.state = CONN_STATE_ERROR;
@@ -722,6 +766,7 @@ static void tlsHandleEvent(tls_connection *conn, int mask) {
                 /* If not handled, it's an error */
                 conn->c.state = CONN_STATE_ERROR;
             } else {
+                updateKTLSState(conn);
                 conn->c.state = CONN_STATE_CONNECTED;
             }
         }
@@ -904,19 +949,47 @@ static int connTLSConnect(connection *conn_,
     return C_OK;
 }
 
+/* Handle the return value of a write() or writev() on a kTLS connection,
+ * the same way the plain socket connection type does. */
+static int updateStateAfterKTLSWrite(tls_connection *conn, int ret) {
+    if (ret < 0 && errno != EAGAIN) {
+        conn->c.last_errno = errno;
+        if (errno != EINTR) conn->c.state = CONN_STATE_ERROR;
+    }
+    return ret;
+}
+
 static int connTLSWrite(connection *conn_, const void *data, size_t data_len) {
     tls_connection *conn = (tls_connection *)conn_;
     int ret;
 
     if (conn->c.state != CONN_STATE_CONNECTED) return -1;
+    if (canWriteKTLS(conn)) {
+        /* The kernel frames and encrypts the records. */
+        return updateStateAfterKTLSWrite(conn, write(conn->c.fd, data, data_len));
+    }
     ERR_clear_error();
     ret = SSL_write(conn->ssl, data, data_len);
+    if (conn->flags & TLS_CONN_FLAG_KTLS_SEND) {
+        if (ret <= 0)
+            conn->flags |= TLS_CONN_FLAG_KTLS_SSL_WRITE;
+        else
+            conn->flags &= ~TLS_CONN_FLAG_KTLS_SSL_WRITE;
+    }
     return updateStateAfterSSLIO(conn, ret, 1);
 }
 
 static int connTLSWritev(connection *conn_, const struct iovec *iov, int iovcnt) {
+    tls_connection *conn = (tls_connection *)conn_;
     if (iovcnt == 1) return connTLSWrite(conn_, iov[0].iov_base, iov[0].iov_len);
 
+    /* With kTLS the scattered buffers are handed to the kernel as they are,
+     * there's no need to copy them into a contiguous buffer first. */
+    if (canWriteKTLS(conn)) {
+        if (conn->c.state != CONN_STATE_CONNECTED) return -1;
+        return updateStateAfterKTLSWrite(conn, writev(conn->c.fd, iov, iovcnt));
+    }
+
     /* Accumulate the amount of bytes of each buffer and check if it exceeds NET_MAX_WRITES_PER_EVENT. */
     size_t iov_bytes_len = 0;
     for (int i = 0; i < iovcnt; i++) {
@@ -1021,6 +1094,7 @@ static int connTLSBlockingConnect(connection *conn_, const char *addr, int port,
     }
     unsetBlockingTimeout(conn);
 
+    updateKTLSState(conn);
     conn->c.state = CONN_STATE_CONNECTED;
     return C_OK;
 }
@@ -337,21 +337,28 @@ void sendTrackingMessage(client *c, char *keyname, size_t keylen, int proto) {
  * matches one or more prefixes in the prefix table. Later when we
  * return to the event loop, we'll send invalidation messages to the
  * clients subscribed to each prefix. */
+typedef struct bcastRememberKeyCtx {
+    client *c;
+    char *keyname;
+    size_t keylen;
+} bcastRememberKeyCtx;
+
+static void trackingRememberKeyForPrefix(size_t prefixlen, void *data, void *privdata) {
+    UNUSED(prefixlen);
+    bcastRememberKeyCtx *ctx = privdata;
+    bcastState *bs = data;
+    /* We insert the client pointer as associated value in the radix
+     * tree. This way we know who was the client that did the last
+     * change to the key, and can avoid sending the notification in the
+     * case the client is in NOLOOP mode. */
+    raxInsert(bs->keys, (unsigned char *)ctx->keyname, ctx->keylen, ctx->c, NULL);
+}
+
 void trackingRememberKeyToBroadcast(client *c, char *keyname, size_t keylen) {
-    raxIterator ri;
-    raxStart(&ri, PrefixTable);
-    raxSeek(&ri, "^", NULL, 0);
-    while (raxNext(&ri)) {
-        if (ri.key_len > keylen) continue;
-        if (ri.key_len != 0 && memcmp(ri.key, keyname, ri.key_len) != 0) continue;
-        bcastState *bs = ri.data;
-        /* We insert the client pointer as associated value in the radix
-         * tree. This way we know who was the client that did the last
-         * change to the key, and can avoid sending the notification in the
-         * case the client is in NOLOOP mode. */
-        raxInsert(bs->keys, (unsigned char *)keyname, keylen, c, NULL);
-    }
-    raxStop(&ri);
+    /* Only the prefixes of the key can match, they are all found with a
+     * single walk of the prefix table, regardless of its size. */
+    bcastRememberKeyCtx ctx = {c, keyname, keylen};
+    raxFindPrefixes(PrefixTable, (unsigned char *)keyname, keylen, trackingRememberKeyForPrefix, &ctx);
 }
 
 /* This function is called from signalModifiedKey() or other places in the server
@@ -546,6 +553,45 @@ void trackingLimitUsedSlots(void) {
     timeout_counter++;
 }
 
+/* Return the number of keys in the 'keys' radix tree, not counting the keys
+ * that were modified the last time by the client 'c' if it is not NULL. */
+static uint64_t trackingCountBroadcastKeys(client *c, rax *keys) {
+    raxIterator ri;
+    uint64_t count = 0;
+
+    if (c == NULL) return raxSize(keys);
+    raxStart(&ri, keys);
+    raxSeek(&ri, "^", NULL, 0);
+    while (raxNext(&ri)) {
+        if (ri.data != c) count++;
+    }
+    raxStop(&ri);
+    return count;
+}
+
+/* Append to 'proto' the keys in the 'keys' radix tree as RESP bulk strings,
+ * skipping the keys that were modified the last time by the client 'c' if
+ * it is not NULL. */
+static sds trackingCatBroadcastKeys(sds proto, client *c, rax *keys) {
+    raxIterator ri;
+    char buf[32];
+    size_t len;
+
+    raxStart(&ri, keys);
+    raxSeek(&ri, "^", NULL, 0);
+    while (raxNext(&ri)) {
+        if (c && ri.data == c) continue;
+        len = ll2string(buf, sizeof(buf), ri.key_len);
+        proto = sdscatlen(proto, "$", 1);
+        proto = sdscatlen(proto, buf, len);
+        proto = sdscatlen(proto, "\r\n", 2);
+        proto = sdscatlen(proto, ri.key, ri.key_len);
+        proto = sdscatlen(proto, "\r\n", 2);
+    }
+    raxStop(&ri);
+    return proto;
+}
+
 /* Generate RESP for an array containing all the key names
  * in the 'keys' radix tree. If the client is not NULL, the list will not
  * include keys that were modified the last time by this client, in order
@@ -553,22 +599,8 @@ void trackingLimitUsedSlots(void) {
  *
  * If the resulting array would be empty, NULL is returned instead. */
 sds trackingBuildBroadcastReply(client *c, rax *keys) {
-    raxIterator ri;
-    uint64_t count;
-
-    if (c == NULL) {
-        count = raxSize(keys);
-    } else {
-        count = 0;
-        raxStart(&ri, keys);
-        raxSeek(&ri, "^", NULL, 0);
-        while (raxNext(&ri)) {
-            if (ri.data != c) count++;
-        }
-        raxStop(&ri);
-
-        if (count == 0) return NULL;
-    }
+    uint64_t count = trackingCountBroadcastKeys(c, keys);
+    if (c != NULL && count == 0) return NULL;
 
     /* Create the array reply with the list of keys once, then send
      * it to all the clients subscribed to this prefix. */
@@ -579,19 +611,58 @@ sds trackingBuildBroadcastReply(client *c, rax *keys) {
     proto = sdscatlen(proto, "*", 1);
     proto = sdscatlen(proto, buf, len);
     proto = sdscatlen(proto, "\r\n", 2);
-    raxStart(&ri, keys);
+    return trackingCatBroadcastKeys(proto, c, keys);
+}
+
+/* Invalidation messages of clients subscribed to more than one prefix are
+ * accumulated while the prefixes are visited, so that such clients receive
+ * a single message for every event loop cycle. */
+typedef struct bcastPendingReply {
+    uint64_t count; /* Number of keys in 'keys'. */
+    sds keys;       /* The keys, already expressed in the RESP protocol. */
+} bcastPendingReply;
+
+/* Add the keys modified for one of the prefixes of the client 'c' to the
+ * reply pending for it in the 'pending' radix tree. */
+static void trackingAddPendingBroadcast(rax *pending, client *c, rax *keys) {
+    client *skip = c->flag.tracking_noloop ? c : NULL;
+    uint64_t count = trackingCountBroadcastKeys(skip, keys);
+    if (count == 0) return;
+
+    void *result;
+    bcastPendingReply *pr;
+    if (raxFind(pending, (unsigned char *)&c, sizeof(c), &result)) {
+        pr = result;
+        server.stat_tracking_invalidations_batched++;
+    } else {
+        pr = zmalloc(sizeof(*pr));
+        pr->count = 0;
+        pr->keys = sdsempty();
+        raxInsert(pending, (unsigned char *)&c, sizeof(c), pr, NULL);
+    }
+    pr->count += count;
+    pr->keys = trackingCatBroadcastKeys(pr->keys, skip, keys);
+}
+
+/* Send the replies accumulated by trackingAddPendingBroadcast() and free
+ * the 'pending' radix tree. */
+static void trackingSendPendingBroadcasts(rax *pending) {
+    raxIterator ri;
+    raxStart(&ri, pending);
     raxSeek(&ri, "^", NULL, 0);
     while (raxNext(&ri)) {
-        if (c && ri.data == c) continue;
-        len = ll2string(buf, sizeof(buf), ri.key_len);
-        proto = sdscatlen(proto, "$", 1);
-        proto = sdscatlen(proto, buf, len);
-        proto = sdscatlen(proto, "\r\n", 2);
-        proto = sdscatlen(proto, ri.key, ri.key_len);
-        proto = sdscatlen(proto, "\r\n", 2);
+        client *c;
+        bcastPendingReply *pr = ri.data;
+        memcpy(&c, ri.key, sizeof(c));
+        sds proto = sdscatfmt(sdsempty(), "*%U\r\n", (unsigned long long)pr->count);
+        proto = sdscatsds(proto, pr->keys);
+        sendTrackingMessage(c, proto, sdslen(proto), 1);
+        sdsfree(proto);
+        sdsfree(pr->keys);
+        zfree(pr);
     }
     raxStop(&ri);
-    return proto;
+    raxFree(pending);
 }
 
 /* This function will run the prefixes of clients in BCAST mode and
@@ -603,6 +674,7 @@ void trackingBroadcastInvalidationMessages(void) {
     /* Return ASAP if there is nothing to do here. */
     if (TrackingTable == NULL || !server.tracking_clients) return;
 
+    rax *pending = raxNew();
     raxStart(&ri, PrefixTable);
     raxSeek(&ri, "^", NULL, 0);
 
@@ -621,7 +693,10 @@ void trackingBroadcastInvalidationMessages(void) {
             while (raxNext(&ri2)) {
                 client *c;
                 memcpy(&c, ri2.key, sizeof(c));
-                if (c->flag.tracking_noloop) {
+                if (raxSize(c->pubsub_data->client_tracking_prefixes) > 1) {
+                    /* Other prefixes of this client may have keys too. */
+                    trackingAddPendingBroadcast(pending, c, bs->keys);
+                } else if (c->flag.tracking_noloop) {
                     /* This client may have certain keys excluded. */
                     sds adhoc = trackingBuildBroadcastReply(c, bs->keys);
                     if (adhoc) {
@@ -643,6 +718,8 @@ void trackingBroadcastInvalidationMessages(void) {
         bs->keys = raxNew();
     }
     raxStop(&ri);
+
+    trackingSendPendingBroadcasts(pending);
 }
 
 /* This is just used in order to access the amount of used slots in the
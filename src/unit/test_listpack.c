@@ -322,6 +322,32 @@ int test_listpackIterate2toEnd(int argc, char **argv, int flags) {
     return 0;
 }
 
+int test_listpackIterateWithLpGetNext(int argc, char **argv, int flags) {
+    /* Iterate list from 0 to end decoding and advancing in one step */
+    UNUSED(argc);
+    UNUSED(argv);
+    UNUSED(flags);
+
+    int i;
+    unsigned char *lp, *p, *vstr;
+    unsigned char intbuf[LP_INTBUF_SIZE];
+    int64_t vlen;
+
+    lp = createList();
+    p = lpFirst(lp);
+    i = 0;
+    while (p) {
+        vstr = lpGetNext(lp, lpBytes(lp), &p, &vlen, intbuf);
+        TEST_ASSERT(vlen == (int64_t)strlen(mixlist[i]));
+        TEST_ASSERT(memcmp(vstr, mixlist[i], vlen) == 0);
+        i++;
+    }
+    TEST_ASSERT(i == 4);
+    lpFree(lp);
+
+    return 0;
+}
+
 int test_listpackIterateBackToFront(int argc, char **argv, int flags) {
     /* Iterate from back to front */
     UNUSED(argc);
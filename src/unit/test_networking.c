@@ -435,3 +435,106 @@ int test_rewriteClientCommandArgument(int argc, char **argv, int flags) {
 
     return 0;
 }
+
+int test_addReplySharedPayload(int argc, char **argv, int flags) {
+    UNUSED(argc);
+    UNUSED(argv);
+    UNUSED(flags);
+
+    client *clients[2];
+    fakeConnection *conns[2];
+    for (int j = 0; j < 2; j++) {
+        client *c = zcalloc(sizeof(client));
+        c->reply = listCreate();
+        listSetFreeMethod(c->reply, freeClientReplyValue);
+        listSetDupMethod(c->reply, dupClientReplyValue);
+        c->flag.pending_write = 1; /* Not in the pending writes queue. */
+        conns[j] = connCreateFake();
+        conns[j]->buffer = zmalloc(1024);
+        conns[j]->buf_size = 1024;
+        c->conn = (connection *)conns[j];
+        clients[j] = c;
+    }
+
+    char proto[512];
+    memset(proto, 'x', sizeof(proto));
+    sharedReplyPayload *payload = createSharedReplyPayload(proto, sizeof(proto), 2);
+    TEST_ASSERT(payload->refcount == 1);
+    TEST_ASSERT(payload->share >= sizeof(proto) / 2);
+
+    /* Every client references the payload and is charged its share. */
+    for (int j = 0; j < 2; j++) {
+        addReplySharedPayload(clients[j], payload);
+        TEST_ASSERT(listLength(clients[j]->reply) == 1);
+        TEST_ASSERT(clients[j]->reply_bytes == payload->share);
+    }
+    TEST_ASSERT(payload->refcount == 3);
+    releaseSharedReplyPayload(payload);
+    TEST_ASSERT(payload->refcount == 2);
+
+    /* Replies following a shared payload are not appended to it. */
+    client *c = clients[0];
+    _addReplyProtoToList(c, c->reply, "+OK\r\n", 5);
+    TEST_ASSERT(listLength(c->reply) == 2);
+    TEST_ASSERT(((clientReplyBlock *)listNodeValue(listFirst(c->reply)))->used == sizeof(proto));
+
+    /* Write everything, releasing the reference of the first client. */
+    c->nwritten = 0;
+    _writeToClient(c);
+    TEST_ASSERT(c->nwritten == sizeof(proto) + 5);
+    TEST_ASSERT(memcmp(conns[0]->buffer, proto, sizeof(proto)) == 0);
+    TEST_ASSERT(memcmp(conns[0]->buffer + sizeof(proto), "+OK\r\n", 5) == 0);
+    _postWriteToClient(c);
+    TEST_ASSERT(listLength(c->reply) == 0);
+    TEST_ASSERT(c->reply_bytes == 0);
+    TEST_ASSERT(payload->refcount == 1);
+
+    /* The last reference is dropped with the reply list. */
+    for (int j = 0; j < 2; j++) {
+        listRelease(clients[j]->reply);
+        zfree(conns[j]->buffer);
+        zfree(conns[j]);
+        zfree(clients[j]);
+    }
+    return 0;
+}
+
+int test_catClientReplyList(int argc, char **argv, int flags) {
+    UNUSED(argc);
+    UNUSED(argv);
+    UNUSED(flags);
+
+    client *c = zcalloc(sizeof(client));
+    c->reply = listCreate();
+    listSetFreeMethod(c->reply, freeClientReplyValue);
+    listSetDupMethod(c->reply, dupClientReplyValue);
+    c->flag.pending_write = 1; /* Not in the pending writes queue. */
+    fakeConnection *conn = connCreateFake();
+    c->conn = (connection *)conn;
+
+    char proto[512];
+    memset(proto, 'x', sizeof(proto));
+    sharedReplyPayload *payload = createSharedReplyPayload(proto, sizeof(proto), 1);
+
+    /* A regular block, a shared payload, and a regular block again. */
+    _addReplyProtoToList(c, c->reply, "+OK\r\n", 5);
+    addReplySharedPayload(c, payload);
+    _addReplyProtoToList(c, c->reply, ":1\r\n", 4);
+    TEST_ASSERT(listLength(c->reply) == 3);
+    TEST_ASSERT(payload->refcount == 2);
+
+    sds s = catClientReplyList(sdsnew("$"), c);
+    TEST_ASSERT(sdslen(s) == 1 + 5 + sizeof(proto) + 4);
+    TEST_ASSERT(memcmp(s, "$+OK\r\n", 6) == 0);
+    TEST_ASSERT(memcmp(s + 6, proto, sizeof(proto)) == 0);
+    TEST_ASSERT(memcmp(s + 6 + sizeof(proto), ":1\r\n", 4) == 0);
+    TEST_ASSERT(listLength(c->reply) == 0);
+    TEST_ASSERT(payload->refcount == 1);
+
+    sdsfree(s);
+    releaseSharedReplyPayload(payload);
+    listRelease(c->reply);
+    zfree(conn);
+    zfree(c);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "../server.h"
+#include "test_help.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void countMatchCallback(robj *pattern, dict *clients, void *privdata) {
+    UNUSED(pattern);
+    UNUSED(clients);
+    (*(int *)privdata)++;
+}
+
+/* Check that the patterns are visited in order of increasing literal prefix
+ * length, remembering the last length seen in 'privdata'. */
+static void orderMatchCallback(robj *pattern, dict *clients, void *privdata) {
+    UNUSED(clients);
+    sds p = pattern->ptr;
+    size_t *last = privdata;
+    stringMatcher matcher;
+    stringMatcherInit(&matcher, p, sdslen(p), 0);
+    if ((size_t)matcher.prefixlen < *last) *last = SIZE_MAX;
+    if (*last != SIZE_MAX) *last = (size_t)matcher.prefixlen;
+}
+
+/* Count the patterns matching 'channel' the way PUBLISH did before the index
+ * existed: evaluating every single pattern. */
+static int linearMatchCount(robj **patterns, int count, sds channel) {
+    int matches = 0;
+    for (int j = 0; j < count; j++) {
+        sds p = patterns[j]->ptr;
+        if (stringmatchlen(p, sdslen(p), channel, sdslen(channel), 0)) matches++;
+    }
+    return matches;
+}
+
+int test_pubsubPatternIndexMatch(int argc, char **argv, int flags) {
+    UNUSED(argc);
+    UNUSED(argv);
+    UNUSED(flags);
+
+    const char *patterns[] = {"*",         "news.*",      "news.sport", "news.?port", "news.[st]*",
+                              "news\\.*",  "news.sport*", "n*s.sport",  "[",          "news.sport\\",
+                              "news.spor", "other.*",     "",           "*.sport",    "news.**",
+                              "**",        "news.*a"};
+    const char *channels[] = {"news.sport", "news.tech", "news.", "news", "other.x", "", "["};
+    int numpatterns = sizeof(patterns) / sizeof(patterns[0]);
+    int numchannels = sizeof(channels) / sizeof(channels[0]);
+    robj *objs[sizeof(patterns) / sizeof(patterns[0])];
+
+    rax *index = raxNew();
+    for (int j = 0; j < numpatterns; j++) {
+        objs[j] = createStringObject(patterns[j], strlen(patterns[j]));
+        pubsubPatternIndexAdd(index, objs[j], NULL);
+    }
+
+    for (int j = 0; j < numchannels; j++) {
+        sds channel = sdsnew(channels[j]);
+        int matches = 0;
+        int ret = pubsubPatternIndexMatch(index, channel, countMatchCallback, &matches);
+        TEST_ASSERT(ret == matches);
+        TEST_ASSERT(matches == linearMatchCount(objs, numpatterns, channel));
+        sdsfree(channel);
+    }
+
+    /* Shorter prefixes are matched first. */
+    sds channel = sdsnew("news.sport");
+    size_t last = 0;
+    pubsubPatternIndexMatch(index, channel, orderMatchCallback, &last);
+    TEST_ASSERT(last == strlen("news.sport"));
+    sdsfree(channel);
+
+    /* Removing patterns drops them from the results. */
+    channel = sdsnew("news.sport");
+    int before = 0, after = 0;
+    pubsubPatternIndexMatch(index, channel, countMatchCallback, &before);
+    pubsubPatternIndexDelete(index, objs[1]);
+    pubsubPatternIndexDelete(index, objs[0]);
+    pubsubPatternIndexMatch(index, channel, countMatchCallback, &after);
+    TEST_ASSERT(after == before - 2);
+    sdsfree(channel);
+
+    /* Removing every pattern leaves an empty index. */
+    for (int j = 0; j < numpatterns; j++) pubsubPatternIndexDelete(index, objs[j]);
+    TEST_ASSERT(raxSize(index) == 0);
+
+    pubsubPatternIndexRelease(index);
+    for (int j = 0; j < numpatterns; j++) decrRefCount(objs[j]);
+    return 0;
+}
+
+/* This is a special unit test useful for benchmarking the pattern index used
+ * for PUBLISH fan-out against evaluating every pattern. The benchmarking is
+ * only done when the tests are invoked with a single test target, like
+ * 'valkey-unit-tests --single test_pubsub.c --patterns 50000'. */
+int test_pubsubPatternIndexBenchmark(int argc, char **argv, int flags) {
+    if (!(flags & UNIT_TEST_SINGLE)) return 0;
+
+    long long max_patterns = 50000;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--patterns") && i + 1 < argc) {
+            max_patterns = atoll(argv[++i]);
+        } else {
+            printf("Usage: --single test_pubsub.c [--patterns <count>]\n");
+            return 1;
+        }
+    }
+
+    const int publishes = 1000;
+    for (long long count = 100; count > 0; count = (count == max_patterns) ? 0 : count * 10) {
+        if (count > max_patterns) count = max_patterns;
+        robj **objs = zmalloc(sizeof(robj *) * count);
+        rax *index = raxNew();
+        for (long long j = 0; j < count; j++) {
+            sds p = sdscatprintf(sdsempty(), "tenant:%lld:events.*", j);
+            objs[j] = createObject(OBJ_STRING, p);
+            pubsubPatternIndexAdd(index, objs[j], NULL);
+        }
+
+        sds *channels = zmalloc(sizeof(sds) * publishes);
+        for (int j = 0; j < publishes; j++) {
+            channels[j] = sdscatprintf(sdsempty(), "tenant:%lld:events.login", (long long)(rand() % count));
+        }
+
+        long long linear_matches = 0, index_matches = 0;
+        long long start = ustime();
+        for (int j = 0; j < publishes; j++) linear_matches += linearMatchCount(objs, count, channels[j]);
+        long long linear_us = ustime() - start;
+
+        start = ustime();
+        for (int j = 0; j < publishes; j++) {
+            int matches = 0;
+            pubsubPatternIndexMatch(index, channels[j], countMatchCallback, &matches);
+            index_matches += matches;
+        }
+        long long index_us = ustime() - start;
+
+        TEST_ASSERT(linear_matches == index_matches);
+        printf("patterns: %lld, linear: %.3f us/publish, indexed: %.3f us/publish\n", count,
+               (double)linear_us / publishes, (double)index_us / publishes);
+
+        for (int j = 0; j < publishes; j++) sdsfree(channels[j]);
+        zfree(channels);
+        pubsubPatternIndexRelease(index);
+        for (long long j = 0; j < count; j++) decrRefCount(objs[j]);
+        zfree(objs);
+    }
+    return 0;
+}
@@ -683,6 +683,48 @@ int test_raxTryInsertUnitTests(int argc, char **argv, int flags) {
     return 0;
 }
 
+static void raxFindPrefixesCallback(size_t prefixlen, void *data, void *privdata) {
+    char *found = privdata;
+    size_t len = strlen(found);
+    snprintf(found + len, 64 - len, "%zu:%ld ", prefixlen, (long)data);
+}
+
+int test_raxFindPrefixes(int argc, char **argv, int flags) {
+    UNUSED(argc);
+    UNUSED(argv);
+    UNUSED(flags);
+
+    rax *t = raxNew();
+    const char *keys[] = {"", "a", "ab", "abcd", "abce", "b", "abcdef"};
+    for (long j = 0; j < (long)(sizeof(keys) / sizeof(keys[0])); j++) {
+        raxInsert(t, (unsigned char *)keys[j], strlen(keys[j]), (void *)j, NULL);
+    }
+
+    struct {
+        const char *s;
+        const char *expected;
+    } cases[] = {
+        {"abcdefg", "0:0 1:1 2:2 4:3 6:6 "},
+        {"abcde", "0:0 1:1 2:2 4:3 "},
+        {"abc", "0:0 1:1 2:2 "},
+        {"abce", "0:0 1:1 2:2 4:4 "},
+        {"c", "0:0 "},
+        {"", "0:0 "},
+    };
+    for (size_t j = 0; j < sizeof(cases) / sizeof(cases[0]); j++) {
+        char found[64] = "";
+        raxFindPrefixes(t, (unsigned char *)cases[j].s, strlen(cases[j].s), raxFindPrefixesCallback, found);
+        if (strcmp(found, cases[j].expected) != 0) {
+            printf("raxFindPrefixes(%s) returned '%s' instead of '%s'\n", cases[j].s, found, cases[j].expected);
+            raxFree(t);
+            return 1;
+        }
+    }
+
+    raxFree(t);
+    return 0;
+}
+
 /* Regression test #1: Iterator wrong element returned after seek. */
 int test_raxRegressionTest1(int argc, char **argv, int flags) {
     UNUSED(argc);
@@ -273,6 +273,42 @@ int test_version2num(int argc, char **argv, int flags) {
     return 0;
 }
 
+int test_stringMatcher(int argc, char **argv, int flags) {
+    UNUSED(argc);
+    UNUSED(argv);
+    UNUSED(flags);
+
+    const char *patterns[] = {"",      "*",      "**",    "abc",    "ABC",      "abc*",  "abc**", "*abc",
+                              "**abc", "*abc*",  "*b*",   "a*c",    "a?c",      "[ab]*", "ab\\*", "*\\c",
+                              "*a?*",  "a",      "*c",    "abcabc", "*abcabc*", "c*",    "?",     "*?"};
+    const char *strings[] = {"", "a", "c", "abc", "ABC", "abcd", "xabc", "xabcx", "ab*", "aBc", "abcabc", "bc"};
+    int numpatterns = sizeof(patterns) / sizeof(patterns[0]);
+    int numstrings = sizeof(strings) / sizeof(strings[0]);
+
+    /* The compiled matcher must agree with stringmatchlen() on everything. */
+    for (int nocase = 0; nocase <= 1; nocase++) {
+        for (int j = 0; j < numpatterns; j++) {
+            stringMatcher m;
+            int plen = strlen(patterns[j]);
+            stringMatcherInit(&m, patterns[j], plen, nocase);
+            for (int k = 0; k < numstrings; k++) {
+                int slen = strlen(strings[k]);
+                TEST_ASSERT(stringMatcherMatch(&m, strings[k], slen) ==
+                            stringmatchlen(patterns[j], plen, strings[k], slen, nocase));
+            }
+        }
+    }
+
+    stringMatcher m;
+    stringMatcherInit(&m, "user:*", 6, 0);
+    TEST_ASSERT(m.type == STRINGMATCH_PREFIX && m.prefixlen == 5);
+    stringMatcherInit(&m, "*:session", 9, 0);
+    TEST_ASSERT(m.type == STRINGMATCH_SUFFIX && m.prefixlen == 0);
+    stringMatcherInit(&m, "user:?:*", 8, 0);
+    TEST_ASSERT(m.type == STRINGMATCH_GLOB && m.prefixlen == 5);
+    return 0;
+}
+
 #if defined(__linux__)
 /* Since fadvise and mincore is only supported in specific platforms like
  * Linux, we only verify the fadvise mechanism works in Linux */
@@ -194,6 +194,73 @@ int stringmatch(const char *pattern, const char *string, int nocase) {
     return stringmatchlen(pattern, strlen(pattern), string, strlen(string), nocase);
 }
 
+/* Compare 'len' bytes of 'a' and 'b', optionally ignoring the case. */
+static int stringMatcherEqual(const char *a, const char *b, int len, int nocase) {
+    if (!nocase) return memcmp(a, b, len) == 0;
+    for (int j = 0; j < len; j++) {
+        if (tolower((int)a[j]) != tolower((int)b[j])) return 0;
+    }
+    return 1;
+}
+
+/* Compile the glob-style pattern 'p' into 'm'. Patterns made of a literal and
+ * leading or trailing asterisks are recognized, so that they can be matched
+ * with plain comparisons, everything else falls back to stringmatchlen(). */
+void stringMatcherInit(stringMatcher *m, const char *p, int plen, int nocase) {
+    int start = 0, end = plen;
+
+    m->type = STRINGMATCH_GLOB;
+    m->nocase = nocase;
+    m->pattern = p;
+    m->patternlen = plen;
+    m->literal = NULL;
+    m->literallen = 0;
+
+    for (m->prefixlen = 0; m->prefixlen < plen; m->prefixlen++) {
+        char c = p[m->prefixlen];
+        if (c == '*' || c == '?' || c == '[' || c == '\\') break;
+    }
+
+    while (start < end && p[start] == '*') start++;
+    while (end > start && p[end - 1] == '*') end--;
+    for (int j = start; j < end; j++) {
+        char c = p[j];
+        if (c == '*' || c == '?' || c == '[' || c == '\\') return;
+    }
+
+    m->literal = p + start;
+    m->literallen = end - start;
+    if (m->literallen == 0) {
+        m->type = plen ? STRINGMATCH_ANY : STRINGMATCH_EXACT;
+    } else if (start == 0) {
+        m->type = end == plen ? STRINGMATCH_EXACT : STRINGMATCH_PREFIX;
+    } else {
+        m->type = end == plen ? STRINGMATCH_SUFFIX : STRINGMATCH_CONTAINS;
+    }
+}
+
+/* Match the string 's' against the compiled pattern 'm', with exactly the
+ * same result stringmatchlen() would return. Note that stringmatchlen() never
+ * matches an empty string against a non empty pattern, not even "*". */
+int stringMatcherMatch(const stringMatcher *m, const char *s, int slen) {
+    const char *lit = m->literal;
+    int litlen = m->literallen;
+
+    switch (m->type) {
+    case STRINGMATCH_EXACT: return slen == litlen && stringMatcherEqual(s, lit, litlen, m->nocase);
+    case STRINGMATCH_ANY: return slen > 0;
+    case STRINGMATCH_PREFIX: return slen >= litlen && stringMatcherEqual(s, lit, litlen, m->nocase);
+    case STRINGMATCH_SUFFIX: return slen >= litlen && stringMatcherEqual(s + slen - litlen, lit, litlen, m->nocase);
+    case STRINGMATCH_CONTAINS:
+        if (!m->nocase) return memmem(s, slen, lit, litlen) != NULL;
+        for (int j = 0; j + litlen <= slen; j++) {
+            if (stringMatcherEqual(s + j, lit, litlen, m->nocase)) return 1;
+        }
+        return 0;
+    default: return stringmatchlen(m->pattern, m->patternlen, s, slen, m->nocase);
+    }
+}
+
 /* Fuzz stringmatchlen() trying to crash it with bad input. */
 int stringmatchlen_fuzz_test(void) {
     char str[32];
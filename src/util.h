@@ -57,9 +57,33 @@ typedef enum {
     LD_STR_HEX    /* %La */
 } ld2string_mode;
 
+/* A glob-style pattern analyzed once so that matching it against many strings
+ * can skip stringmatchlen() for the common pattern shapes. The matcher only
+ * references the pattern, which must outlive it. */
+typedef enum {
+    STRINGMATCH_GLOB,     /* Anything else, matched with stringmatchlen(). */
+    STRINGMATCH_EXACT,    /* "literal" */
+    STRINGMATCH_ANY,      /* "*" */
+    STRINGMATCH_PREFIX,   /* "literal*" */
+    STRINGMATCH_SUFFIX,   /* "*literal" */
+    STRINGMATCH_CONTAINS, /* "*literal*" */
+} stringMatchType;
+
+typedef struct stringMatcher {
+    stringMatchType type;
+    int nocase;
+    const char *pattern;
+    int patternlen;
+    const char *literal; /* The literal part of the non glob types. */
+    int literallen;
+    int prefixlen; /* Length of the literal prefix, before any special char. */
+} stringMatcher;
+
 int stringmatchlen(const char *p, int plen, const char *s, int slen, int nocase);
 int stringmatch(const char *p, const char *s, int nocase);
 int stringmatchlen_fuzz_test(void);
+void stringMatcherInit(stringMatcher *m, const char *p, int plen, int nocase);
+int stringMatcherMatch(const stringMatcher *m, const char *s, int slen);
 unsigned long long memtoull(const char *p, int *err);
 const char *mempbrk(const char *s, size_t len, const char *chars, size_t charslen);
 char *memmapchars(char *s, size_t len, const char *from, const char *to, size_t setlen);
@@ -134,6 +134,14 @@ static struct config {
     pthread_mutex_t liveclients_mutex;
     pthread_mutex_t is_updating_slots_mutex;
     int resp3; /* use RESP3 */
+    double rps;        /* Open-loop target requests per second, 0 for closed-loop. */
+    double rps_max;    /* Target requests per second at the end of the rate schedule. */
+    int rps_ramp_secs; /* Duration of the rate schedule, in seconds. */
+    int rps_steps;     /* Number of steps of the rate schedule, 0 for a linear ramp. */
+    char *workload_file;
+    int json;                 /* Output one JSON object per test. */
+    sds json_intervals;       /* Per second latency of the current test, for --json. */
+    sds *servers_info_before; /* INFO of the servers before the current test, for --json. */
 } config;
 
 typedef struct _client {
@@ -156,6 +164,9 @@ typedef struct _client {
     int thread_id;
     struct clusterNode *cluster_node;
     int slots_last_update;
+    long long next_send;     /* Open-loop mode: intended start time of the next request */
+    long long send_timer_id; /* Open-loop mode: timer waiting for next_send, or -1 */
+    int *workload_ops;       /* Workload mode: operation of each request of the pipeline */
 } *client;
 
 /* Threads. */
@@ -200,6 +211,7 @@ static void freeServerConfig(serverConfig *cfg);
 static int fetchClusterSlotsConfiguration(client c);
 static void updateClusterSlotsConfiguration(void);
 static long long showThroughput(struct aeEventLoop *eventLoop, long long id, void *clientData);
+static void genBenchmarkRandomData(char *data, int count);
 
 /* Dict callbacks */
 static uint64_t dictSdsHash(const void *key);
@@ -354,6 +366,7 @@ static void freeClient(client c) {
     listNode *ln;
     aeDeleteFileEvent(el, c->context->fd, AE_WRITABLE);
     aeDeleteFileEvent(el, c->context->fd, AE_READABLE);
+    if (c->send_timer_id != -1) aeDeleteTimeEvent(el, c->send_timer_id);
     if (c->thread_id >= 0) {
         int requests_finished = atomic_load_explicit(&config.requests_finished, memory_order_relaxed);
         if (requests_finished >= config.requests) {
@@ -364,6 +377,7 @@ static void freeClient(client c) {
     sdsfree(c->obuf);
     zfree(c->randptr);
     zfree(c->stagptr);
+    zfree(c->workload_ops);
     zfree(c);
     if (config.num_threads) pthread_mutex_lock(&(config.liveclients_mutex));
     config.liveclients--;
@@ -433,6 +447,436 @@ static void setClusterKeyHashTag(client c) {
     }
 }
 
+/* Workload mode.
+ *
+ * Instead of repeating a single command, with --workload every request is
+ * generated from a workload file describing a weighted mix of commands, how
+ * their keys are picked from the keyspace and the sizes of their values:
+ *
+ *   keyspace 1000000
+ *   key-prefix key:
+ *   key-distribution zipf 0.99
+ *   value-size 100:70,1000:25,10000:5
+ *   pipeline 1
+ *   op 70 GET __key__
+ *   op 20 SET __key__ __value__
+ *   op 10 keys 2-10 MGET __keys__
+ *
+ * See the --workload help for the directives. Latency is reported for the
+ * whole mix and for every operation. */
+
+#define WORKLOAD_MAX_KEY_LEN 128
+
+typedef enum {
+    KEYDIST_UNIFORM = 0,
+    KEYDIST_SEQUENTIAL,
+    KEYDIST_ZIPF,
+    KEYDIST_HOTSPOT
+} keyDistribution;
+
+typedef enum {
+    ARG_LITERAL = 0,
+    ARG_KEY,   /* __key__: a single key. */
+    ARG_KEYS,  /* __keys__: a run of keys. */
+    ARG_PAIRS, /* __pairs__: a run of key value pairs. */
+    ARG_VALUE  /* __value__: a value of the configured size distribution. */
+} workloadArgType;
+
+typedef struct workloadOp {
+    sds name;                                /* The template, as shown in the report. */
+    int argc;                                /* Number of arguments of the template. */
+    sds *argv;                               /* Template arguments. */
+    workloadArgType *argtypes;               /* Type of each template argument. */
+    int runs;                                /* Number of __keys__ and __pairs__ arguments. */
+    int pair_runs;                           /* Number of __pairs__ arguments. */
+    int keys_min;                            /* Range of the number of keys of a run. */
+    int keys_max;                            /* Range of the number of keys of a run. */
+    double weight;                           /* Cumulative weight, to pick operations. */
+    struct hdr_histogram *latency_histogram; /* Latency of this operation. */
+} workloadOp;
+
+typedef struct workloadValueSize {
+    int min;       /* Smallest size in bytes. */
+    int max;       /* Largest size in bytes. */
+    double weight; /* Cumulative weight, to pick a size range. */
+} workloadValueSize;
+
+static struct workload {
+    const char *filename;
+    workloadOp *ops;
+    int numops;
+    long long keyspace;
+    sds key_prefix;
+    keyDistribution key_dist;
+    double zipf_theta; /* Zipfian skew, between 0 and 1 (exclusive). */
+    double zipf_zetan; /* Constants of the Zipfian generator, see workloadZipfInit(). */
+    double zipf_alpha;
+    double zipf_eta;
+    double hot_keys;           /* Hotspot: fraction of the keyspace that is hot. */
+    double hot_accesses;       /* Hotspot: fraction of the accesses going to hot keys. */
+    _Atomic long long seq_key; /* Sequential: next key. */
+    workloadValueSize *sizes;
+    int numsizes;
+    int max_value_size;
+    char *value_data; /* Random data values are taken from. */
+    int pipeline;
+} *workload = NULL;
+
+static double workloadRandom(void) {
+    return (double)random() / ((double)RAND_MAX + 1);
+}
+
+static long long workloadRandomRange(long long min, long long max) {
+    if (max <= min) return min;
+    return min + (long long)(workloadRandom() * (max - min + 1));
+}
+
+/* Zipfian generator from "Quickly Generating Billion-Record Synthetic
+ * Databases" (Gray et al.), as used by YCSB. Computing zeta(n) is linear in the
+ * size of the keyspace, but only done once, when the workload is loaded. */
+static double workloadZeta(long long n, double theta) {
+    double sum = 0;
+    for (long long i = 1; i <= n; i++) sum += 1 / pow((double)i, theta);
+    return sum;
+}
+
+static void workloadZipfInit(void) {
+    double zeta2 = workloadZeta(2, workload->zipf_theta);
+    workload->zipf_zetan = workloadZeta(workload->keyspace, workload->zipf_theta);
+    workload->zipf_alpha = 1 / (1 - workload->zipf_theta);
+    workload->zipf_eta = (1 - pow(2.0 / workload->keyspace, 1 - workload->zipf_theta)) /
+                         (1 - zeta2 / workload->zipf_zetan);
+}
+
+static long long workloadZipfNext(void) {
+    double u = workloadRandom();
+    double uz = u * workload->zipf_zetan;
+    long long rank;
+    if (uz < 1) {
+        rank = 0;
+    } else if (uz < 1 + pow(0.5, workload->zipf_theta)) {
+        rank = 1;
+    } else {
+        double base = workload->zipf_eta * u - workload->zipf_eta + 1;
+        rank = (long long)(workload->keyspace * pow(base, workload->zipf_alpha));
+        if (rank >= workload->keyspace) rank = workload->keyspace - 1;
+    }
+    /* Scatter the popular keys over the keyspace (and the cluster slots),
+     * instead of having them all at the beginning of it. */
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < 8; i++) {
+        h ^= (rank >> (i * 8)) & 0xff;
+        h *= 1099511628211ULL;
+    }
+    return h % workload->keyspace;
+}
+
+static long long workloadNextKey(void) {
+    switch (workload->key_dist) {
+    case KEYDIST_SEQUENTIAL:
+        return atomic_fetch_add_explicit(&workload->seq_key, 1, memory_order_relaxed) % workload->keyspace;
+    case KEYDIST_ZIPF: return workloadZipfNext();
+    case KEYDIST_HOTSPOT: {
+        long long hot = (long long)(workload->keyspace * workload->hot_keys);
+        if (hot < 1) hot = 1;
+        if (hot >= workload->keyspace || workloadRandom() < workload->hot_accesses)
+            return workloadRandomRange(0, hot - 1);
+        return workloadRandomRange(hot, workload->keyspace - 1);
+    }
+    default: return workloadRandomRange(0, workload->keyspace - 1);
+    }
+}
+
+/* Format the name of a key in 'buf'. In cluster mode every key gets the hash
+ * tag of one of the slots served by the node of the client, so every node
+ * gets its own copy of the keyspace. Multi-key commands use the hash tag of
+ * their first key for all the keys, so that they don't span slots. */
+static int workloadFormatKey(client c, char *buf, long long key, const char **tag) {
+    if (c->cluster_node) {
+        if (*tag == NULL) {
+            clusterNode *node = c->cluster_node;
+            int is_updating_slots = atomic_load_explicit(&config.is_updating_slots, memory_order_relaxed);
+            if (is_updating_slots) updateClusterSlotsConfiguration();
+            *tag = crc16_slot_table[node->slots[key % node->slots_count]];
+        }
+        return snprintf(buf, WORKLOAD_MAX_KEY_LEN, "%s{%s}%lld", workload->key_prefix, *tag, key);
+    }
+    return snprintf(buf, WORKLOAD_MAX_KEY_LEN, "%s%lld", workload->key_prefix, key);
+}
+
+static int workloadNextValueSize(void) {
+    double r = workloadRandom() * workload->sizes[workload->numsizes - 1].weight;
+    for (int j = 0; j < workload->numsizes; j++) {
+        if (r < workload->sizes[j].weight || j == workload->numsizes - 1)
+            return (int)workloadRandomRange(workload->sizes[j].min, workload->sizes[j].max);
+    }
+    return workload->sizes[0].min;
+}
+
+static sds workloadCatBulk(sds s, const char *p, size_t len) {
+    s = sdscatfmt(s, "$%u\r\n", (unsigned int)len);
+    s = sdscatlen(s, p, len);
+    return sdscatlen(s, "\r\n", 2);
+}
+
+/* Append a randomly picked operation to the client's output buffer, and
+ * return its index. */
+static int workloadCatRequest(client c) {
+    double r = workloadRandom() * workload->ops[workload->numops - 1].weight;
+    int opidx = 0;
+    while (opidx < workload->numops - 1 && r >= workload->ops[opidx].weight) opidx++;
+    workloadOp *op = &workload->ops[opidx];
+
+    /* All the runs of keys of a command have the same length. */
+    int nkeys = (int)workloadRandomRange(op->keys_min, op->keys_max);
+    int argc = op->argc + op->runs * (nkeys - 1) + op->pair_runs * nkeys;
+    char key[WORKLOAD_MAX_KEY_LEN];
+    const char *tag = NULL;
+
+    c->obuf = sdscatfmt(c->obuf, "*%i\r\n", argc);
+    for (int j = 0; j < op->argc; j++) {
+        switch (op->argtypes[j]) {
+        case ARG_KEY: {
+            int len = workloadFormatKey(c, key, workloadNextKey(), &tag);
+            c->obuf = workloadCatBulk(c->obuf, key, len);
+            break;
+        }
+        case ARG_KEYS:
+        case ARG_PAIRS:
+            for (int k = 0; k < nkeys; k++) {
+                int len = workloadFormatKey(c, key, workloadNextKey(), &tag);
+                c->obuf = workloadCatBulk(c->obuf, key, len);
+                if (op->argtypes[j] == ARG_PAIRS)
+                    c->obuf = workloadCatBulk(c->obuf, workload->value_data, workloadNextValueSize());
+            }
+            break;
+        case ARG_VALUE: c->obuf = workloadCatBulk(c->obuf, workload->value_data, workloadNextValueSize()); break;
+        default: c->obuf = workloadCatBulk(c->obuf, op->argv[j], sdslen(op->argv[j])); break;
+        }
+    }
+    return opidx;
+}
+
+/* Replace the requests in the output buffer of the client with a new
+ * pipeline of requests generated from the workload. Prefix commands that
+ * were not sent yet are kept. */
+static void workloadBuildRequests(client c) {
+    if (c->prefixlen)
+        sdsrange(c->obuf, 0, c->prefixlen - 1);
+    else
+        sdsclear(c->obuf);
+    for (int j = 0; j < config.pipeline; j++) c->workload_ops[j] = workloadCatRequest(c);
+}
+
+static void workloadRecordLatency(client c, long long latency) {
+    int idx = config.pipeline - c->pending;
+    if (idx < 0 || idx >= config.pipeline) return;
+    struct hdr_histogram *h = workload->ops[c->workload_ops[idx]].latency_histogram;
+    long value = latency <= CONFIG_LATENCY_HISTOGRAM_MAX_VALUE ? (long)latency : CONFIG_LATENCY_HISTOGRAM_MAX_VALUE;
+    if (config.num_threads == 0)
+        hdr_record_value(h, value);
+    else
+        hdr_record_value_atomic(h, value);
+}
+
+static void workloadLoadError(int linenum, const char *msg) {
+    fprintf(stderr, "Error in workload file %s", workload->filename);
+    if (linenum) fprintf(stderr, ", line %d", linenum);
+    fprintf(stderr, ": %s\n", msg);
+    exit(1);
+}
+
+/* Parse "<min>-<max>" or "<n>" into *min and *max. */
+static int workloadParseRange(const char *s, long long *min, long long *max) {
+    char *end;
+    *min = strtoll(s, &end, 10);
+    if (end == s) return 0;
+    if (*end == '-') {
+        const char *p = end + 1;
+        *max = strtoll(p, &end, 10);
+        if (end == p) return 0;
+    } else {
+        *max = *min;
+    }
+    return *end == '\0' && *min >= 0 && *max >= *min;
+}
+
+/* Parse a value-size directive: "<size>", "<min>-<max>", or a comma separated
+ * list of "<size or range>:<weight>". */
+static void workloadParseValueSizes(int linenum, const char *spec) {
+    int count;
+    sds *items = sdssplitlen(spec, strlen(spec), ",", 1, &count);
+    zfree(workload->sizes);
+    workload->sizes = zmalloc(sizeof(workloadValueSize) * count);
+    workload->numsizes = count;
+    workload->max_value_size = 0;
+    double weight = 0;
+    for (int j = 0; j < count; j++) {
+        long long min, max;
+        double w = 1;
+        char *colon = strchr(items[j], ':');
+        if (colon) {
+            *colon = '\0';
+            char *end;
+            w = strtod(colon + 1, &end);
+            if (*end != '\0' || w <= 0) workloadLoadError(linenum, "invalid value-size weight");
+        }
+        if (!workloadParseRange(items[j], &min, &max) || min < 1 || max > 512 * 1024 * 1024)
+            workloadLoadError(linenum, "invalid value-size");
+        weight += w;
+        workload->sizes[j] = (workloadValueSize){(int)min, (int)max, weight};
+        if (max > workload->max_value_size) workload->max_value_size = (int)max;
+    }
+    sdsfreesplitres(items, count);
+}
+
+static void workloadParseOp(int linenum, int argc, sds *argv) {
+    char *end;
+    long long keys_min = 1, keys_max = 1;
+    int first = 2;
+
+    if (argc < 3) workloadLoadError(linenum, "op needs a weight and a command");
+    double weight = strtod(argv[1], &end);
+    if (*end != '\0' || weight <= 0) workloadLoadError(linenum, "invalid op weight");
+    if (!strcasecmp(argv[2], "keys")) {
+        if (argc < 5 || !workloadParseRange(argv[3], &keys_min, &keys_max) || keys_min < 1)
+            workloadLoadError(linenum, "invalid op keys range");
+        first = 4;
+    }
+
+    workload->ops = zrealloc(workload->ops, sizeof(workloadOp) * (workload->numops + 1));
+    workloadOp *op = &workload->ops[workload->numops];
+    op->weight = weight + (workload->numops ? workload->ops[workload->numops - 1].weight : 0);
+    op->keys_min = (int)keys_min;
+    op->keys_max = (int)keys_max;
+    op->argc = argc - first;
+    op->argv = zmalloc(sizeof(sds) * op->argc);
+    op->argtypes = zmalloc(sizeof(workloadArgType) * op->argc);
+    op->runs = op->pair_runs = 0;
+    op->name = sdsempty();
+    for (int j = 0; j < op->argc; j++) {
+        sds arg = argv[first + j];
+        op->argv[j] = sdsdup(arg);
+        if (!strcmp(arg, "__key__")) {
+            op->argtypes[j] = ARG_KEY;
+        } else if (!strcmp(arg, "__keys__")) {
+            op->argtypes[j] = ARG_KEYS;
+            op->runs++;
+        } else if (!strcmp(arg, "__pairs__")) {
+            op->argtypes[j] = ARG_PAIRS;
+            op->runs++;
+            op->pair_runs++;
+        } else if (!strcmp(arg, "__value__")) {
+            op->argtypes[j] = ARG_VALUE;
+        } else {
+            op->argtypes[j] = ARG_LITERAL;
+        }
+        if (j) op->name = sdscatlen(op->name, " ", 1);
+        op->name = sdscatsds(op->name, arg);
+    }
+    hdr_init(CONFIG_LATENCY_HISTOGRAM_MIN_VALUE, CONFIG_LATENCY_HISTOGRAM_MAX_VALUE, config.precision,
+             &op->latency_histogram);
+    workload->numops++;
+}
+
+static void workloadLoad(const char *filename) {
+    workload = zcalloc(sizeof(*workload));
+    workload->filename = filename;
+    workload->keyspace = 1000000;
+    workload->key_prefix = sdsnew("key:");
+    workload->key_dist = KEYDIST_UNIFORM;
+    workload->pipeline = config.pipeline;
+    workloadParseValueSizes(0, "3");
+
+    FILE *fp = fopen(filename, "r");
+    if (!fp) workloadLoadError(0, strerror(errno));
+    char buf[4096];
+    int linenum = 0;
+    while (fgets(buf, sizeof(buf), fp) != NULL) {
+        linenum++;
+        int argc;
+        sds *argv = sdssplitargs(buf, &argc);
+        if (argv == NULL) workloadLoadError(linenum, "unbalanced quotes");
+        if (argc == 0 || argv[0][0] == '#') {
+            sdsfreesplitres(argv, argc);
+            continue;
+        }
+
+        if (!strcasecmp(argv[0], "op")) {
+            workloadParseOp(linenum, argc, argv);
+        } else if (!strcasecmp(argv[0], "keyspace") && argc == 2) {
+            workload->keyspace = strtoll(argv[1], NULL, 10);
+            if (workload->keyspace < 1) workloadLoadError(linenum, "invalid keyspace");
+        } else if (!strcasecmp(argv[0], "key-prefix") && argc == 2) {
+            sdsfree(workload->key_prefix);
+            workload->key_prefix = sdsdup(argv[1]);
+            if (sdslen(workload->key_prefix) > WORKLOAD_MAX_KEY_LEN / 2)
+                workloadLoadError(linenum, "key-prefix too long");
+        } else if (!strcasecmp(argv[0], "key-distribution") && argc >= 2) {
+            if (!strcasecmp(argv[1], "uniform") && argc == 2) {
+                workload->key_dist = KEYDIST_UNIFORM;
+            } else if (!strcasecmp(argv[1], "sequential") && argc == 2) {
+                workload->key_dist = KEYDIST_SEQUENTIAL;
+            } else if (!strcasecmp(argv[1], "zipf") && argc <= 3) {
+                workload->key_dist = KEYDIST_ZIPF;
+                workload->zipf_theta = argc == 3 ? atof(argv[2]) : 0.99;
+                if (workload->zipf_theta <= 0 || workload->zipf_theta >= 1)
+                    workloadLoadError(linenum, "zipf skew must be between 0 and 1");
+            } else if (!strcasecmp(argv[1], "hotspot") && argc == 4) {
+                workload->key_dist = KEYDIST_HOTSPOT;
+                workload->hot_keys = atof(argv[2]);
+                workload->hot_accesses = atof(argv[3]);
+                if (workload->hot_keys <= 0 || workload->hot_keys > 1 || workload->hot_accesses < 0 ||
+                    workload->hot_accesses > 1)
+                    workloadLoadError(linenum, "hotspot fractions must be between 0 and 1");
+            } else {
+                workloadLoadError(linenum, "unknown key-distribution");
+            }
+        } else if (!strcasecmp(argv[0], "value-size") && argc == 2) {
+            workloadParseValueSizes(linenum, argv[1]);
+        } else if (!strcasecmp(argv[0], "pipeline") && argc == 2) {
+            workload->pipeline = atoi(argv[1]);
+            if (workload->pipeline < 1) workloadLoadError(linenum, "invalid pipeline");
+        } else {
+            workloadLoadError(linenum, "unknown directive or wrong number of arguments");
+        }
+        sdsfreesplitres(argv, argc);
+    }
+    fclose(fp);
+
+    if (workload->numops == 0) workloadLoadError(0, "no op defined");
+    if (workload->key_dist == KEYDIST_ZIPF) workloadZipfInit();
+    workload->value_data = zmalloc(workload->max_value_size);
+    genBenchmarkRandomData(workload->value_data, workload->max_value_size);
+    config.pipeline = workload->pipeline;
+}
+
+static void showWorkloadLatencyReport(void) {
+    if (config.quiet || config.json) {
+        for (int j = 0; j < workload->numops; j++) hdr_reset(workload->ops[j].latency_histogram);
+        return;
+    }
+    if (!config.csv) printf("\nLatency by operation (msec):\n");
+    if (!config.csv) printf("  %9s %9s %9s %9s %9s %9s  %s\n", "calls", "avg", "p50", "p95", "p99", "max", "operation");
+    for (int j = 0; j < workload->numops; j++) {
+        workloadOp *op = &workload->ops[j];
+        struct hdr_histogram *h = op->latency_histogram;
+        const float avg = hdr_mean(h) / 1000.0f;
+        const float p50 = hdr_value_at_percentile(h, 50.0) / 1000.0f;
+        const float p95 = hdr_value_at_percentile(h, 95.0) / 1000.0f;
+        const float p99 = hdr_value_at_percentile(h, 99.0) / 1000.0f;
+        const float p100 = ((float)hdr_max(h)) / 1000.0f;
+        if (config.csv) {
+            printf("\"%s: %s\",\"\",\"%.3f\",\"%.3f\",\"%.3f\",\"%.3f\",\"%.3f\",\"%.3f\"\n", config.title, op->name,
+                   avg, ((float)hdr_min(h)) / 1000.0f, p50, p95, p99, p100);
+        } else {
+            printf("  %9lld %9.3f %9.3f %9.3f %9.3f %9.3f  %s\n", (long long)h->total_count, avg, p50, p95, p99, p100,
+                   op->name);
+        }
+        hdr_reset(h);
+    }
+}
+
 static void clientDone(client c) {
     int requests_finished = atomic_load_explicit(&config.requests_finished, memory_order_relaxed);
     if (requests_finished >= config.requests) {
@@ -485,7 +929,7 @@ static void readHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
                      * contain(s) the slot hash tag.
                      * If the error is not topology-update related then we
                      * immediately exit to avoid false results. */
-                    if (c->cluster_node && c->staglen) {
+                    if (c->cluster_node && (c->staglen || workload)) {
                         int fetch_slots = 0, do_wait = 0;
                         if (!strncmp(r->str, "MOVED", 5) || !strncmp(r->str, "ASK", 3))
                             fetch_slots = 1;
@@ -549,6 +993,7 @@ static void readHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
                                                     ? (long)c->latency
                                                     : CONFIG_LATENCY_HISTOGRAM_INSTANT_MAX_VALUE); // Value to record
                     }
+                    if (workload) workloadRecordLatency(c, c->latency);
                 }
                 c->pending--;
                 if (c->pending == 0) {
@@ -562,6 +1007,49 @@ static void readHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
     }
 }
 
+/* Returns the open-loop target rate, in requests per second, at the given
+ * time. With --rps-max the rate moves from --rps to --rps-max during the first
+ * --rps-ramp seconds of the test, linearly or in --rps-steps equal steps. */
+static double rpsTargetAt(long long now) {
+    if (config.rps_max <= 0 || config.rps_ramp_secs <= 0) return config.rps;
+    double progress = (double)(now / 1000 - config.start) / (config.rps_ramp_secs * 1000.0);
+    if (progress < 0) progress = 0;
+    if (progress >= 1) return config.rps_max;
+    if (config.rps_steps > 0) progress = floor(progress * config.rps_steps) / config.rps_steps;
+    return config.rps + (config.rps_max - config.rps) * progress;
+}
+
+/* Every client sends its share of the target rate, one pipeline at a time, so
+ * this is the time in microseconds between two sends of the same client. */
+static long long rpsClientInterval(long long now) {
+    long long interval = (long long)(1000000.0 * config.pipeline * config.numclients / rpsTargetAt(now));
+    return interval > 0 ? interval : 1;
+}
+
+static long long rpsSendTimerHandler(struct aeEventLoop *el, long long id, void *privdata) {
+    UNUSED(id);
+    client c = privdata;
+    c->send_timer_id = -1;
+    aeCreateFileEvent(el, c->context->fd, AE_WRITABLE, writeHandler, c);
+    return AE_NOMORE;
+}
+
+/* In open-loop mode requests are sent on a fixed timeline, instead of as soon
+ * as the reply to the previous request is received. Returns 1 if the next
+ * request of the client is not due yet, after arming a timer that resumes
+ * writing when it is. The first request of each client is sent at a random
+ * point of its first interval, so that clients don't send in bursts. */
+static int rpsWaitForNextSend(aeEventLoop *el, client c) {
+    long long now = ustime();
+    if (c->next_send == 0) c->next_send = now + random() % rpsClientInterval(now);
+    long long wait_ms = (c->next_send - now) / 1000;
+    if (wait_ms <= 0) return 0;
+
+    aeDeleteFileEvent(el, c->context->fd, AE_WRITABLE);
+    c->send_timer_id = aeCreateTimeEvent(el, wait_ms, rpsSendTimerHandler, c, NULL);
+    return 1;
+}
+
 static void writeHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
     client c = privdata;
     UNUSED(el);
@@ -570,6 +1058,8 @@ static void writeHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
 
     /* Initialize request when nothing was written. */
     if (c->written == 0) {
+        if (config.rps > 0 && rpsWaitForNextSend(el, c)) return;
+
         /* Enforce upper bound to number of requests. */
         int requests_issued = atomic_fetch_add_explicit(&config.requests_issued, config.pipeline, memory_order_relaxed);
         if (requests_issued >= config.requests) {
@@ -577,11 +1067,21 @@ static void writeHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
         }
 
         /* Really initialize: randomize keys and set start time. */
+        if (workload) workloadBuildRequests(c);
         if (config.randomkeys) randomizeClientKey(c);
         if (config.cluster_mode && c->staglen > 0) setClusterKeyHashTag(c);
         c->slots_last_update = atomic_load_explicit(&config.slots_last_update, memory_order_relaxed);
         c->start = ustime();
         c->latency = -1;
+        if (config.rps > 0) {
+            /* Measure the latency from the time the request was supposed to
+             * be sent, so that when the server can't keep up with the rate
+             * the time requests spent waiting to be sent is accounted for,
+             * instead of being hidden by the client slowing down (coordinated
+             * omission). */
+            if (c->next_send < c->start) c->start = c->next_send;
+            c->next_send += rpsClientInterval(c->next_send);
+        }
     }
     const ssize_t buflen = sdslen(c->obuf);
     const ssize_t writeLen = buflen - c->written;
@@ -638,6 +1138,11 @@ static client createClient(char *cmd, size_t len, client from, int thread_id) {
     const char *ip = NULL;
     int port = 0;
     c->cluster_node = NULL;
+    /* A client reconnecting with -k 0 carries on with the timeline of the
+     * client it replaces. */
+    c->next_send = from ? from->next_send : 0;
+    c->send_timer_id = -1;
+    c->workload_ops = workload ? zcalloc(sizeof(int) * config.pipeline) : NULL;
     if (config.hostsocket == NULL || is_cluster_client) {
         if (!is_cluster_client) {
             ip = config.conn_info.hostip;
@@ -840,6 +1345,261 @@ static void createMissingClients(client c) {
     }
 }
 
+/* JSON output.
+ *
+ * With --json every test prints a single line with a JSON object, holding
+ * the full latency histogram, the latency of every second of the test, and
+ * the metrics of the server(s) that changed during the test: CPU usage and
+ * INFO commandstats are reported as the difference between before and after
+ * the test, INFO latencystats as they are after the test (they are
+ * cumulative, and are only reported for the commands called by the test). */
+
+static void jsonPrintString(const char *s, size_t len) {
+    putchar('"');
+    for (size_t j = 0; j < len; j++) {
+        unsigned char ch = s[j];
+        if (ch == '"' || ch == '\\')
+            printf("\\%c", ch);
+        else if (ch < 0x20)
+            printf("\\u%04x", ch);
+        else
+            putchar(ch);
+    }
+    putchar('"');
+}
+
+static void jsonPrintLatency(struct hdr_histogram *h) {
+    printf("{\"avg\":%.3f,\"min\":%.3f,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"p99.9\":%.3f,\"max\":%.3f}",
+           hdr_mean(h) / 1000.0, hdr_min(h) / 1000.0, hdr_value_at_percentile(h, 50.0) / 1000.0,
+           hdr_value_at_percentile(h, 95.0) / 1000.0, hdr_value_at_percentile(h, 99.0) / 1000.0,
+           hdr_value_at_percentile(h, 99.9) / 1000.0, hdr_max(h) / 1000.0);
+}
+
+/* Print the buckets of the histogram that have values, as an array of
+ * [<highest latency of the bucket in usec>, <count>]. */
+static void jsonPrintHistogram(struct hdr_histogram *h) {
+    struct hdr_iter iter;
+    int first = 1;
+    hdr_iter_recorded_init(&iter, h);
+    putchar('[');
+    while (hdr_iter_next(&iter)) {
+        printf("%s[%lld,%lld]", first ? "" : ",", (long long)iter.highest_equivalent_value, (long long)iter.count);
+        first = 0;
+    }
+    putchar(']');
+}
+
+/* Append the latency of the requests completed since the last call to the
+ * per second series, then start a new interval. */
+static void jsonRecordInterval(long long now, int requests_finished) {
+    int previous_requests_finished = atomic_load_explicit(&config.previous_requests_finished, memory_order_relaxed);
+    struct hdr_histogram *h = config.current_sec_latency_histogram;
+    long long dt = now - config.previous_tick;
+    if (dt <= 0) return;
+
+    if (sdslen(config.json_intervals)) config.json_intervals = sdscatlen(config.json_intervals, ",", 1);
+    config.json_intervals = sdscatprintf(
+        config.json_intervals,
+        "{\"elapsed_ms\":%lld,\"requests\":%d,\"rps\":%.2f,\"latency_ms\":{\"avg\":%.3f,\"p50\":%.3f,\"p99\":%.3f,"
+        "\"max\":%.3f}}",
+        now - config.start, requests_finished - previous_requests_finished,
+        (requests_finished - previous_requests_finished) * 1000.0 / dt, hdr_mean(h) / 1000.0,
+        hdr_value_at_percentile(h, 50.0) / 1000.0, hdr_value_at_percentile(h, 99.0) / 1000.0, hdr_max(h) / 1000.0);
+    config.previous_tick = now;
+    atomic_store_explicit(&config.previous_requests_finished, requests_finished, memory_order_relaxed);
+    hdr_reset(h);
+}
+
+static sds getServerInfo(const char *ip, int port, const char *hostsocket) {
+    redisContext *ctx = getRedisContext(ip, port, hostsocket);
+    if (ctx == NULL) return NULL;
+    sds info = NULL;
+    redisReply *reply = redisCommand(ctx, "INFO commandstats latencystats cpu");
+    if (reply && (reply->type == REDIS_REPLY_STRING || reply->type == REDIS_REPLY_VERB))
+        info = sdsnewlen(reply->str, reply->len);
+    freeReplyObject(reply);
+    redisFree(ctx);
+    return info;
+}
+
+/* Fetch the INFO of every server the benchmark runs against, which is every
+ * node in cluster mode. Servers that can't be reached have a NULL entry. */
+static sds *getServersInfo(void) {
+    int count = config.cluster_mode ? config.cluster_node_count : 1;
+    sds *info = zcalloc(sizeof(sds) * count);
+    if (config.cluster_mode) {
+        for (int j = 0; j < count; j++)
+            info[j] = getServerInfo(config.cluster_nodes[j]->ip, config.cluster_nodes[j]->port, NULL);
+    } else {
+        info[0] = getServerInfo(config.conn_info.hostip, config.conn_info.hostport, config.hostsocket);
+    }
+    return info;
+}
+
+static void freeServersInfo(sds *info) {
+    if (info == NULL) return;
+    int count = config.cluster_mode ? config.cluster_node_count : 1;
+    for (int j = 0; j < count; j++) sdsfree(info[j]);
+    zfree(info);
+}
+
+/* Returns a pointer to the value of the INFO field 'name' (the text after
+ * "<name>:", up to the end of the line), or NULL if it's missing. */
+static const char *infoGetField(sds info, const char *name) {
+    size_t namelen = strlen(name);
+    const char *p = info;
+    while (info && (p = strstr(p, name)) != NULL) {
+        if ((p == info || p[-1] == '\n') && p[namelen] == ':') return p + namelen + 1;
+        p += namelen;
+    }
+    return NULL;
+}
+
+/* Returns the numeric value of 'key' in an INFO field of the form
+ * "key1=value1,key2=value2,...". */
+static double infoGetFieldValue(const char *field, const char *key) {
+    size_t keylen = strlen(key);
+    const char *p = field;
+    while (p && *p != '\r' && *p != '\n' && *p != '\0') {
+        if (!strncmp(p, key, keylen) && p[keylen] == '=') return strtod(p + keylen + 1, NULL);
+        p = strchr(p, ',');
+        if (p) p++;
+    }
+    return 0;
+}
+
+static void jsonPrintServerMetrics(sds before, sds after) {
+    static const char *cpu_fields[] = {"used_cpu_sys", "used_cpu_user", "used_cpu_sys_main_thread",
+                                       "used_cpu_user_main_thread", NULL};
+    static const char *cmdstat_fields[] = {"calls", "usec", "rejected_calls", "failed_calls", NULL};
+
+    printf("\"cpu_sec\":{");
+    for (int j = 0; cpu_fields[j]; j++) {
+        const char *b = infoGetField(before, cpu_fields[j]), *a = infoGetField(after, cpu_fields[j]);
+        double delta = (a ? strtod(a, NULL) : 0) - (b ? strtod(b, NULL) : 0);
+        printf("%s\"%s\":%.6f", j ? "," : "", cpu_fields[j], delta);
+    }
+    printf("},\"commandstats\":{");
+    int first = 1;
+    const char *line = after;
+    while (line && (line = strstr(line, "cmdstat_")) != NULL) {
+        line += strlen("cmdstat_");
+        const char *colon = strchr(line, ':');
+        if (!colon) break;
+        sds name = sdsnewlen(line, colon - line);
+        sds field = sdscatfmt(sdsempty(), "cmdstat_%S", name);
+        const char *b = infoGetField(before, field);
+        const char *a = colon + 1;
+        double calls = infoGetFieldValue(a, "calls") - (b ? infoGetFieldValue(b, "calls") : 0);
+        if (calls > 0) {
+            printf("%s", first ? "" : ",");
+            jsonPrintString(name, sdslen(name));
+            putchar(':');
+            for (int j = 0; cmdstat_fields[j]; j++) {
+                double delta = infoGetFieldValue(a, cmdstat_fields[j]);
+                if (b) delta -= infoGetFieldValue(b, cmdstat_fields[j]);
+                printf("%s\"%s\":%.0f", j ? "," : "{", cmdstat_fields[j], delta);
+            }
+            putchar('}');
+            first = 0;
+        }
+        sdsfree(field);
+        sdsfree(name);
+    }
+    printf("},\"latencystats\":{");
+    first = 1;
+    line = after;
+    while (line && (line = strstr(line, "latency_percentiles_usec_")) != NULL) {
+        line += strlen("latency_percentiles_usec_");
+        const char *colon = strchr(line, ':');
+        if (!colon) break;
+        sds name = sdsnewlen(line, colon - line);
+        sds field = sdscatfmt(sdsempty(), "cmdstat_%S", name);
+        const char *a = infoGetField(after, field), *b = infoGetField(before, field);
+        if (a && infoGetFieldValue(a, "calls") > (b ? infoGetFieldValue(b, "calls") : 0)) {
+            printf("%s", first ? "" : ",");
+            jsonPrintString(name, sdslen(name));
+            printf(":{");
+            /* The percentiles are "p50=1.003,p99=2.007,...". */
+            const char *p = colon + 1;
+            int firstp = 1;
+            while (*p && *p != '\r' && *p != '\n') {
+                const char *eq = strchr(p, '=');
+                if (!eq) break;
+                printf("%s", firstp ? "" : ",");
+                jsonPrintString(p, eq - p);
+                printf(":%.3f", strtod(eq + 1, NULL));
+                firstp = 0;
+                p = eq + 1;
+                while (*p && *p != ',' && *p != '\r' && *p != '\n') p++;
+                if (*p == ',') p++;
+            }
+            putchar('}');
+            first = 0;
+        }
+        sdsfree(field);
+        sdsfree(name);
+    }
+    putchar('}');
+}
+
+static void showJsonReport(float reqpersec) {
+    long long end = config.start + config.totlatency;
+    if (config.current_sec_latency_histogram->total_count)
+        jsonRecordInterval(end, atomic_load_explicit(&config.requests_finished, memory_order_relaxed));
+
+    printf("{\"test\":");
+    jsonPrintString(config.title, strlen(config.title));
+    printf(",\"requests\":%d,\"clients\":%d,\"pipeline\":%d,\"threads\":%d,\"payload_bytes\":%d,\"duration_ms\":%lld,"
+           "\"rps\":%.2f",
+           config.requests_finished, config.numclients, config.pipeline, config.num_threads, config.datasize,
+           config.totlatency, reqpersec);
+    if (config.rps > 0) printf(",\"target_rps\":%.2f", config.rps);
+    printf(",\"latency_ms\":");
+    jsonPrintLatency(config.latency_histogram);
+    printf(",\"histogram_usec\":");
+    jsonPrintHistogram(config.latency_histogram);
+    if (workload) {
+        printf(",\"operations\":[");
+        for (int j = 0; j < workload->numops; j++) {
+            workloadOp *op = &workload->ops[j];
+            printf("%s{\"operation\":", j ? "," : "");
+            jsonPrintString(op->name, sdslen(op->name));
+            printf(",\"requests\":%lld,\"latency_ms\":", (long long)op->latency_histogram->total_count);
+            jsonPrintLatency(op->latency_histogram);
+            printf(",\"histogram_usec\":");
+            jsonPrintHistogram(op->latency_histogram);
+            putchar('}');
+        }
+        putchar(']');
+    }
+    printf(",\"per_second\":[%s]", config.json_intervals);
+
+    sds *after = getServersInfo();
+    int count = config.cluster_mode ? config.cluster_node_count : 1;
+    printf(",\"servers\":[");
+    for (int j = 0; j < count; j++) {
+        sds address;
+        if (config.cluster_mode)
+            address = sdscatprintf(sdsempty(), "%s:%d", config.cluster_nodes[j]->ip, config.cluster_nodes[j]->port);
+        else if (config.hostsocket)
+            address = sdsnew(config.hostsocket);
+        else
+            address = sdscatprintf(sdsempty(), "%s:%d", config.conn_info.hostip, config.conn_info.hostport);
+        printf("%s{\"address\":", j ? "," : "");
+        jsonPrintString(address, sdslen(address));
+        sdsfree(address);
+        if (config.servers_info_before && config.servers_info_before[j] && after[j]) {
+            putchar(',');
+            jsonPrintServerMetrics(config.servers_info_before[j], after[j]);
+        }
+        putchar('}');
+    }
+    printf("]}\n");
+    fflush(stdout);
+    freeServersInfo(after);
+}
+
 static void showLatencyReport(void) {
     const float reqpersec = (float)config.requests_finished / ((float)config.totlatency / 1000.0f);
     const float p0 = ((float)hdr_min(config.latency_histogram)) / 1000.0f;
@@ -849,6 +1609,10 @@ static void showLatencyReport(void) {
     const float p100 = ((float)hdr_max(config.latency_histogram)) / 1000.0f;
     const float avg = hdr_mean(config.latency_histogram) / 1000.0f;
 
+    if (config.json) {
+        showJsonReport(reqpersec);
+        return;
+    }
     if (!config.quiet && !config.csv) {
         printf("%*s\r", config.last_printed_bytes, " "); // ensure there is a clean line
         printf("====== %s ======\n", config.title);
@@ -856,6 +1620,13 @@ static void showLatencyReport(void) {
         printf("  %d parallel clients\n", config.numclients);
         printf("  %d bytes payload\n", config.datasize);
         printf("  keep alive: %d\n", config.keepalive);
+        if (config.rps > 0) {
+            if (config.rps_max > 0 && config.rps_ramp_secs > 0)
+                printf("  open-loop target rate: %.2f to %.2f requests per second over %d seconds\n", config.rps,
+                       config.rps_max, config.rps_ramp_secs);
+            else
+                printf("  open-loop target rate: %.2f requests per second\n", config.rps);
+        }
         if (config.cluster_mode) {
             const char *node_roles = NULL;
             if (config.read_from_replica == FROM_ALL) {
@@ -978,7 +1749,12 @@ static void benchmark(const char *title, char *cmd, int len) {
     c = createClient(cmd, len, NULL, thread_id);
     createMissingClients(c);
 
+    if (config.json) {
+        sdsclear(config.json_intervals);
+        config.servers_info_before = getServersInfo();
+    }
     config.start = mstime();
+    config.previous_tick = config.start;
     if (!config.num_threads)
         aeMain(config.el);
     else
@@ -986,6 +1762,8 @@ static void benchmark(const char *title, char *cmd, int len) {
     config.totlatency = mstime() - config.start;
 
     showLatencyReport();
+    freeServersInfo(config.servers_info_before);
+    config.servers_info_before = NULL;
     freeAllClients();
     if (config.threads) freeBenchmarkThreads();
     if (config.current_sec_latency_histogram) hdr_close(config.current_sec_latency_histogram);
@@ -1371,6 +2149,8 @@ int parseOptions(int argc, char **argv) {
             config.quiet = 1;
         } else if (!strcmp(argv[i], "--csv")) {
             config.csv = 1;
+        } else if (!strcmp(argv[i], "--json")) {
+            config.json = 1;
         } else if (!strcmp(argv[i], "-l")) {
             config.loop = 1;
         } else if (!strcmp(argv[i], "-I")) {
@@ -1411,6 +2191,25 @@ int parseOptions(int argc, char **argv) {
                 config.num_threads = MAX_THREADS;
             } else if (config.num_threads < 0)
                 config.num_threads = 0;
+        } else if (!strcmp(argv[i], "--rps")) {
+            if (lastarg) goto invalid;
+            config.rps = atof(argv[++i]);
+            if (config.rps <= 0) goto invalid;
+        } else if (!strcmp(argv[i], "--rps-max")) {
+            if (lastarg) goto invalid;
+            config.rps_max = atof(argv[++i]);
+            if (config.rps_max <= 0) goto invalid;
+        } else if (!strcmp(argv[i], "--rps-ramp")) {
+            if (lastarg) goto invalid;
+            config.rps_ramp_secs = atoi(argv[++i]);
+            if (config.rps_ramp_secs <= 0) goto invalid;
+        } else if (!strcmp(argv[i], "--rps-steps")) {
+            if (lastarg) goto invalid;
+            config.rps_steps = atoi(argv[++i]);
+            if (config.rps_steps < 0) goto invalid;
+        } else if (!strcmp(argv[i], "--workload")) {
+            if (lastarg) goto invalid;
+            config.workload_file = argv[++i];
         } else if (!strcmp(argv[i], "--cluster")) {
             config.cluster_mode = 1;
         } else if (!strcmp(argv[i], "--rfr")) {
@@ -1503,7 +2302,7 @@ usage:
         "";
 
     printf(
-        "%s%s%s", /* Split to avoid strings longer than 4095 (-Woverlength-strings). */
+        "%s%s%s%s", /* Split to avoid strings longer than 4095 (-Woverlength-strings). */
         "Usage: valkey-benchmark [OPTIONS] [COMMAND ARGS...]\n\n"
         "Options:\n"
         " -h <hostname>      Server hostname (default 127.0.0.1)\n"
@@ -1534,8 +2333,29 @@ usage:
         "                    'yes' - sends read requests to replicas only.\n"
         "                    'all' - sends read requests to all nodes.\n"
         "                    Since write commands will not be accepted by replicas,\n"
-        "                    it is recommended to enable read from replicas only for read command tests.\n"
+        "                    it is recommended to enable read from replicas only for read command tests.\n",
         " --enable-tracking  Send CLIENT TRACKING on before starting benchmark.\n"
+        " --rps <rate>       Open-loop mode: send <rate> requests per second in total,\n"
+        "                    on a fixed timeline, regardless of how fast replies arrive.\n"
+        "                    Latency is measured from the time each request was\n"
+        "                    supposed to be sent.\n"
+        " --rps-max <rate>   Move the open-loop rate from --rps to <rate> during the\n"
+        "                    --rps-ramp period, to find where latency starts to grow.\n"
+        " --rps-ramp <secs>  Duration of the rate schedule (default 60).\n"
+        " --rps-steps <num>  Change the rate in <num> equal steps instead of linearly.\n"
+        " --workload <file>  Generate the requests from a workload file instead of running\n"
+        "                    the tests, and report the latency of every operation.\n"
+        "                    Each line of the file is one of these directives:\n"
+        "                    'op <weight> [keys <min>-<max>] <command> [args...]' adds an\n"
+        "                    operation to the mix, where the arguments __key__, __keys__,\n"
+        "                    __pairs__ and __value__ are replaced with a key, a run of\n"
+        "                    keys, a run of key value pairs and a value respectively.\n"
+        "                    'keyspace <n>' (default 1000000), 'key-prefix <prefix>',\n"
+        "                    'key-distribution uniform|sequential|zipf [<skew>]|\n"
+        "                    hotspot <hot-keys-fraction> <hot-accesses-fraction>',\n"
+        "                    'value-size <size>|<min>-<max>[:<weight>],...' and\n"
+        "                    'pipeline <n>'. In cluster mode every node gets its own\n"
+        "                    copy of the keyspace.\n"
         " -k <boolean>       1=keep alive 0=reconnect (default 1)\n"
         " -r <keyspacelen>   Use random keys for SET/GET/INCR, random values for SADD,\n"
         "                    random members and scores for ZADD.\n"
@@ -1551,6 +2371,9 @@ usage:
         " -q                 Quiet. Just show query/sec values\n"
         " --precision        Number of decimal places to display in latency output (default 0)\n"
         " --csv              Output in CSV format\n"
+        " --json             Output one JSON object per test, with the latency\n"
+        "                    histogram, the latency of every second, and the CPU,\n"
+        "                    commandstats and latencystats of the server(s).\n"
         " -l                 Loop. Run the tests forever\n"
         " -t <tests>         Only run the comma separated list of tests. The test\n"
         "                    names are the same as the ones produced as output.\n"
@@ -1579,6 +2402,8 @@ usage:
         "   $ valkey-benchmark -t ping,set,get -n 100000 --csv\n\n"
         " Benchmark a specific command line:\n"
         "   $ valkey-benchmark -r 10000 -n 10000 eval 'return redis.call(\"ping\")' 0\n\n"
+        " Send 20k GET requests per second, and report the latency at that rate:\n"
+        "   $ valkey-benchmark -t get -n 600000 --rps 20000\n\n"
         " Fill a list with 10000 random elements:\n"
         "   $ valkey-benchmark -r 10000 -n 10000 lpush mylist __rand_int__\n\n"
         " On user specified command lines __rand_int__ is replaced with a random integer\n"
@@ -1603,7 +2428,11 @@ long long showThroughput(struct aeEventLoop *eventLoop, long long id, void *clie
         aeStop(eventLoop);
         return AE_NOMORE;
     }
-    if (config.csv) return SHOW_THROUGHPUT_INTERVAL;
+    /* In JSON mode the first thread records the latency of every second of
+     * the test instead of showing it. */
+    if (config.json && (thread == NULL || thread->index == 0) && current_tick - config.previous_tick >= 1000)
+        jsonRecordInterval(current_tick, requests_finished);
+    if (config.csv || config.json) return SHOW_THROUGHPUT_INTERVAL;
     /* only first thread output throughput */
     if (thread != NULL && thread->index != 0) {
         return SHOW_THROUGHPUT_INTERVAL;
@@ -1730,11 +2559,25 @@ int main(int argc, char **argv) {
     config.num_functions = 10;
     config.num_keys_in_fcall = 1;
     config.resp3 = 0;
+    config.rps = 0;
+    config.rps_max = 0;
+    config.rps_ramp_secs = 60;
+    config.rps_steps = 0;
+    config.workload_file = NULL;
+    config.json = 0;
+    config.json_intervals = sdsempty();
+    config.servers_info_before = NULL;
 
     i = parseOptions(argc, argv);
     argc -= i;
     argv += i;
 
+    if (config.rps_max > 0 && config.rps == 0) {
+        fprintf(stderr, "--rps-max can only be used together with --rps.\n");
+        exit(1);
+    }
+    if (config.workload_file) workloadLoad(config.workload_file);
+
     tag = "";
 
 #ifdef USE_OPENSSL
@@ -1774,7 +2617,7 @@ int main(int argc, char **argv) {
         } else {
             node_roles = "primary";
         }
-        printf("Cluster has %d %s nodes:\n\n", config.cluster_node_count, node_roles);
+        if (!config.json) printf("Cluster has %d %s nodes:\n\n", config.cluster_node_count, node_roles);
         int i = 0;
         for (; i < config.cluster_node_count; i++) {
             clusterNode *node = config.cluster_nodes[i];
@@ -1782,16 +2625,18 @@ int main(int argc, char **argv) {
                 fprintf(stderr, "Invalid cluster node #%d\n", i);
                 exit(1);
             }
-            const char *node_type = (node->replicate == NULL ? "Primary" : "Replica");
-            printf("Node %d(%s): ", i, node_type);
-            if (node->name) printf("%s ", node->name);
-            printf("%s:%d\n", node->ip, node->port);
+            if (!config.json) {
+                const char *node_type = (node->replicate == NULL ? "Primary" : "Replica");
+                printf("Node %d(%s): ", i, node_type);
+                if (node->name) printf("%s ", node->name);
+                printf("%s:%d\n", node->ip, node->port);
+            }
             node->redis_config = getServerConfig(node->ip, node->port, NULL);
             if (node->redis_config == NULL) {
                 fprintf(stderr, "WARNING: Could not fetch node CONFIG %s:%d\n", node->ip, node->port);
             }
         }
-        printf("\n");
+        if (!config.json) printf("\n");
         /* Automatically set thread number to node count if not specified
          * by the user. */
         if (config.num_threads == 0) config.num_threads = config.cluster_node_count;
@@ -1812,7 +2657,7 @@ int main(int argc, char **argv) {
                         "'sudo sysctl -w net.inet.tcp.msl=1000' for Mac OS X in order "
                         "to use a lot of clients/requests\n");
     }
-    if (argc > 0 && config.tests != NULL) {
+    if ((argc > 0 || workload) && config.tests != NULL) {
         fprintf(stderr, "WARNING: Option -t is ignored.\n");
     }
 
@@ -1831,10 +2676,22 @@ int main(int argc, char **argv) {
             aeMain(config.el);
         /* and will wait for every */
     }
-    if (config.csv) {
+    if (config.csv && !config.json) {
         printf("\"test\",\"rps\",\"avg_latency_ms\",\"min_latency_ms\",\"p50_latency_ms\",\"p95_latency_ms\",\"p99_"
                "latency_ms\",\"max_latency_ms\"\n");
     }
+    /* Run benchmark with the requests of the workload file. */
+    if (workload) {
+        sds title = sdscatfmt(sdsempty(), "workload %s", workload->filename);
+        do {
+            benchmark(title, "", 0);
+            showWorkloadLatencyReport();
+        } while (config.loop);
+        sdsfree(title);
+        if (config.redis_config != NULL) freeServerConfig(config.redis_config);
+        return 0;
+    }
+
     /* Run benchmark with command in the remainder of the arguments. */
     if (argc) {
         sds title = sdsnew(argv[0]);
@@ -2054,7 +2911,7 @@ int main(int argc, char **argv) {
             free(cmd);
         }
 
-        if (!config.csv) printf("\n");
+        if (!config.csv && !config.json) printf("\n");
     } while (config.loop);
 
     zfree(data);
@@ -45,6 +45,7 @@
 #include <limits.h>
 #include <math.h>
 #include <termios.h>
+#include <pthread.h>
 
 #include <hiredis.h>
 #ifdef USE_OPENSSL
@@ -64,6 +65,7 @@
 #include "cli_common.h"
 #include "mt19937-64.h"
 #include "cli_commands.h"
+#include "hdr_histogram.h"
 
 #include "valkey_strtod.h"
 
@@ -87,6 +89,8 @@
 #define CLUSTER_MANAGER_PORT_INCR 10000 /* same as CLUSTER_PORT_INCR */
 #define CLUSTER_MANAGER_MIGRATE_TIMEOUT 60000
 #define CLUSTER_MANAGER_MIGRATE_PIPELINE 10
+#define CLUSTER_MANAGER_MIGRATE_PIPELINE_MAX 10000
+#define CLUSTER_MANAGER_MIGRATE_LATENCY 100 /* Target duration of a MIGRATE in milliseconds. */
 #define CLUSTER_MANAGER_REBALANCE_THRESHOLD 2
 
 #define CLUSTER_MANAGER_INVALID_HOST_ARG                        \
@@ -134,6 +138,7 @@
 #define CLUSTER_MANAGER_OPT_GETFRIENDS 1 << 0
 #define CLUSTER_MANAGER_OPT_COLD 1 << 1
 #define CLUSTER_MANAGER_OPT_UPDATE 1 << 2
+#define CLUSTER_MANAGER_OPT_NO_BROADCAST 1 << 3
 #define CLUSTER_MANAGER_OPT_QUIET 1 << 6
 #define CLUSTER_MANAGER_OPT_VERBOSE 1 << 7
 
@@ -194,6 +199,7 @@ typedef struct clusterManagerCommand {
     int slots;
     int timeout;
     int pipeline;
+    int parallel;
     float threshold;
     char *backup_dir;
     char *from_user;
@@ -245,6 +251,7 @@ static struct config {
     int memkeys;
     unsigned memkeys_samples;
     int hotkeys;
+    int connections;      /* Connections scanning the keyspace in --bigkeys and similar modes. */
     int stdin_lastarg;    /* get last arg from stdin. (-x option) */
     int stdin_tag_arg;    /* get <tag> arg from stdin. (-X option) */
     char *stdin_tag_name; /* Placeholder(tag name) for user input. */
@@ -2680,6 +2687,8 @@ static int parseOptions(int argc, char **argv) {
             config.memkeys_samples = atoi(argv[++i]);
         } else if (!strcmp(argv[i], "--hotkeys")) {
             config.hotkeys = 1;
+        } else if (!strcmp(argv[i], "--connections") && !lastarg) {
+            config.connections = atoi(argv[++i]);
         } else if (!strcmp(argv[i], "--eval") && !lastarg) {
             config.eval = argv[++i];
         } else if (!strcmp(argv[i], "--ldb")) {
@@ -2762,6 +2771,8 @@ static int parseOptions(int argc, char **argv) {
             config.cluster_manager_command.timeout = atoi(argv[++i]);
         } else if (!strcmp(argv[i], "--cluster-pipeline") && !lastarg) {
             config.cluster_manager_command.pipeline = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--cluster-parallel") && !lastarg) {
+            config.cluster_manager_command.parallel = atoi(argv[++i]);
         } else if (!strcmp(argv[i], "--cluster-threshold") && !lastarg) {
             config.cluster_manager_command.threshold = atof(argv[++i]);
         } else if (!strcmp(argv[i], "--cluster-yes")) {
@@ -3010,6 +3021,8 @@ static void usage(int err) {
             "                     And define number of key elements to sample\n"
             "  --hotkeys          Sample keys looking for hot keys.\n"
             "                     only works when maxmemory-policy is *lfu.\n"
+            "  --connections <n>  Number of connections scanning the keyspace in parallel with\n"
+            "                     the --bigkeys, --memkeys or --hotkeys options (default: 1).\n"
             "  --scan             List all keys using the SCAN command.\n"
             "  --pattern <pat>    Keys pattern when using the --scan, --bigkeys or --hotkeys\n"
             "                     options (default: *).\n"
@@ -3558,6 +3571,8 @@ typedef struct clusterManagerNode {
     int importing_count; /* Length of the importing array (importing slots*2) */
     float weight;        /* Weight used by rebalance */
     int balance;         /* Used by rebalance */
+    int migrate_batch;   /* Keys per MIGRATE from this node, 0 if not sized yet */
+    long long migrated_keys;
 } clusterManagerNode;
 
 /* Data structure used to represent a sequence of cluster nodes. */
@@ -3571,7 +3586,9 @@ typedef struct clusterManagerNodeArray {
 /* Used for the reshard table. */
 typedef struct clusterManagerReshardTableItem {
     clusterManagerNode *source;
+    clusterManagerNode *target;
     int slot;
+    int moved; /* Used by clusterManagerMoveSlots */
 } clusterManagerReshardTableItem;
 
 /* Info about a cluster internal link. */
@@ -3668,11 +3685,12 @@ clusterManagerCommandDef clusterManagerCommands[] = {
      "search-multiple-owners,fix-with-unreachable-primaries"},
     {"reshard", clusterManagerCommandReshard, -1, "<host:port> or <host> <port> - separated by either colon or space",
      "from <arg>,to <arg>,slots <arg>,yes,timeout <arg>,pipeline <arg>,"
-     "replace"},
+     "parallel <arg>,replace"},
     {"rebalance", clusterManagerCommandRebalance, -1,
      "<host:port> or <host> <port> - separated by either colon or space",
      "weight <node1=w1...nodeN=wN>,use-empty-primaries,"
-     "timeout <arg>,simulate,pipeline <arg>,threshold <arg>,replace"},
+     "timeout <arg>,simulate,pipeline <arg>,parallel <arg>,threshold <arg>,"
+     "replace"},
     {"add-node", clusterManagerCommandAddNode, 2, "new_host:new_port existing_host:existing_port",
      "replica,primaries-id <arg>"},
     {"del-node", clusterManagerCommandDeleteNode, 2, "host:port node_id", NULL},
@@ -3881,6 +3899,8 @@ static clusterManagerNode *clusterManagerNewNode(char *ip, int port, int bus_por
     node->replicas_count = 0;
     node->weight = 1.0f;
     node->balance = 0;
+    node->migrate_batch = 0;
+    node->migrated_keys = 0;
     clusterManagerNodeResetSlots(node);
     return node;
 }
@@ -4857,7 +4877,21 @@ cleanup:
     return migrate_reply;
 }
 
-/* Migrate all keys in the given slot from source to target.*/
+/* Sizes the MIGRATE batches of a source node so that each call blocks it for
+ * about CLUSTER_MANAGER_MIGRATE_LATENCY milliseconds: the best batch size
+ * depends on the size of the keys and on the network. */
+static void clusterManagerAdaptMigrateBatch(clusterManagerNode *source, size_t count, long long latency) {
+    if (latency > CLUSTER_MANAGER_MIGRATE_LATENCY) {
+        if (source->migrate_batch > 1) source->migrate_batch /= 2;
+    } else if (latency < CLUSTER_MANAGER_MIGRATE_LATENCY / 2 && count == (size_t)source->migrate_batch) {
+        source->migrate_batch *= 2;
+        if (source->migrate_batch > CLUSTER_MANAGER_MIGRATE_PIPELINE_MAX)
+            source->migrate_batch = CLUSTER_MANAGER_MIGRATE_PIPELINE_MAX;
+    }
+}
+
+/* Migrate all keys in the given slot from source to target. The first batch
+ * has 'pipeline' keys, the next ones are sized from the MIGRATE latency. */
 static int clusterManagerMigrateKeysInSlot(clusterManagerNode *source,
                                            clusterManagerNode *target,
                                            int slot,
@@ -4866,6 +4900,7 @@ static int clusterManagerMigrateKeysInSlot(clusterManagerNode *source,
                                            int verbose,
                                            char **err) {
     int success = 1;
+    if (source->migrate_batch == 0) source->migrate_batch = pipeline > 0 ? pipeline : CLUSTER_MANAGER_MIGRATE_PIPELINE;
     int do_fix = config.cluster_manager_command.flags & CLUSTER_MANAGER_CMD_FLAG_FIX;
     int do_replace = config.cluster_manager_command.flags & CLUSTER_MANAGER_CMD_FLAG_REPLACE;
     while (1) {
@@ -4874,7 +4909,7 @@ static int clusterManagerMigrateKeysInSlot(clusterManagerNode *source,
         reply = CLUSTER_MANAGER_COMMAND(source,
                                         "CLUSTER "
                                         "GETKEYSINSLOT %d %d",
-                                        slot, pipeline);
+                                        slot, source->migrate_batch);
         success = (reply != NULL);
         if (!success) return 0;
         if (reply->type == REDIS_REPLY_ERROR) {
@@ -4894,8 +4929,10 @@ static int clusterManagerMigrateKeysInSlot(clusterManagerNode *source,
         }
         if (verbose) dots = zmalloc((count + 1) * sizeof(char));
         /* Calling MIGRATE command. */
+        long long start = mstime();
         migrate_reply = clusterManagerMigrateKeysInReply(source, target, reply, 0, timeout, dots);
         if (migrate_reply == NULL) goto next;
+        if (migrate_reply->type != REDIS_REPLY_ERROR) clusterManagerAdaptMigrateBatch(source, count, mstime() - start);
         if (migrate_reply->type == REDIS_REPLY_ERROR) {
             int is_busy = strstr(migrate_reply->str, "BUSYKEY") != NULL;
             int not_served = 0;
@@ -5006,6 +5043,7 @@ static int clusterManagerMigrateKeysInSlot(clusterManagerNode *source,
                 goto next;
             }
         }
+        source->migrated_keys += count;
         if (verbose) {
             printf("%s", dots);
             fflush(stdout);
@@ -5027,6 +5065,8 @@ static int clusterManagerMigrateKeysInSlot(clusterManagerNode *source,
  *                                reconfiguring the nodes.
  * CLUSTER_MANAGER_OPT_UPDATE  -- Update node->slots for source/target nodes.
  * CLUSTER_MANAGER_OPT_QUIET   -- Don't print info messages.
+ * CLUSTER_MANAGER_OPT_NO_BROADCAST -- Only set the new owner of the slot in
+ *                                the source and target nodes.
  */
 static int
 clusterManagerMoveSlot(clusterManagerNode *source, clusterManagerNode *target, int slot, int opts, char **err) {
@@ -5099,7 +5139,7 @@ clusterManagerMoveSlot(clusterManagerNode *source, clusterManagerNode *target, i
         listIter li;
         listNode *ln;
         listRewind(cluster_manager.nodes, &li);
-        while ((ln = listNext(&li)) != NULL) {
+        while (!(opts & CLUSTER_MANAGER_OPT_NO_BROADCAST) && (ln = listNext(&li)) != NULL) {
             clusterManagerNode *n = ln->value;
             if (n == target || n == source) continue; /* already done */
             if (n->flags & CLUSTER_MANAGER_FLAG_REPLICA) continue;
@@ -6549,7 +6589,7 @@ static list *clusterManagerComputeReshardTable(list *sources, int numslots) {
             int slot = node->slots[j];
             if (!slot) continue;
             if (count >= max || (int)listLength(moved) >= numslots) break;
-            clusterManagerReshardTableItem *item = zmalloc(sizeof(*item));
+            clusterManagerReshardTableItem *item = zcalloc(sizeof(*item));
             item->source = node;
             item->slot = j;
             listAddNodeTail(moved, item);
@@ -6584,6 +6624,236 @@ static void clusterManagerReleaseReshardTable(list *table) {
     }
 }
 
+/* The slots of a reshard table moved by the same thread of
+ * clusterManagerMoveSlots: the keys of a node are migrated one MIGRATE at a
+ * time anyway, so each thread handles all the slots of a source node. */
+typedef struct clusterManagerMoveJob {
+    clusterManagerNode *source;
+    list *items;
+} clusterManagerMoveJob;
+
+typedef struct clusterManagerMoveState {
+    pthread_mutex_t lock;
+    clusterManagerMoveJob *jobs;
+    int numjobs;
+    int next_job;
+    int opts;
+    int failed;
+    long long moved_keys;
+} clusterManagerMoveState;
+
+/* Returns a copy of 'node' with its own connection, so that the threads of
+ * clusterManagerMoveSlots don't share the connections of the nodes. */
+static clusterManagerNode *clusterManagerMoveJobConnect(clusterManagerNode *node) {
+    clusterManagerNode *copy = zmalloc(sizeof(*copy));
+    *copy = *node;
+    copy->context = NULL;
+    copy->migrate_batch = 0;
+    copy->migrated_keys = 0;
+    if (!clusterManagerNodeConnect(copy)) {
+        if (copy->context) redisFree(copy->context);
+        zfree(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+static void *clusterManagerMoveSlotsThread(void *arg) {
+    clusterManagerMoveState *state = arg;
+    while (1) {
+        pthread_mutex_lock(&state->lock);
+        clusterManagerMoveJob *job = state->failed || state->next_job == state->numjobs
+                                         ? NULL
+                                         : &state->jobs[state->next_job++];
+        pthread_mutex_unlock(&state->lock);
+        if (job == NULL) break;
+
+        /* The connections to the source node and to its target nodes. */
+        clusterManagerNode *source = clusterManagerMoveJobConnect(job->source);
+        list *targets = listCreate();
+        int success = source != NULL;
+        listIter li, ti;
+        listNode *ln, *tn;
+        listRewind(job->items, &li);
+        while (success && (ln = listNext(&li)) != NULL) {
+            clusterManagerReshardTableItem *item = ln->value;
+            clusterManagerNode *target = NULL;
+            listRewind(targets, &ti);
+            while ((tn = listNext(&ti)) != NULL) {
+                clusterManagerNode *n = tn->value;
+                if (!sdscmp(n->name, item->target->name)) target = n;
+            }
+            if (target == NULL) {
+                target = clusterManagerMoveJobConnect(item->target);
+                if (target == NULL) {
+                    success = 0;
+                    break;
+                }
+                listAddNodeTail(targets, target);
+            }
+
+            char *err = NULL;
+            success = clusterManagerMoveSlot(source, target, item->slot, state->opts, &err);
+            pthread_mutex_lock(&state->lock);
+            if (success) {
+                item->moved = 1;
+                printf("#");
+                fflush(stdout);
+            } else if (err != NULL) {
+                clusterManagerLogErr("\n*** clusterManagerMoveSlot failed: %s\n", err);
+            }
+            if (state->failed) success = 0;
+            pthread_mutex_unlock(&state->lock);
+            if (err) zfree(err);
+        }
+
+        pthread_mutex_lock(&state->lock);
+        if (!success) state->failed = 1;
+        if (source) state->moved_keys += source->migrated_keys;
+        pthread_mutex_unlock(&state->lock);
+        if (source) {
+            redisFree(source->context);
+            zfree(source);
+        }
+        listRewind(targets, &ti);
+        while ((tn = listNext(&ti)) != NULL) {
+            clusterManagerNode *n = tn->value;
+            redisFree(n->context);
+            zfree(n);
+        }
+        listRelease(targets);
+    }
+    return NULL;
+}
+
+/* Informs the nodes other than the sources and the targets of the new owners
+ * of the slots moved by the threads of clusterManagerMoveSlots, pipelining
+ * the commands sent to each node. */
+static int clusterManagerBroadcastMovedSlots(list *table) {
+    int success = 1;
+    listIter li, ti;
+    listNode *ln, *tn;
+    listRewind(cluster_manager.nodes, &li);
+    while ((ln = listNext(&li)) != NULL) {
+        clusterManagerNode *n = ln->value;
+        if (n->flags & CLUSTER_MANAGER_FLAG_REPLICA) continue;
+        int pending = 0;
+        listRewind(table, &ti);
+        while ((tn = listNext(&ti)) != NULL) {
+            clusterManagerReshardTableItem *item = tn->value;
+            if (!item->moved || n == item->source || n == item->target) continue;
+            redisAppendCommand(n->context, "CLUSTER SETSLOT %d node %s", item->slot, item->target->name);
+            pending++;
+        }
+        while (pending--) {
+            redisReply *reply = NULL;
+            if (redisGetReply(n->context, (void **)&reply) != REDIS_OK) {
+                clusterManagerLogErr("*** Error setting the new slot owners in %s:%d\n", n->ip, n->port);
+                return 0;
+            }
+            if (!clusterManagerCheckRedisReply(n, reply, NULL)) success = 0;
+            freeReplyObject(reply);
+        }
+    }
+    return success;
+}
+
+/* Moves the slots of a reshard table, whose items have their target set,
+ * with clusterManagerMoveSlot() and the given options, then reports the
+ * throughput.
+ *
+ * With --cluster-parallel <n> the slots of up to 'n' source nodes are moved
+ * at the same time, by threads using their own connections. The threads only
+ * set the new owner of the slots in the source and target nodes, the other
+ * nodes are informed once they are done. */
+static int clusterManagerMoveSlots(list *table, int opts) {
+    long long start = mstime(), moved_keys = 0;
+    int parallel = config.cluster_manager_command.parallel, numjobs = 0, moved_slots = 0, success = 1, i;
+    clusterManagerMoveJob *jobs = zcalloc(sizeof(*jobs) * listLength(table));
+    listIter li;
+    listNode *ln;
+
+    /* Group the slots by source node. */
+    listRewind(table, &li);
+    while ((ln = listNext(&li)) != NULL) {
+        clusterManagerReshardTableItem *item = ln->value;
+        i = 0;
+        while (i < numjobs && jobs[i].source != item->source) i++;
+        if (i == numjobs) {
+            jobs[numjobs].source = item->source;
+            jobs[numjobs].items = listCreate();
+            jobs[numjobs].source->migrated_keys = 0;
+            numjobs++;
+        }
+        listAddNodeTail(jobs[i].items, item);
+    }
+    if (parallel > numjobs) parallel = numjobs;
+
+    if (parallel <= 1) {
+        listRewind(table, &li);
+        while ((ln = listNext(&li)) != NULL) {
+            clusterManagerReshardTableItem *item = ln->value;
+            char *err = NULL;
+            success = clusterManagerMoveSlot(item->source, item->target, item->slot, opts, &err);
+            if (!success) {
+                if (err != NULL) {
+                    clusterManagerLogErr("*** clusterManagerMoveSlot failed: %s\n", err);
+                    zfree(err);
+                }
+                break;
+            }
+            moved_slots++;
+            if (opts & CLUSTER_MANAGER_OPT_QUIET) {
+                printf("#");
+                fflush(stdout);
+            }
+        }
+        for (i = 0; i < numjobs; i++) moved_keys += jobs[i].source->migrated_keys;
+    } else {
+        clusterManagerMoveState state = {0};
+        pthread_t *threads = zmalloc(sizeof(pthread_t) * parallel);
+        pthread_mutex_init(&state.lock, NULL);
+        state.jobs = jobs;
+        state.numjobs = numjobs;
+        state.opts = (opts | CLUSTER_MANAGER_OPT_QUIET | CLUSTER_MANAGER_OPT_NO_BROADCAST) &
+                     ~(CLUSTER_MANAGER_OPT_VERBOSE | CLUSTER_MANAGER_OPT_UPDATE);
+        printf("Moving slots from %d nodes with %d parallel migrations\n", numjobs, parallel);
+        for (i = 0; i < parallel; i++) {
+            if (pthread_create(&threads[i], NULL, clusterManagerMoveSlotsThread, &state)) {
+                fprintf(stderr, "Failed to create a thread to move slots!\n");
+                exit(1);
+            }
+        }
+        for (i = 0; i < parallel; i++) pthread_join(threads[i], NULL);
+        zfree(threads);
+        pthread_mutex_destroy(&state.lock);
+        success = !state.failed;
+        moved_keys = state.moved_keys;
+
+        listRewind(table, &li);
+        while ((ln = listNext(&li)) != NULL) {
+            clusterManagerReshardTableItem *item = ln->value;
+            if (!item->moved) continue;
+            moved_slots++;
+            if (opts & CLUSTER_MANAGER_OPT_UPDATE) {
+                item->source->slots[item->slot] = 0;
+                item->target->slots[item->slot] = 1;
+            }
+        }
+        if (!clusterManagerBroadcastMovedSlots(table)) success = 0;
+    }
+    if (opts & CLUSTER_MANAGER_OPT_QUIET || parallel > 1) printf("\n");
+
+    for (i = 0; i < numjobs; i++) listRelease(jobs[i].items);
+    zfree(jobs);
+
+    double elapsed = (double)(mstime() - start) / 1000;
+    clusterManagerLogInfo(">>> Moved %d slots and %lld keys in %.2f seconds (%.2f slots/sec, %.2f keys/sec)\n",
+                          moved_slots, moved_keys, elapsed, elapsed > 0 ? moved_slots / elapsed : 0,
+                          elapsed > 0 ? moved_keys / elapsed : 0);
+    return success;
+}
+
 static void clusterManagerLog(int level, const char *fmt, ...) {
     int use_colors = (config.cluster_manager_command.flags & CLUSTER_MANAGER_CMD_FLAG_COLOR);
     if (use_colors) {
@@ -7379,20 +7649,12 @@ static int clusterManagerCommandReshard(int argc, char **argv) {
             goto cleanup;
         }
     }
-    int opts = CLUSTER_MANAGER_OPT_VERBOSE;
     listRewind(table, &li);
     while ((ln = listNext(&li)) != NULL) {
         clusterManagerReshardTableItem *item = ln->value;
-        char *err = NULL;
-        result = clusterManagerMoveSlot(item->source, target, item->slot, opts, &err);
-        if (!result) {
-            if (err != NULL) {
-                clusterManagerLogErr("clusterManagerMoveSlot failed: %s\n", err);
-                zfree(err);
-            }
-            goto cleanup;
-        }
+        item->target = target;
     }
+    result = clusterManagerMoveSlots(table, CLUSTER_MANAGER_OPT_VERBOSE);
 cleanup:
     listRelease(sources);
     clusterManagerReleaseReshardTable(table);
@@ -7406,7 +7668,7 @@ static int clusterManagerCommandRebalance(int argc, char **argv) {
     int port = 0;
     char *ip = NULL;
     clusterManagerNode **weightedNodes = NULL;
-    list *involved = NULL;
+    list *involved = NULL, *moves = NULL;
     if (!getClusterHostFromCmdArgs(argc, argv, &ip, &port)) goto invalid_args;
     clusterManagerNode *node = clusterManagerNewNode(ip, port, 0);
     if (!clusterManagerLoadInfoFromNode(node)) return 0;
@@ -7525,6 +7787,9 @@ static int clusterManagerCommandRebalance(int argc, char **argv) {
     int dst_idx = 0;
     int src_idx = nodes_involved - 1;
     int simulate = config.cluster_manager_command.flags & CLUSTER_MANAGER_CMD_FLAG_SIMULATE;
+    /* The slots to move between all the pairs of nodes, so that the moves
+     * between different nodes can run in parallel. */
+    moves = listCreate();
     while (dst_idx < src_idx) {
         clusterManagerNode *dst = weightedNodes[dst_idx];
         clusterManagerNode *src = weightedNodes[src_idx];
@@ -7547,23 +7812,18 @@ static int clusterManagerCommandRebalance(int argc, char **argv) {
             }
             if (simulate) {
                 for (i = 0; i < table_len; i++) printf("#");
-            } else {
-                int opts = CLUSTER_MANAGER_OPT_QUIET | CLUSTER_MANAGER_OPT_UPDATE;
-                listRewind(table, &li);
-                while ((ln = listNext(&li)) != NULL) {
-                    clusterManagerReshardTableItem *item = ln->value;
-                    char *err;
-                    result = clusterManagerMoveSlot(item->source, dst, item->slot, opts, &err);
-                    if (!result) {
-                        clusterManagerLogErr("*** clusterManagerMoveSlot: %s\n", err);
-                        zfree(err);
-                        goto end_move;
-                    }
-                    printf("#");
-                    fflush(stdout);
-                }
+                printf("\n");
+            }
+            /* Update the node logical config now, so that the slots are not
+             * planned twice if the source gives slots to several nodes. */
+            while ((ln = listFirst(table)) != NULL) {
+                clusterManagerReshardTableItem *item = ln->value;
+                item->target = dst;
+                src->slots[item->slot] = 0;
+                dst->slots[item->slot] = 1;
+                listAddNodeTail(moves, item);
+                listDelNode(table, ln);
             }
-            printf("\n");
         end_move:
             clusterManagerReleaseReshardTable(table);
             if (!result) goto cleanup;
@@ -7574,7 +7834,9 @@ static int clusterManagerCommandRebalance(int argc, char **argv) {
         if (dst->balance == 0) dst_idx++;
         if (src->balance == 0) src_idx--;
     }
+    if (!simulate && listLength(moves) > 0) result = clusterManagerMoveSlots(moves, CLUSTER_MANAGER_OPT_QUIET);
 cleanup:
+    clusterManagerReleaseReshardTable(moves);
     if (involved != NULL) listRelease(involved);
     if (weightedNodes != NULL) zfree(weightedNodes);
     return result;
@@ -8598,17 +8860,20 @@ static void pipeMode(void) {
  * Find big keys
  *--------------------------------------------------------------------------- */
 
-static redisReply *sendScan(unsigned long long *it) {
-    redisReply *reply;
-
+static void appendScan(redisContext *ctx, unsigned long long it) {
     if (config.pattern)
-        reply = redisCommand(context, "SCAN %llu MATCH %b COUNT %d", *it, config.pattern, sdslen(config.pattern),
-                             config.count);
+        redisAppendCommand(ctx, "SCAN %llu MATCH %b COUNT %d", it, config.pattern, sdslen(config.pattern),
+                           config.count);
     else
-        reply = redisCommand(context, "SCAN %llu COUNT %d", *it, config.count);
+        redisAppendCommand(ctx, "SCAN %llu COUNT %d", it, config.count);
+}
+
+/* Reads the reply of a SCAN sent with appendScan(), and updates the iterator. */
+static redisReply *getScanReply(redisContext *ctx, unsigned long long *it) {
+    redisReply *reply = NULL;
 
     /* Handle any error conditions */
-    if (reply == NULL) {
+    if (redisGetReply(ctx, (void **)&reply) != REDIS_OK || reply == NULL) {
         fprintf(stderr, "\nI/O error\n");
         exit(1);
     } else if (reply->type == REDIS_REPLY_ERROR) {
@@ -8632,6 +8897,11 @@ static redisReply *sendScan(unsigned long long *it) {
     return reply;
 }
 
+static redisReply *sendScan(unsigned long long *it) {
+    appendScan(context, *it);
+    return getScanReply(context, it);
+}
+
 static int getDbSize(void) {
     redisReply *reply;
     int size;
@@ -8686,6 +8956,7 @@ typedef struct {
     unsigned long long count;
     unsigned long long totalsize;
     sds biggest_key;
+    struct hdr_histogram *sizes; /* Distribution of the sizes of the keys of this type. */
 } typeinfo;
 
 typeinfo type_string = {"string", "STRLEN", "bytes"};
@@ -8696,10 +8967,18 @@ typeinfo type_zset = {"zset", "ZCARD", "members"};
 typeinfo type_stream = {"stream", "XLEN", "entries"};
 typeinfo type_other = {"other", NULL, "?"};
 
+/* Highest value tracked by the percentile reports, larger ones are clamped. */
+#define KEYSPACE_HISTOGRAM_MAX (1LL << 48)
+
+static void keyspaceHistogramRecord(struct hdr_histogram *histogram, unsigned long long value) {
+    hdr_record_value(histogram, value > KEYSPACE_HISTOGRAM_MAX ? KEYSPACE_HISTOGRAM_MAX : (int64_t)value);
+}
+
 static typeinfo *typeinfo_add(dict *types, char *name, typeinfo *type_template) {
     typeinfo *info = zmalloc(sizeof(typeinfo));
     *info = *type_template;
     info->name = sdsnew(name);
+    hdr_init(1, KEYSPACE_HISTOGRAM_MAX, 2, &info->sizes);
     dictAdd(types, info->name, info);
     return info;
 }
@@ -8707,6 +8986,7 @@ static typeinfo *typeinfo_add(dict *types, char *name, typeinfo *type_template)
 void type_free(void *val) {
     typeinfo *info = val;
     if (info->biggest_key) sdsfree(info->biggest_key);
+    hdr_close(info->sizes);
     sdsfree(info->name);
     zfree(info);
 }
@@ -8720,22 +9000,93 @@ static dictType typeinfoDictType = {
     NULL               /* allow to expand */
 };
 
-static void getKeyTypes(dict *types_dict, redisReply *keys, typeinfo **types) {
-    redisReply *reply;
-    unsigned int i;
+#define HOTKEYS_SAMPLE 16
+
+/* State of --bigkeys, --memkeys and --hotkeys, shared by the connections
+ * scanning the keyspace in parallel and protected by 'lock'. */
+static struct {
+    int memkeys;
+    unsigned memkeys_samples;
+    int find_hotkeys;
+    pthread_mutex_t lock;
+    unsigned long long total_keys; /* Number of keys before scanning. */
+    unsigned long long sampled;
+    unsigned long long totlen;
+    double pct; /* Approximate percentage of the keyspace sampled so far. */
+    dict *types;
+    unsigned long long counters[HOTKEYS_SAMPLE];
+    sds hotkeys[HOTKEYS_SAMPLE];
+    struct hdr_histogram *freqs;
+} keyspace;
+
+/* A connection scanning a part of the keyspace.
+ *
+ * In standalone mode the cursor space is split in 'n' parts, with 'n' a power
+ * of two. SCAN increments the reversed bits of the cursor, so its low bits are
+ * the ones changing the least often: the worker 'k' starts from the cursor
+ * with the low bits set to the reversed bits of 'k', and owns all the cursors
+ * with these low bits. This only holds while the hash table has at least 'n'
+ * buckets, so the number of connections is limited by the number of keys.
+ *
+ * In cluster mode the cursor is the hash table cursor followed by the slot in
+ * the low 14 bits, so each worker owns a range of the slots of the node.
+ *
+ * A SCAN call does not stop at the end of the cursors of a worker, and its
+ * last reply may contain keys of the next part, that are dropped. */
+typedef struct keyspaceWorker {
+    pthread_t thread;
+    redisContext *ctx;
+    unsigned long long first_cursor;
+    unsigned long long cursor_mask; /* Standalone: the cursors owned have the low bits of 'first_cursor'. */
+    int end_slot;                   /* Cluster: the slots owned are 'first_cursor' to 'end_slot' excluded. */
+    redisReply *first_reply;        /* Reply of the SCAN from 'first_cursor', read by the previous worker. */
+    unsigned long long it;          /* Cursor returned by the last SCAN. */
+    struct keyspaceWorker *next;    /* Worker owning the following part of the keyspace. */
+} keyspaceWorker;
+
+static int keyspaceWorkerOwnsCursor(keyspaceWorker *w, unsigned long long cursor) {
+    if (cursor == 0) return 0;
+    if (w->end_slot) return (int)(cursor & (CLUSTER_MANAGER_SLOTS - 1)) < w->end_slot;
+    return (cursor & w->cursor_mask) == w->first_cursor;
+}
+
+/* Fills 'owned' with the keys of the last SCAN reply of a worker that don't
+ * belong to the next part of the keyspace, and returns their number. The next
+ * worker scanned the same buckets in the same order starting from its first
+ * cursor, so these keys are all in its first reply. */
+static size_t keyspaceWorkerOwnedKeys(keyspaceWorker *w, redisReply *keys, redisReply **owned) {
+    redisReply *next_keys = w->next->first_reply->element[1];
+    size_t i, j, count = 0;
 
-    /* Pipeline TYPE commands */
     for (i = 0; i < keys->elements; i++) {
+        redisReply *key = keys->element[i];
+        for (j = 0; j < next_keys->elements; j++) {
+            if (key->len == next_keys->element[j]->len && !memcmp(key->str, next_keys->element[j]->str, key->len))
+                break;
+        }
+        if (j == next_keys->elements) owned[count++] = key;
+    }
+    return count;
+}
+
+/* Pipeline TYPE commands */
+static void appendKeyTypes(redisContext *ctx, redisReply *keys) {
+    for (unsigned int i = 0; i < keys->elements; i++) {
         const char *argv[] = {"TYPE", keys->element[i]->str};
         size_t lens[] = {4, keys->element[i]->len};
-        redisAppendCommandArgv(context, 2, argv, lens);
+        redisAppendCommandArgv(ctx, 2, argv, lens);
     }
+}
+
+static void getKeyTypes(redisContext *ctx, redisReply *keys, typeinfo **types) {
+    redisReply *reply;
+    unsigned int i;
 
     /* Retrieve types */
     for (i = 0; i < keys->elements; i++) {
-        if (redisGetReply(context, (void **)&reply) != REDIS_OK) {
-            fprintf(stderr, "Error getting type for key '%s' (%d: %s)\n", keys->element[i]->str, context->err,
-                    context->errstr);
+        if (redisGetReply(ctx, (void **)&reply) != REDIS_OK) {
+            fprintf(stderr, "Error getting type for key '%s' (%d: %s)\n", keys->element[i]->str, ctx->err,
+                    ctx->errstr);
             exit(1);
         } else if (reply->type != REDIS_REPLY_STATUS) {
             if (reply->type == REDIS_REPLY_ERROR) {
@@ -8747,64 +9098,66 @@ static void getKeyTypes(dict *types_dict, redisReply *keys, typeinfo **types) {
         }
 
         sds typereply = sdsnew(reply->str);
-        dictEntry *de = dictFind(types_dict, typereply);
-        sdsfree(typereply);
+        pthread_mutex_lock(&keyspace.lock);
+        dictEntry *de = dictFind(keyspace.types, typereply);
         typeinfo *type = NULL;
         if (de)
             type = dictGetVal(de);
         else if (strcmp(reply->str, "none")) /* create new types for modules, (but not for deleted keys) */
-            type = typeinfo_add(types_dict, reply->str, &type_other);
+            type = typeinfo_add(keyspace.types, reply->str, &type_other);
+        pthread_mutex_unlock(&keyspace.lock);
+        sdsfree(typereply);
         types[i] = type;
         freeReplyObject(reply);
     }
 }
 
-static void
-getKeySizes(redisReply *keys, typeinfo **types, unsigned long long *sizes, int memkeys, unsigned memkeys_samples) {
-    redisReply *reply;
-    unsigned int i;
-
-    /* Pipeline size commands */
-    for (i = 0; i < keys->elements; i++) {
-        /* Skip keys that disappeared between SCAN and TYPE (or unknown types when not in memkeys mode) */
-        if (!types[i] || (!types[i]->sizecmd && !memkeys)) continue;
-
-        if (!memkeys) {
+/* Pipeline size commands. In memkeys mode the types are not needed, so that
+ * MEMORY USAGE can be sent together with TYPE, for every key. */
+static void appendKeySizes(redisContext *ctx, redisReply *keys, typeinfo **types) {
+    for (unsigned int i = 0; i < keys->elements; i++) {
+        if (!keyspace.memkeys) {
+            /* Skip keys that disappeared between SCAN and TYPE, and unknown types */
+            if (!types[i] || !types[i]->sizecmd) continue;
             const char *argv[] = {types[i]->sizecmd, keys->element[i]->str};
             size_t lens[] = {strlen(types[i]->sizecmd), keys->element[i]->len};
-            redisAppendCommandArgv(context, 2, argv, lens);
-        } else if (memkeys_samples == 0) {
+            redisAppendCommandArgv(ctx, 2, argv, lens);
+        } else if (keyspace.memkeys_samples == 0) {
             const char *argv[] = {"MEMORY", "USAGE", keys->element[i]->str};
             size_t lens[] = {6, 5, keys->element[i]->len};
-            redisAppendCommandArgv(context, 3, argv, lens);
+            redisAppendCommandArgv(ctx, 3, argv, lens);
         } else {
-            sds samplesstr = sdsfromlonglong(memkeys_samples);
+            sds samplesstr = sdsfromlonglong(keyspace.memkeys_samples);
             const char *argv[] = {"MEMORY", "USAGE", keys->element[i]->str, "SAMPLES", samplesstr};
             size_t lens[] = {6, 5, keys->element[i]->len, 7, sdslen(samplesstr)};
-            redisAppendCommandArgv(context, 5, argv, lens);
+            redisAppendCommandArgv(ctx, 5, argv, lens);
             sdsfree(samplesstr);
         }
     }
+}
+
+static void getKeySizes(redisContext *ctx, redisReply *keys, typeinfo **types, unsigned long long *sizes) {
+    redisReply *reply;
+    unsigned int i;
 
     /* Retrieve sizes */
     for (i = 0; i < keys->elements; i++) {
+        sizes[i] = 0;
         /* Skip keys that disappeared between SCAN and TYPE (or unknown types when not in memkeys mode) */
-        if (!types[i] || (!types[i]->sizecmd && !memkeys)) {
-            sizes[i] = 0;
-            continue;
-        }
+        if (!keyspace.memkeys && (!types[i] || !types[i]->sizecmd)) continue;
 
         /* Retrieve size */
-        if (redisGetReply(context, (void **)&reply) != REDIS_OK) {
-            fprintf(stderr, "Error getting size for key '%s' (%d: %s)\n", keys->element[i]->str, context->err,
-                    context->errstr);
+        if (redisGetReply(ctx, (void **)&reply) != REDIS_OK) {
+            fprintf(stderr, "Error getting size for key '%s' (%d: %s)\n", keys->element[i]->str, ctx->err,
+                    ctx->errstr);
             exit(1);
+        } else if (!types[i]) {
+            /* MEMORY USAGE of a key that disappeared between SCAN and TYPE */
         } else if (reply->type != REDIS_REPLY_INTEGER) {
             /* Theoretically the key could have been removed and
              * added as a different type between TYPE and SIZE */
             fprintf(stderr, "Warning:  %s on '%s' failed (may have changed type)\n",
-                    !memkeys ? types[i]->sizecmd : "MEMORY USAGE", keys->element[i]->str);
-            sizes[i] = 0;
+                    !keyspace.memkeys ? types[i]->sizecmd : "MEMORY USAGE", keys->element[i]->str);
         } else {
             sizes[i] = reply->integer;
         }
@@ -8813,135 +9166,426 @@ getKeySizes(redisReply *keys, typeinfo **types, unsigned long long *sizes, int m
     }
 }
 
-static void longStatLoopModeStop(int s) {
-    UNUSED(s);
-    force_cancel_loop = 1;
+/* Pipeline OBJECT freq commands */
+static void appendKeyFreqs(redisContext *ctx, redisReply *keys) {
+    for (unsigned int i = 0; i < keys->elements; i++) {
+        const char *argv[] = {"OBJECT", "FREQ", keys->element[i]->str};
+        size_t lens[] = {6, 4, keys->element[i]->len};
+        redisAppendCommandArgv(ctx, 3, argv, lens);
+    }
 }
 
-/* In cluster mode we may need to send the READONLY command.
-   Ignore the error in case the server isn't using cluster mode. */
-static void sendReadOnly(void) {
-    redisReply *read_reply;
-    read_reply = redisCommand(context, "READONLY");
-    if (read_reply == NULL) {
-        fprintf(stderr, "\nI/O error\n");
-        exit(1);
-    } else if (read_reply->type == REDIS_REPLY_ERROR &&
-               strcmp(read_reply->str, "ERR This instance has cluster support disabled") != 0) {
-        fprintf(stderr, "Error: %s\n", read_reply->str);
-        exit(1);
+static void getKeyFreqs(redisContext *ctx, redisReply *keys, unsigned long long *freqs) {
+    redisReply *reply;
+    unsigned int i;
+
+    /* Retrieve freqs */
+    for (i = 0; i < keys->elements; i++) {
+        if (redisGetReply(ctx, (void **)&reply) != REDIS_OK) {
+            sds keyname = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
+            fprintf(stderr, "Error getting freq for key '%s' (%d: %s)\n", keyname, ctx->err, ctx->errstr);
+            sdsfree(keyname);
+            exit(1);
+        } else if (reply->type != REDIS_REPLY_INTEGER) {
+            if (reply->type == REDIS_REPLY_ERROR) {
+                fprintf(stderr, "Error: %s\n", reply->str);
+                exit(1);
+            } else {
+                sds keyname = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
+                fprintf(stderr, "Warning: OBJECT freq on '%s' failed (may have been deleted)\n", keyname);
+                sdsfree(keyname);
+                freqs[i] = 0;
+            }
+        } else {
+            freqs[i] = reply->integer;
+        }
+        freeReplyObject(reply);
     }
-    freeReplyObject(read_reply);
 }
 
-static void findBigKeys(int memkeys, unsigned memkeys_samples) {
-    unsigned long long sampled = 0, total_keys, totlen = 0, *sizes = NULL, it = 0, scan_loops = 0;
-    redisReply *reply, *keys;
-    unsigned int arrsize = 0, i;
-    dictIterator *di;
-    dictEntry *de;
-    typeinfo **types = NULL;
-    double pct;
+/* Accounts the sizes of a batch of keys. */
+static void keyspaceAddSizes(redisReply *keys, typeinfo **types, unsigned long long *sizes) {
+    pthread_mutex_lock(&keyspace.lock);
 
-    dict *types_dict = dictCreate(&typeinfoDictType);
-    typeinfo_add(types_dict, "string", &type_string);
-    typeinfo_add(types_dict, "list", &type_list);
-    typeinfo_add(types_dict, "set", &type_set);
-    typeinfo_add(types_dict, "hash", &type_hash);
-    typeinfo_add(types_dict, "zset", &type_zset);
-    typeinfo_add(types_dict, "stream", &type_stream);
+    /* Calculate approximate percentage completion */
+    double pct = keyspace.pct = 100 * (double)keyspace.sampled / keyspace.total_keys;
 
-    signal(SIGINT, longStatLoopModeStop);
-    /* Total keys pre scanning */
-    total_keys = getDbSize();
+    for (unsigned int i = 0; i < keys->elements; i++) {
+        typeinfo *type = types[i];
+        /* Skip keys that disappeared between SCAN and TYPE */
+        if (!type) continue;
 
-    /* Status message */
-    printf("\n# Scanning the entire keyspace to find biggest keys as well as\n");
-    printf("# average sizes per key type.  You can use -i 0.1 to sleep 0.1 sec\n");
-    printf("# per 100 SCAN commands (not usually needed).\n\n");
+        type->totalsize += sizes[i];
+        type->count++;
+        keyspaceHistogramRecord(type->sizes, sizes[i]);
+        keyspace.totlen += keys->element[i]->len;
+        keyspace.sampled++;
+
+        if (type->biggest < sizes[i]) {
+            /* Keep track of biggest key name for this type */
+            if (type->biggest_key) sdsfree(type->biggest_key);
+            type->biggest_key = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
+            if (!type->biggest_key) {
+                fprintf(stderr, "Failed to allocate memory for key!\n");
+                exit(1);
+            }
 
-    /* Use readonly in cluster */
-    sendReadOnly();
+            printf("[%05.2f%%] Biggest %-6s found so far '%s' with %llu %s\n", pct, type->name, type->biggest_key,
+                   sizes[i], !keyspace.memkeys ? type->sizeunit : "bytes");
 
-    /* SCAN loop */
-    do {
-        /* Calculate approximate percentage completion */
-        pct = 100 * (double)sampled / total_keys;
+            /* Keep track of the biggest size for this type */
+            type->biggest = sizes[i];
+        }
 
-        /* Grab some keys and point to the keys array */
-        reply = sendScan(&it);
-        scan_loops++;
+        /* Update overall progress */
+        if (keyspace.sampled % 1000000 == 0) {
+            printf("[%05.2f%%] Sampled %llu keys so far\n", pct, keyspace.sampled);
+        }
+    }
+
+    pthread_mutex_unlock(&keyspace.lock);
+}
+
+/* Accounts the access frequencies of a batch of keys. */
+static void keyspaceAddFreqs(redisReply *keys, unsigned long long *freqs) {
+    unsigned long long *counters = keyspace.counters;
+    sds *hotkeys = keyspace.hotkeys;
+    unsigned int i, k;
+
+    pthread_mutex_lock(&keyspace.lock);
+
+    /* Calculate approximate percentage completion */
+    double pct = keyspace.pct = 100 * (double)keyspace.sampled / keyspace.total_keys;
+
+    for (i = 0; i < keys->elements; i++) {
+        keyspace.sampled++;
+        keyspaceHistogramRecord(keyspace.freqs, freqs[i]);
+        /* Update overall progress */
+        if (keyspace.sampled % 1000000 == 0) {
+            printf("[%05.2f%%] Sampled %llu keys so far\n", pct, keyspace.sampled);
+        }
+
+        /* Use eviction pool here */
+        k = 0;
+        while (k < HOTKEYS_SAMPLE && freqs[i] > counters[k]) k++;
+        if (k == 0) continue;
+        k--;
+        if (k == 0 || counters[k] == 0) {
+            sdsfree(hotkeys[k]);
+        } else {
+            sdsfree(hotkeys[0]);
+            memmove(counters, counters + 1, sizeof(counters[0]) * k);
+            memmove(hotkeys, hotkeys + 1, sizeof(hotkeys[0]) * k);
+        }
+        counters[k] = freqs[i];
+        hotkeys[k] = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
+        printf("[%05.2f%%] Hot key '%s' found so far with counter %llu\n", pct, hotkeys[k], freqs[i]);
+    }
+
+    pthread_mutex_unlock(&keyspace.lock);
+}
+
+/* Scans the part of the keyspace of a worker. The commands inspecting the
+ * keys of a SCAN reply are pipelined, and the next SCAN is sent together
+ * with the last of them, so that a batch of keys costs a single round trip,
+ * or two in --bigkeys mode where the size commands depend on the types. */
+static void *keyspaceWorkerMain(void *arg) {
+    keyspaceWorker *w = arg;
+    redisContext *ctx = w->ctx;
+    redisReply *reply = w->first_reply, *keys, owned;
+    unsigned long long *sizes = NULL, scan_loops = 1;
+    typeinfo **types = NULL;
+    unsigned int arrsize = 0;
+    int last;
+
+    do {
         keys = reply->element[1];
+        last = force_cancel_loop || !keyspaceWorkerOwnsCursor(w, w->it);
+        if (last && w->it != 0 && w->next) {
+            /* The replies are shared with the other workers, don't modify them. */
+            owned = *keys;
+            owned.element = zmalloc(sizeof(redisReply *) * keys->elements);
+            owned.elements = keyspaceWorkerOwnedKeys(w, keys, owned.element);
+            keys = &owned;
+        }
 
         /* Reallocate our type and size array if we need to */
         if (keys->elements > arrsize) {
             types = zrealloc(types, sizeof(typeinfo *) * keys->elements);
             sizes = zrealloc(sizes, sizeof(unsigned long long) * keys->elements);
+            arrsize = keys->elements;
+        }
 
-            if (!types || !sizes) {
-                fprintf(stderr, "Failed to allocate storage for keys!\n");
-                exit(1);
+        if (keyspace.find_hotkeys) {
+            appendKeyFreqs(ctx, keys);
+            if (!last) appendScan(ctx, w->it);
+            getKeyFreqs(ctx, keys, sizes);
+            keyspaceAddFreqs(keys, sizes);
+        } else {
+            /* Retrieve types and then sizes */
+            appendKeyTypes(ctx, keys);
+            if (keyspace.memkeys) {
+                appendKeySizes(ctx, keys, NULL);
+                if (!last) appendScan(ctx, w->it);
             }
+            getKeyTypes(ctx, keys, types);
+            if (!keyspace.memkeys) {
+                appendKeySizes(ctx, keys, types);
+                if (!last) appendScan(ctx, w->it);
+            }
+            getKeySizes(ctx, keys, types, sizes);
+            keyspaceAddSizes(keys, types, sizes);
+        }
+        if (keys == &owned) zfree(owned.element);
+        /* The first reply is freed once all the workers are done. */
+        if (reply != w->first_reply) freeReplyObject(reply);
 
-            arrsize = keys->elements;
+        if (!last) {
+            reply = getScanReply(ctx, &w->it);
+            scan_loops++;
+
+            /* Sleep if we've been directed to do so */
+            if (config.interval && (scan_loops % 100) == 0) {
+                usleep(config.interval);
+            }
         }
+    } while (!last);
 
-        /* Retrieve types and then sizes */
-        getKeyTypes(types_dict, keys, types);
-        getKeySizes(keys, types, sizes, memkeys, memkeys_samples);
+    zfree(types);
+    zfree(sizes);
+    return NULL;
+}
 
-        /* Now update our stats */
-        for (i = 0; i < keys->elements; i++) {
-            typeinfo *type = types[i];
-            /* Skip keys that disappeared between SCAN and TYPE */
-            if (!type) continue;
+static void longStatLoopModeStop(int s) {
+    UNUSED(s);
+    force_cancel_loop = 1;
+}
 
-            type->totalsize += sizes[i];
-            type->count++;
-            totlen += keys->element[i]->len;
-            sampled++;
+/* In cluster mode we may need to send the READONLY command.
+   Ignore the error in case the server isn't using cluster mode. */
+static void sendReadOnly(redisContext *ctx) {
+    redisReply *read_reply;
+    read_reply = redisCommand(ctx, "READONLY");
+    if (read_reply == NULL) {
+        fprintf(stderr, "\nI/O error\n");
+        exit(1);
+    } else if (read_reply->type == REDIS_REPLY_ERROR &&
+               strcmp(read_reply->str, "ERR This instance has cluster support disabled") != 0) {
+        fprintf(stderr, "Error: %s\n", read_reply->str);
+        exit(1);
+    }
+    freeReplyObject(read_reply);
+}
 
-            if (type->biggest < sizes[i]) {
-                /* Keep track of biggest key name for this type */
-                if (type->biggest_key) sdsfree(type->biggest_key);
-                type->biggest_key = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
-                if (!type->biggest_key) {
-                    fprintf(stderr, "Failed to allocate memory for key!\n");
-                    exit(1);
-                }
+/* Fills 'slots' with the slots served by the node, or by its primary when it
+ * is a replica. Returns the number of slots, -1 if the node is not in cluster
+ * mode, or 0 if its SCAN cursors don't contain the slot. */
+static int getClusterNodeSlots(unsigned char *slots) {
+    redisReply *reply = redisCommand(context, "INFO");
+    if (reply == NULL) {
+        fprintf(stderr, "\nI/O error\n");
+        exit(1);
+    }
+    /* Before Valkey 8 the keys of all the slots were in the same hash table. */
+    int cluster_enabled = reply->type != REDIS_REPLY_ERROR && strstr(reply->str, "cluster_enabled:1") != NULL;
+    char *version = cluster_enabled ? strstr(reply->str, "valkey_version:") : NULL;
+    int per_slot_cursor = version && atoi(version + strlen("valkey_version:")) >= 8;
+    freeReplyObject(reply);
+    if (!cluster_enabled) return -1;
+    if (!per_slot_cursor) return 0;
 
-                printf("[%05.2f%%] Biggest %-6s found so far '%s' with %llu %s\n", pct, type->name, type->biggest_key,
-                       sizes[i], !memkeys ? type->sizeunit : "bytes");
+    reply = redisCommand(context, "CLUSTER NODES");
+    if (reply == NULL) {
+        fprintf(stderr, "\nI/O error\n");
+        exit(1);
+    } else if (reply->type != REDIS_REPLY_STRING && reply->type != REDIS_REPLY_VERB) {
+        freeReplyObject(reply);
+        return 0;
+    }
 
-                /* Keep track of the biggest size for this type */
-                type->biggest = sizes[i];
+    int count, numlines, numslots = 0;
+    sds *lines = sdssplitlen(reply->str, reply->len, "\n", 1, &numlines);
+    sds primary = NULL;
+    for (int pass = 0; pass < 2 && !numslots; pass++) {
+        for (int i = 0; i < numlines; i++) {
+            sds *fields = sdssplitlen(lines[i], sdslen(lines[i]), " ", 1, &count);
+            int match = count >= 8 && (pass == 0 ? strstr(fields[2], "myself") != NULL
+                                                 : primary != NULL && !strcmp(fields[0], primary));
+            if (match && pass == 0 && strcmp(fields[3], "-")) primary = sdsdup(fields[3]);
+            for (int j = 8; match && j < count; j++) {
+                /* Skip the importing and migrating slots. */
+                if (fields[j][0] == '[') continue;
+                char *dash = strchr(fields[j], '-');
+                int start = atoi(fields[j]), stop = dash ? atoi(dash + 1) : start;
+                for (int slot = start; slot <= stop && slot < CLUSTER_MANAGER_SLOTS; slot++) {
+                    slots[slot] = 1;
+                    numslots++;
+                }
             }
+            sdsfreesplitres(fields, count);
+        }
+    }
+    sdsfree(primary);
+    sdsfreesplitres(lines, numlines);
+    freeReplyObject(reply);
+    return numslots;
+}
+
+/* Opens another connection to the server, set up like the main one. */
+static redisContext *keyspaceWorkerConnect(void) {
+    redisContext *ctx;
+    if (config.hostsocket == NULL)
+        ctx = redisConnectWrapper(config.conn_info.hostip, config.conn_info.hostport, config.connect_timeout);
+    else
+        ctx = redisConnectUnixWrapper(config.hostsocket, config.connect_timeout);
 
-            /* Update overall progress */
-            if (sampled % 1000000 == 0) {
-                printf("[%05.2f%%] Sampled %llu keys so far\n", pct, sampled);
+    if (!ctx->err && config.tls) {
+        const char *err = NULL;
+        if (cliSecureConnection(ctx, config.sslconfig, &err) == REDIS_ERR && err) {
+            fprintf(stderr, "Could not negotiate a TLS connection: %s\n", err);
+            exit(1);
+        }
+    }
+    if (ctx->err) {
+        fprintf(stderr, "Could not connect to Valkey: %s\n", ctx->errstr);
+        exit(1);
+    }
+    anetKeepAlive(NULL, ctx->fd, CLI_KEEPALIVE_INTERVAL);
+    if (cliAuth(ctx, config.conn_info.user, config.conn_info.auth) != REDIS_OK) exit(1);
+    if (config.dbnum) {
+        redisReply *reply = redisCommand(ctx, "SELECT %d", config.dbnum);
+        if (reply == NULL || reply->type == REDIS_REPLY_ERROR) {
+            fprintf(stderr, "SELECT %d failed\n", config.dbnum);
+            exit(1);
+        }
+        freeReplyObject(reply);
+    }
+    return ctx;
+}
+
+/* Splits the keyspace among up to 'config.connections' workers. Each part
+ * should have many keys, so that they are not scanned twice when a SCAN call
+ * gets past the end of a part, hence the limit on the number of workers. */
+static keyspaceWorker *createKeyspaceWorkers(int *numworkers) {
+    unsigned long long max_workers = keyspace.total_keys / 1000;
+    unsigned char *slots = zcalloc(CLUSTER_MANAGER_SLOTS);
+    int n = config.connections, numslots = -1, i, j;
+
+    if (n > 1) numslots = getClusterNodeSlots(slots);
+    if ((unsigned long long)n > max_workers) n = max_workers;
+    if (numslots >= 0 && n > numslots) n = numslots;
+    if (n < 1) n = 1;
+    /* In standalone mode the cursor space is split in a power of two parts. */
+    if (numslots < 0) n = 1 << (31 - __builtin_clz(n));
+
+    keyspaceWorker *workers = zcalloc(sizeof(keyspaceWorker) * n);
+    for (i = 0; i < n; i++) {
+        keyspaceWorker *w = &workers[i];
+        w->ctx = i == 0 ? context : keyspaceWorkerConnect();
+        w->next = i + 1 < n ? &workers[i + 1] : NULL;
+        if (numslots < 0) {
+            /* The reversed bits of 'i', as the low bits of the cursor. */
+            for (j = 0; (1 << j) < n; j++) {
+                if (i & (1 << j)) w->first_cursor |= (n >> 1) >> j;
+            }
+            w->cursor_mask = n - 1;
+        } else {
+            /* The slots from the (i * numslots / n)th served by the node. */
+            int first = (long long)i * numslots / n, end = (long long)(i + 1) * numslots / n, nth = 0;
+            w->end_slot = CLUSTER_MANAGER_SLOTS;
+            for (j = 0; j < CLUSTER_MANAGER_SLOTS; j++) {
+                if (!slots[j]) continue;
+                if (nth == first) w->first_cursor = j;
+                if (nth == end) {
+                    w->end_slot = j;
+                    break;
+                }
+                nth++;
             }
         }
+        /* Use readonly in cluster */
+        sendReadOnly(w->ctx);
+    }
+    zfree(slots);
 
-        /* Sleep if we've been directed to do so */
-        if (config.interval && (scan_loops % 100) == 0) {
-            usleep(config.interval);
+    /* Start all the workers from their first cursor: their first replies are
+     * needed to remove the overlaps between the parts. */
+    for (i = 0; i < n; i++) appendScan(workers[i].ctx, workers[i].first_cursor);
+    for (i = 0; i < n; i++) {
+        workers[i].it = workers[i].first_cursor;
+        workers[i].first_reply = getScanReply(workers[i].ctx, &workers[i].it);
+    }
+
+    *numworkers = n;
+    return workers;
+}
+
+/* Scans the keyspace with the main thread and the threads of the other
+ * workers. */
+static void scanKeyspace(void) {
+    int numworkers, i;
+
+    pthread_mutex_init(&keyspace.lock, NULL);
+    signal(SIGINT, longStatLoopModeStop);
+    /* Total keys pre scanning */
+    keyspace.total_keys = getDbSize();
+
+    keyspaceWorker *workers = createKeyspaceWorkers(&numworkers);
+    if (numworkers > 1) printf("# Using %d connections.\n\n", numworkers);
+    for (i = 1; i < numworkers; i++) {
+        if (pthread_create(&workers[i].thread, NULL, keyspaceWorkerMain, &workers[i])) {
+            fprintf(stderr, "Failed to create a thread to scan the keyspace!\n");
+            exit(1);
         }
+    }
+    keyspaceWorkerMain(&workers[0]);
+    for (i = 0; i < numworkers; i++) {
+        if (i > 0) {
+            pthread_join(workers[i].thread, NULL);
+            redisFree(workers[i].ctx);
+        }
+        freeReplyObject(workers[i].first_reply);
+    }
+    zfree(workers);
+}
 
-        freeReplyObject(reply);
-    } while (force_cancel_loop == 0 && it != 0);
+/* Prints the percentiles of a distribution of sizes or frequencies. */
+static void printKeyspacePercentiles(struct hdr_histogram *histogram) {
+    printf("p50=%lld p90=%lld p99=%lld p99.9=%lld max=%lld\n", (long long)hdr_value_at_percentile(histogram, 50.0),
+           (long long)hdr_value_at_percentile(histogram, 90.0), (long long)hdr_value_at_percentile(histogram, 99.0),
+           (long long)hdr_value_at_percentile(histogram, 99.9), (long long)hdr_max(histogram));
+}
+
+static void findBigKeys(int memkeys, unsigned memkeys_samples) {
+    dictIterator *di;
+    dictEntry *de;
+
+    keyspace.memkeys = memkeys;
+    keyspace.memkeys_samples = memkeys_samples;
+    keyspace.types = dictCreate(&typeinfoDictType);
+    typeinfo_add(keyspace.types, "string", &type_string);
+    typeinfo_add(keyspace.types, "list", &type_list);
+    typeinfo_add(keyspace.types, "set", &type_set);
+    typeinfo_add(keyspace.types, "hash", &type_hash);
+    typeinfo_add(keyspace.types, "zset", &type_zset);
+    typeinfo_add(keyspace.types, "stream", &type_stream);
 
-    if (types) zfree(types);
-    if (sizes) zfree(sizes);
+    /* Status message */
+    printf("\n# Scanning the entire keyspace to find biggest keys as well as\n");
+    printf("# average sizes per key type.  You can use -i 0.1 to sleep 0.1 sec\n");
+    printf("# per 100 SCAN commands (not usually needed).\n\n");
+
+    scanKeyspace();
+    unsigned long long sampled = keyspace.sampled, totlen = keyspace.totlen;
 
     /* We're done */
     printf("\n-------- summary -------\n\n");
-    if (force_cancel_loop) printf("[%05.2f%%] ", pct);
+    if (force_cancel_loop) printf("[%05.2f%%] ", keyspace.pct);
     printf("Sampled %llu keys in the keyspace!\n", sampled);
     printf("Total key length in bytes is %llu (avg len %.2f)\n\n", totlen, totlen ? (double)totlen / sampled : 0);
 
     /* Output the biggest keys we found, for types we did find */
-    di = dictGetIterator(types_dict);
+    di = dictGetIterator(keyspace.types);
     while ((de = dictNext(di))) {
         typeinfo *type = dictGetVal(de);
         if (type->biggest_key) {
@@ -8953,7 +9597,7 @@ static void findBigKeys(int memkeys, unsigned memkeys_samples) {
 
     printf("\n");
 
-    di = dictGetIterator(types_dict);
+    di = dictGetIterator(keyspace.types);
     while ((de = dictNext(di))) {
         typeinfo *type = dictGetVal(de);
         printf("%llu %ss with %llu %s (%05.2f%% of keys, avg size %.2f)\n", type->count, type->name, type->totalsize,
@@ -8962,140 +9606,56 @@ static void findBigKeys(int memkeys, unsigned memkeys_samples) {
     }
     dictReleaseIterator(di);
 
-    dictRelease(types_dict);
-
-    /* Success! */
-    exit(0);
-}
-
-static void getKeyFreqs(redisReply *keys, unsigned long long *freqs) {
-    redisReply *reply;
-    unsigned int i;
+    printf("\n");
 
-    /* Pipeline OBJECT freq commands */
-    for (i = 0; i < keys->elements; i++) {
-        const char *argv[] = {"OBJECT", "FREQ", keys->element[i]->str};
-        size_t lens[] = {6, 4, keys->element[i]->len};
-        redisAppendCommandArgv(context, 3, argv, lens);
+    /* Output the distribution of the sizes, for types we did find */
+    di = dictGetIterator(keyspace.types);
+    while ((de = dictNext(di))) {
+        typeinfo *type = dictGetVal(de);
+        if (!type->count) continue;
+        printf("%6s %s percentiles: ", type->name, !memkeys ? type->sizeunit : "bytes");
+        printKeyspacePercentiles(type->sizes);
     }
+    dictReleaseIterator(di);
 
-    /* Retrieve freqs */
-    for (i = 0; i < keys->elements; i++) {
-        if (redisGetReply(context, (void **)&reply) != REDIS_OK) {
-            sds keyname = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
-            fprintf(stderr, "Error getting freq for key '%s' (%d: %s)\n", keyname, context->err, context->errstr);
-            sdsfree(keyname);
-            exit(1);
-        } else if (reply->type != REDIS_REPLY_INTEGER) {
-            if (reply->type == REDIS_REPLY_ERROR) {
-                fprintf(stderr, "Error: %s\n", reply->str);
-                exit(1);
-            } else {
-                sds keyname = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
-                fprintf(stderr, "Warning: OBJECT freq on '%s' failed (may have been deleted)\n", keyname);
-                sdsfree(keyname);
-                freqs[i] = 0;
-            }
-        } else {
-            freqs[i] = reply->integer;
-        }
-        freeReplyObject(reply);
-    }
+    dictRelease(keyspace.types);
+
+    /* Success! */
+    exit(0);
 }
 
-#define HOTKEYS_SAMPLE 16
 static void findHotKeys(void) {
-    redisReply *keys, *reply;
-    unsigned long long counters[HOTKEYS_SAMPLE] = {0};
-    sds hotkeys[HOTKEYS_SAMPLE] = {NULL};
-    unsigned long long sampled = 0, total_keys, *freqs = NULL, it = 0, scan_loops = 0;
-    unsigned int arrsize = 0, i, k;
-    double pct;
+    unsigned int i, k;
 
-    signal(SIGINT, longStatLoopModeStop);
-    /* Total keys pre scanning */
-    total_keys = getDbSize();
+    hdr_init(1, KEYSPACE_HISTOGRAM_MAX, 2, &keyspace.freqs);
+    keyspace.find_hotkeys = 1;
 
     /* Status message */
     printf("\n# Scanning the entire keyspace to find hot keys as well as\n");
     printf("# average sizes per key type.  You can use -i 0.1 to sleep 0.1 sec\n");
     printf("# per 100 SCAN commands (not usually needed).\n\n");
 
-    /* Use readonly in cluster */
-    sendReadOnly();
-
-    /* SCAN loop */
-    do {
-        /* Calculate approximate percentage completion */
-        pct = 100 * (double)sampled / total_keys;
-
-        /* Grab some keys and point to the keys array */
-        reply = sendScan(&it);
-        scan_loops++;
-        keys = reply->element[1];
-
-        /* Reallocate our freqs array if we need to */
-        if (keys->elements > arrsize) {
-            freqs = zrealloc(freqs, sizeof(unsigned long long) * keys->elements);
-
-            if (!freqs) {
-                fprintf(stderr, "Failed to allocate storage for keys!\n");
-                exit(1);
-            }
-
-            arrsize = keys->elements;
-        }
-
-        getKeyFreqs(keys, freqs);
-
-        /* Now update our stats */
-        for (i = 0; i < keys->elements; i++) {
-            sampled++;
-            /* Update overall progress */
-            if (sampled % 1000000 == 0) {
-                printf("[%05.2f%%] Sampled %llu keys so far\n", pct, sampled);
-            }
-
-            /* Use eviction pool here */
-            k = 0;
-            while (k < HOTKEYS_SAMPLE && freqs[i] > counters[k]) k++;
-            if (k == 0) continue;
-            k--;
-            if (k == 0 || counters[k] == 0) {
-                sdsfree(hotkeys[k]);
-            } else {
-                sdsfree(hotkeys[0]);
-                memmove(counters, counters + 1, sizeof(counters[0]) * k);
-                memmove(hotkeys, hotkeys + 1, sizeof(hotkeys[0]) * k);
-            }
-            counters[k] = freqs[i];
-            hotkeys[k] = sdscatrepr(sdsempty(), keys->element[i]->str, keys->element[i]->len);
-            printf("[%05.2f%%] Hot key '%s' found so far with counter %llu\n", pct, hotkeys[k], freqs[i]);
-        }
-
-        /* Sleep if we've been directed to do so */
-        if (config.interval && (scan_loops % 100) == 0) {
-            usleep(config.interval);
-        }
-
-        freeReplyObject(reply);
-    } while (force_cancel_loop == 0 && it != 0);
-
-    if (freqs) zfree(freqs);
+    scanKeyspace();
 
     /* We're done */
     printf("\n-------- summary -------\n\n");
-    if (force_cancel_loop) printf("[%05.2f%%] ", pct);
-    printf("Sampled %llu keys in the keyspace!\n", sampled);
+    if (force_cancel_loop) printf("[%05.2f%%] ", keyspace.pct);
+    printf("Sampled %llu keys in the keyspace!\n", keyspace.sampled);
 
     for (i = 1; i <= HOTKEYS_SAMPLE; i++) {
         k = HOTKEYS_SAMPLE - i;
-        if (counters[k] > 0) {
-            printf("hot key found with counter: %llu\tkeyname: %s\n", counters[k], hotkeys[k]);
-            sdsfree(hotkeys[k]);
+        if (keyspace.counters[k] > 0) {
+            printf("hot key found with counter: %llu\tkeyname: %s\n", keyspace.counters[k], keyspace.hotkeys[k]);
+            sdsfree(keyspace.hotkeys[k]);
         }
     }
 
+    if (keyspace.sampled) {
+        printf("\ncounter percentiles: ");
+        printKeyspacePercentiles(keyspace.freqs);
+    }
+    hdr_close(keyspace.freqs);
+
     exit(0);
 }
 
@@ -9559,6 +10119,7 @@ int main(int argc, char **argv) {
     config.bigkeys = 0;
     config.memkeys = 0;
     config.hotkeys = 0;
+    config.connections = 1;
     config.stdin_lastarg = 0;
     config.stdin_tag_arg = 0;
     config.stdin_tag_name = NULL;
@@ -9595,6 +10156,7 @@ int main(int argc, char **argv) {
     config.cluster_manager_command.slots = 0;
     config.cluster_manager_command.timeout = CLUSTER_MANAGER_MIGRATE_TIMEOUT;
     config.cluster_manager_command.pipeline = CLUSTER_MANAGER_MIGRATE_PIPELINE;
+    config.cluster_manager_command.parallel = 1;
     config.cluster_manager_command.threshold = CLUSTER_MANAGER_REBALANCE_THRESHOLD;
     config.cluster_manager_command.backup_dir = NULL;
     pref.hints = 1;
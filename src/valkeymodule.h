@@ -1191,6 +1191,11 @@ VALKEYMODULE_API int (*ValkeyModule_KeyExists)(ValkeyModuleCtx *ctx, ValkeyModul
 VALKEYMODULE_API ValkeyModuleKey *(*ValkeyModule_OpenKey)(ValkeyModuleCtx *ctx,
                                                           ValkeyModuleString *keyname,
                                                           int mode)VALKEYMODULE_ATTR;
+VALKEYMODULE_API int (*ValkeyModule_OpenKeys)(ValkeyModuleCtx *ctx,
+                                            ValkeyModuleString **keynames,
+                                            int numkeys,
+                                            int mode,
+                                            ValkeyModuleKey **keys) VALKEYMODULE_ATTR;
 VALKEYMODULE_API int (*ValkeyModule_GetOpenKeyModesAll)(void) VALKEYMODULE_ATTR;
 VALKEYMODULE_API void (*ValkeyModule_CloseKey)(ValkeyModuleKey *kp) VALKEYMODULE_ATTR;
 VALKEYMODULE_API int (*ValkeyModule_KeyType)(ValkeyModuleKey *kp) VALKEYMODULE_ATTR;
@@ -1933,6 +1938,7 @@ static int ValkeyModule_Init(ValkeyModuleCtx *ctx, const char *name, int ver, in
     VALKEYMODULE_GET_API(SelectDb);
     VALKEYMODULE_GET_API(KeyExists);
     VALKEYMODULE_GET_API(OpenKey);
+    VALKEYMODULE_GET_API(OpenKeys);
     VALKEYMODULE_GET_API(GetOpenKeyModesAll);
     VALKEYMODULE_GET_API(CloseKey);
     VALKEYMODULE_GET_API(KeyType);
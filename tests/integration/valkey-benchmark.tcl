@@ -118,6 +118,93 @@ tags {"benchmark network external:skip logreqres:skip"} {
             assert_match  {50} [scan [regexp -inline {keys\=([\d]*)} [r info keyspace]] keys=%d]
         }
         
+        test {benchmark: open-loop fixed rate} {
+            set cmd [valkeybenchmark $master_host $master_port "-c 5 -n 200 -t set --rps 400"]
+            set start [clock milliseconds]
+            common_bench_setup $cmd
+            set elapsed [expr {[clock milliseconds] - $start}]
+            assert_match  {*calls=200,*} [cmdstat set]
+            # 200 requests at 400 requests per second take about half a second,
+            # even when the server replies immediately.
+            assert_morethan_equal $elapsed 400
+        }
+
+        test {benchmark: open-loop stepped rate} {
+            set cmd [valkeybenchmark $master_host $master_port "-c 5 -n 300 -t get --rps 200 --rps-max 1000 --rps-ramp 1 --rps-steps 2"]
+            set start [clock milliseconds]
+            common_bench_setup $cmd
+            set elapsed [expr {[clock milliseconds] - $start}]
+            assert_match  {*calls=300,*} [cmdstat get]
+            # About 100 requests are sent in the first half second at 200
+            # requests per second, and the other 200 at 600 requests per second,
+            # so the last one is sent about 0.83 seconds in.
+            assert_morethan_equal $elapsed 800
+        }
+
+        test {benchmark: workload file} {
+            set workload [tmpfile workload]
+            set fd [open $workload w]
+            puts $fd "# comments and empty lines are ignored"
+            puts $fd ""
+            puts $fd "keyspace 20"
+            puts $fd "key-prefix wl:"
+            puts $fd "key-distribution zipf 0.9"
+            puts $fd "value-size 10-20:3,100:1"
+            puts $fd "pipeline 3"
+            puts $fd "op 3 SET __key__ __value__"
+            puts $fd "op 1 keys 2-4 MGET __keys__"
+            puts $fd "op 1 keys 2 MSET __pairs__"
+            close $fd
+
+            set cmd [valkeybenchmark $master_host $master_port "-c 5 -n 300 --workload $workload"]
+            common_bench_setup $cmd
+            set calls 0
+            foreach command {set mget mset} {
+                regexp {calls=(\d+),} [cmdstat $command] -> n
+                assert_morethan $n 0
+                incr calls $n
+            }
+            assert_equal 300 $calls
+            # assert one of the non benchmarked commands is not present
+            assert_match  {} [cmdstat get]
+
+            # keys come from the keyspace of the workload
+            assert_range [r dbsize] 1 20
+            foreach key [r keys *] {
+                assert_match {wl:*} $key
+                assert_range [r strlen $key] 10 100
+            }
+        }
+
+        test {benchmark: workload file errors are reported} {
+            set workload [tmpfile workload]
+            set fd [open $workload w]
+            puts $fd "op 1 GET __key__"
+            puts $fd "key-distribution zipf 2"
+            close $fd
+            set cmd [valkeybenchmark $master_host $master_port "-n 10 --workload $workload"]
+            catch { exec {*}$cmd } error
+            assert_match "*line 2: zipf skew must be between 0 and 1*" $error
+        }
+
+        test {benchmark: json output} {
+            r config resetstat
+            set cmd [valkeybenchmark $master_host $master_port "-c 5 -n 1000 -t set,get --json"]
+            set lines [split [string trim [exec {*}$cmd]] "\n"]
+            assert_equal 2 [llength $lines]
+            set set_line [lindex $lines 0]
+            assert_match {\{"test":"SET","requests":1000,*\}} $set_line
+            assert_match {*"latency_ms":\{"avg":*,"p99.9":*} $set_line
+            assert_match {*"histogram_usec":\[\[*\]\]*} $set_line
+            assert_match {*"per_second":\[\{"elapsed_ms":*} $set_line
+            assert_match {*"servers":\[\{"address":*"cpu_sec":\{"used_cpu_sys":*} $set_line
+            assert_match {*"commandstats":\{*"set":\{"calls":1000,*} $set_line
+            assert_match {*"latencystats":\{*"set":\{"p50":*} $set_line
+            # Only the commands called during the test are reported.
+            assert_no_match {*"get":*} $set_line
+            assert_match {*"commandstats":\{*"get":\{"calls":1000,*} [lindex $lines 1]
+        }
+
         test {benchmark: clients idle mode should return error when reached maxclients limit} {
             set cmd [valkeybenchmark $master_host $master_port "-c 10 -I"]
             set original_maxclients [lindex [r config get maxclients] 1]
@@ -505,6 +505,25 @@ if {!$::tls} { ;# fake_redis_node doesn't support TLS
         assert_equal {key:2} [split [run_cli --scan --quoted-pattern {"*:\x32"}]]
     }
 
+    test "Big keys mode with multiple connections" {
+        r flushdb
+        populate 5000 key: 1
+        r rpush biglist a b c
+
+        # Every key is sampled exactly once whatever the number of connections.
+        foreach connections {1 4} {
+            set output [run_cli --bigkeys --connections $connections]
+            assert_match "*Sampled 5001 keys in the keyspace!*" $output
+            assert_match "*Biggest   list found '\"biglist\"' has 3 items*" $output
+            assert_match "*5000 strings with 5000 bytes*" $output
+            assert_match "*string bytes percentiles: p50=1 *" $output
+        }
+        assert_match "*Using 4 connections*" $output
+
+        set output [run_cli --memkeys --connections 4]
+        assert_match "*Sampled 5001 keys in the keyspace!*" $output
+    }
+
     proc test_valkey_cli_repl {} {
         set fd [open_cli "--replica"]
         wait_for_condition 500 100 {
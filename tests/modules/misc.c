@@ -540,6 +540,29 @@ int test_keyslot(ValkeyModuleCtx *ctx, ValkeyModuleString **argv, int argc) {
     return ValkeyModule_ReplyWithLongLong(ctx, slot);
 }
 
+/* Open all the keys with a single OpenKeys call and reply with the length of
+ * each of them, or null for the keys that don't exist. */
+int test_open_keys(ValkeyModuleCtx *ctx, ValkeyModuleString **argv, int argc) {
+    if (argc < 2) {
+        return ValkeyModule_WrongArity(ctx);
+    }
+    int numkeys = argc - 1;
+    ValkeyModuleKey **keys = ValkeyModule_Alloc(sizeof(ValkeyModuleKey *) * numkeys);
+    int opened = ValkeyModule_OpenKeys(ctx, argv + 1, numkeys, VALKEYMODULE_READ, keys);
+    ValkeyModule_ReplyWithArray(ctx, numkeys + 1);
+    ValkeyModule_ReplyWithLongLong(ctx, opened);
+    for (int j = 0; j < numkeys; j++) {
+        if (keys[j]) {
+            ValkeyModule_ReplyWithLongLong(ctx, ValkeyModule_ValueLength(keys[j]));
+            ValkeyModule_CloseKey(keys[j]);
+        } else {
+            ValkeyModule_ReplyWithNull(ctx);
+        }
+    }
+    ValkeyModule_Free(keys);
+    return VALKEYMODULE_OK;
+}
+
 int ValkeyModule_OnLoad(ValkeyModuleCtx *ctx, ValkeyModuleString **argv, int argc) {
     VALKEYMODULE_NOT_USED(argv);
     VALKEYMODULE_NOT_USED(argc);
@@ -607,6 +630,8 @@ int ValkeyModule_OnLoad(ValkeyModuleCtx *ctx, ValkeyModuleString **argv, int arg
         return VALKEYMODULE_ERR;
     if (ValkeyModule_CreateCommand(ctx, "test.keyslot", test_keyslot, "", 0, 0, 0) == VALKEYMODULE_ERR)
         return VALKEYMODULE_ERR;
+    if (ValkeyModule_CreateCommand(ctx, "test.open_keys", test_open_keys, "readonly", 1, -1, 1) == VALKEYMODULE_ERR)
+        return VALKEYMODULE_ERR;
 
     return VALKEYMODULE_OK;
 }
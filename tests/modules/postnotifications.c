@@ -63,6 +63,11 @@ static void KeySpace_PostNotificationReadKey(ValkeyModuleCtx *ctx, void *pd) {
     ValkeyModule_FreeCallReply(rep);
 }
 
+static void KeySpace_PostNotificationOpenKey(ValkeyModuleCtx *ctx, void *pd) {
+    ValkeyModuleKey *key = ValkeyModule_OpenKey(ctx, pd, VALKEYMODULE_READ);
+    ValkeyModule_CloseKey(key);
+}
+
 static void KeySpace_PostNotificationString(ValkeyModuleCtx *ctx, void *pd) {
     VALKEYMODULE_NOT_USED(ctx);
     ValkeyModuleCallReply* rep = ValkeyModule_Call(ctx, "incr", "!s", pd);
@@ -145,6 +150,23 @@ static int KeySpace_LazyExpireInsidePostNotificationJob(ValkeyModuleCtx *ctx, in
     return VALKEYMODULE_OK;
 }
 
+static int KeySpace_OpenKeyInsidePostNotificationJob(ValkeyModuleCtx *ctx, int type, const char *event, ValkeyModuleString *key){
+    VALKEYMODULE_NOT_USED(ctx);
+    VALKEYMODULE_NOT_USED(type);
+    VALKEYMODULE_NOT_USED(event);
+
+    const char *key_str = ValkeyModule_StringPtrLen(key, NULL);
+
+    if (strncmp(key_str, "open_", 5) != 0) {
+        return VALKEYMODULE_OK;
+    }
+
+    ValkeyModuleString *new_key = ValkeyModule_CreateString(NULL, key_str + 5, strlen(key_str) - 5);
+    int res = ValkeyModule_AddPostNotificationJob(ctx, KeySpace_PostNotificationOpenKey, new_key, KeySpace_PostNotificationStringFreePD);
+    if (res == VALKEYMODULE_ERR) KeySpace_PostNotificationStringFreePD(new_key);
+    return VALKEYMODULE_OK;
+}
+
 static int KeySpace_NestedNotification(ValkeyModuleCtx *ctx, int type, const char *event, ValkeyModuleString *key){
     VALKEYMODULE_NOT_USED(ctx);
     VALKEYMODULE_NOT_USED(type);
@@ -280,6 +302,10 @@ int ValkeyModule_OnLoad(ValkeyModuleCtx *ctx, ValkeyModuleString **argv, int arg
         return VALKEYMODULE_ERR;
     }
 
+    if(ValkeyModule_SubscribeToKeyspaceEvents(ctx, VALKEYMODULE_NOTIFY_STRING, KeySpace_OpenKeyInsidePostNotificationJob) != VALKEYMODULE_OK){
+        return VALKEYMODULE_ERR;
+    }
+
     if(ValkeyModule_SubscribeToKeyspaceEvents(ctx, VALKEYMODULE_NOTIFY_EXPIRED, KeySpace_NotificationExpired) != VALKEYMODULE_OK){
         return VALKEYMODULE_ERR;
     }
@@ -351,6 +351,69 @@ test {Migrate the last slot away from a node using valkey-cli} {
     }
 }
 
+test {Rebalance with parallel migrations using valkey-cli} {
+    start_multiple_servers 4 [list overrides $base_conf] {
+        exec src/valkey-cli --cluster-yes --cluster create \
+                           127.0.0.1:[srv 0 port] \
+                           127.0.0.1:[srv -1 port]
+
+        wait_for_condition 1000 50 {
+            [CI 0 cluster_state] eq {ok} &&
+            [CI 1 cluster_state] eq {ok}
+        } else {
+            fail "Cluster doesn't stabilize"
+        }
+
+        set cluster [valkey_cluster 127.0.0.1:[srv 0 port]]
+        for {set j 0} {$j < 1000} {incr j} {
+            $cluster set key:$j $j
+        }
+
+        foreach id {-2 -3} {
+            exec src/valkey-cli --cluster-yes --cluster add-node \
+                         127.0.0.1:[srv $id port] \
+                         127.0.0.1:[srv 0 port]
+        }
+        wait_for_cluster_size 4
+
+        wait_for_condition 1000 50 {
+            [CI 0 cluster_state] eq {ok} &&
+            [CI 1 cluster_state] eq {ok} &&
+            [CI 2 cluster_state] eq {ok} &&
+            [CI 3 cluster_state] eq {ok}
+        } else {
+            fail "Cluster doesn't stabilize"
+        }
+
+        # Both primaries give slots to the empty ones at the same time.
+        set output [exec src/valkey-cli --cluster rebalance 127.0.0.1:[srv 0 port] \
+                        --cluster-use-empty-primaries --cluster-parallel 2]
+        assert_match "*with 2 parallel migrations*" $output
+        assert_match "*Moved 8192 slots and * keys in *" $output
+
+        wait_for_condition 1000 50 {
+            [catch {exec src/valkey-cli --cluster check 127.0.0.1:[srv 0 port]}] == 0 &&
+            [CI 0 cluster_state] eq {ok} &&
+            [CI 1 cluster_state] eq {ok} &&
+            [CI 2 cluster_state] eq {ok} &&
+            [CI 3 cluster_state] eq {ok}
+        } else {
+            fail "Cluster doesn't stabilize"
+        }
+
+        set keys 0
+        for {set id 0} {$id < 4} {incr id} {
+            assert_morethan [R $id dbsize] 0
+            incr keys [R $id dbsize]
+        }
+        assert_equal 1000 $keys
+        for {set j 0} {$j < 1000} {incr j} {
+            assert_equal $j [$cluster get key:$j]
+        }
+        $cluster close
+    }
+}
+
 foreach ip_or_localhost {127.0.0.1 localhost} {
 
 # Test valkey-cli --cluster create, add-node with cluster-port.
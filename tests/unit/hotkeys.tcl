@@ -0,0 +1,81 @@
+start_server {tags {"hotkeys"} overrides {hotkeys-sample-ratio 1}} {
+    test {HOTKEYS - reports the most accessed keys first} {
+        r hotkeys reset
+        r set warm v
+        r set hot v
+        for {set j 0} {$j < 10} {incr j} { r get hot }
+        for {set j 0} {$j < 5} {incr j} { r get warm }
+
+        set top [r hotkeys get count 2]
+        assert_equal 2 [llength $top]
+        set first [lindex $top 0]
+        assert_equal hot [dict get $first key]
+        assert_equal 9 [dict get $first db]
+        assert_equal 6093 [dict get $first slot]
+        assert_equal 11 [dict get $first accesses]
+        assert_equal 0 [dict get $first error]
+        assert_equal warm [dict get [lindex $top 1] key]
+        assert_equal 6 [dict get [lindex $top 1] accesses]
+    }
+
+    test {HOTKEYS - reports the keys with the largest replies by bytes} {
+        r hotkeys reset
+        r set small v
+        r set big [string repeat x 1000]
+        for {set j 0} {$j < 5} {incr j} { r get small }
+        r get big
+
+        set first [lindex [r hotkeys get count 1 by bytes] 0]
+        assert_equal big [dict get $first key]
+        # The +OK of the SET, and the bulk reply of the GET.
+        assert_equal 1014 [dict get $first bytes]
+        assert_equal small [dict get [lindex [r hotkeys get count 1 by accesses] 0] key]
+    }
+
+    test {HOTKEYS - filters by slot} {
+        r hotkeys reset
+        r get "{user}:1"
+        r get "{user}:2"
+        r get other
+        set slot 5474
+        set keys {}
+        foreach entry [r hotkeys get slot $slot] {
+            lappend keys [dict get $entry key]
+        }
+        assert_equal [lsort $keys] [list "{user}:1" "{user}:2"]
+    }
+
+    test {HOTKEYS - the least accessed key is replaced when the sketch is full} {
+        r hotkeys reset
+        for {set j 0} {$j < 10} {incr j} { r get hot }
+        for {set j 0} {$j < 200} {incr j} { r get key:$j }
+        set first [lindex [r hotkeys get count 1] 0]
+        assert_equal hot [dict get $first key]
+        assert_equal 10 [dict get $first accesses]
+        assert_equal 128 [llength [r hotkeys get count 1000]]
+        # A key that replaced another one inherits its count as error.
+        set second [lindex [r hotkeys get count 2] 1]
+        assert_equal 2 [dict get $second accesses]
+        assert_equal 1 [dict get $second error]
+    }
+
+    test {HOTKEYS - scales counts by the sample ratio and can be disabled} {
+        r config set hotkeys-sample-ratio 2
+        r hotkeys reset
+        for {set j 0} {$j < 10} {incr j} { r get hot }
+        assert_equal 10 [dict get [lindex [r hotkeys get count 1] 0] accesses]
+
+        r config set hotkeys-sample-ratio 0
+        r hotkeys reset
+        r get hot
+        assert_equal {} [r hotkeys get]
+        r config set hotkeys-sample-ratio 1
+    } {OK}
+
+    test {HOTKEYS - argument errors} {
+        assert_error {*syntax*} {r hotkeys get count}
+        assert_error {*BY should be*} {r hotkeys get by foo}
+        assert_error {*slot*} {r hotkeys get slot 16384}
+        assert_error {*count should be*} {r hotkeys get count -1}
+    }
+}
@@ -383,6 +383,71 @@ start_server {tags {"info" "external:skip" "debug_defrag:skip"}} {
             assert {$duration_max2 >= $duration_max1}
         }
 
+        test {stats: eventloop phase profiling} {
+            r config resetstat
+            # Profiling is disabled by default, so no phase is recorded.
+            assert_equal [getInfoProperty [r info eventloopstats] eventloop_phase_process_events] {}
+
+            r config set eventloop-profiling yes
+            r set foo bar
+            after 110 ;# hz is 10, wait for a cron tick.
+            r get foo
+            set info [r info eventloopstats]
+            assert_match {calls=*,usec=*,usec_per_call=*,max_usec=*,max_usec_time=*} \
+                [getInfoProperty $info eventloop_phase_process_events]
+            assert_match {calls=*} [getInfoProperty $info eventloop_phase_pending_writes]
+            assert_match {calls=*} [getInfoProperty $info eventloop_phase_server_cron]
+            assert_match {p50=*} [getInfoProperty $info latency_percentiles_usec_eventloop_phase_process_events]
+            # Not part of the default INFO sections.
+            assert_equal [getInfoProperty [r info] eventloop_phase_process_events] {}
+
+            r config set eventloop-profiling no
+            r config resetstat
+            assert_equal [getInfoProperty [r info eventloopstats] eventloop_phase_process_events] {}
+        }
+
+        test {stats: eventloop phase latency events} {
+            r config set eventloop-profiling yes
+            r config set latency-monitor-threshold 200
+            r latency reset
+            r debug sleep 0.3
+            # With IO threads the commands are executed while handling the completed reads.
+            assert {[regexp {eventloop-(process-events|io-reads-done)} [r latency latest]]}
+            r config set latency-monitor-threshold 0
+            r config set eventloop-profiling no
+            r latency reset
+        } {*} {needs:debug}
+
+        test {stats: command phase profiling} {
+            r config resetstat
+            r set foo bar
+            # Profiling is disabled by default.
+            assert_equal [getInfoProperty [r info commandphasestats] cmdphasestat_set] {}
+
+            r config set command-phase-sample-ratio 1
+            r set foo bar
+            r get foo
+            r client id
+            set info [r info commandphasestats]
+            assert_match {samples=1,parse_usec_per_call=*,lookup_usec_per_call=*,execute_usec_per_call=*,reply_usec_per_call=*,write_usec_per_call=*} \
+                [getInfoProperty $info cmdphasestat_set]
+            assert_match {samples=1,*} [getInfoProperty $info cmdphasestat_get]
+            assert_match {*cmdphasestat_client|id:samples=1,*} $info
+            # Not part of the default INFO sections.
+            assert_equal [getInfoProperty [r info] cmdphasestat_set] {}
+
+            # Nested commands are accounted to the caller.
+            r config resetstat
+            r eval {return server.call('get', KEYS[1])} 1 foo
+            set info [r info commandphasestats]
+            assert_match {samples=1,*} [getInfoProperty $info cmdphasestat_eval]
+            assert_equal [getInfoProperty $info cmdphasestat_get] {}
+
+            r config set command-phase-sample-ratio 0
+            r config resetstat
+            assert_equal [getInfoProperty [r info commandphasestats] cmdphasestat_eval] {}
+        }
+
         test {stats: client input and output buffer limit disconnections} {
             r config resetstat
             set info [r info stats]
@@ -675,6 +675,7 @@ start_server {tags {"introspection"}} {
             syslog-facility
             databases
             io-threads
+            tls-handshake-threads
             logfile
             unixsocketperm
             unixsocketgroup
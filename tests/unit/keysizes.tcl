@@ -0,0 +1,223 @@
+start_server {tags {"keysizes external:skip"}} {
+    proc wait_for_keysizes_pass {} {
+        set passes [dict get [r memory keysizes] passes]
+        wait_for_condition 50 100 {
+            [dict get [r memory keysizes] passes] > $passes + 1
+        } else {
+            fail "keyspace scan did not complete"
+        }
+        r memory keysizes
+    }
+
+    # The elements histograms computed from the keyspace, in the format of the
+    # MEMORY KEYSIZES reply.
+    proc keyspace_elements_histograms {} {
+        array set hist {}
+        foreach db {9 10} {
+            r select $db
+            foreach key [r keys *] {
+                set type [r type $key]
+                switch $type {
+                    string { set len [r strlen $key] }
+                    list { set len [r llen $key] }
+                    set { set len [r scard $key] }
+                    zset { set len [r zcard $key] }
+                    hash { set len [r hlen $key] }
+                    stream { set len [r xlen $key] }
+                }
+                set bucket 0
+                if {$len > 0} {
+                    set bucket 1
+                    while {$bucket * 2 <= $len} { set bucket [expr {$bucket * 2}] }
+                }
+                if {![info exists hist($type,$bucket)]} { set hist($type,$bucket) 0 }
+                incr hist($type,$bucket)
+            }
+        }
+        r select 9
+        set result {}
+        foreach type {string list set zset hash stream} {
+            set buckets {}
+            foreach name [array names hist $type,*] {
+                lappend buckets [list [lindex [split $name ,] 1] $hist($name)]
+            }
+            if {[llength $buckets]} {
+                dict set result $type [lsort -integer -index 0 $buckets]
+            }
+        }
+        return $result
+    }
+
+    proc reported_elements_histograms {} {
+        set result {}
+        dict for {type hist} [dict get [r memory keysizes] types] {
+            if {[llength [dict get $hist elements]]} {
+                dict set result $type [dict get $hist elements]
+            }
+        }
+        return $result
+    }
+
+    proc assert_elements_histograms {} {
+        assert_equal [keyspace_elements_histograms] [reported_elements_histograms]
+    }
+
+    test {MEMORY KEYSIZES - the scan is disabled by default} {
+        r set foo bar
+        after 200
+        set ks [r memory keysizes]
+        assert_equal 0 [dict get $ks passes]
+        assert_equal {} [dict get $ks biggest-keys]
+        # The elements histograms don't depend on the scan.
+        assert_equal {{2 1}} [dict get [dict get $ks types string] elements]
+        assert_equal {} [dict get [dict get $ks types string] bytes]
+    }
+
+    test {MEMORY KEYSIZES - elements histograms follow the commands} {
+        r flushall
+        r rpush l1 {*}[lrepeat 10 a]
+        r lpush l2 a b c
+        r linsert l2 before b x
+        r lpop l1 3
+        r rpop l2
+        r ltrim l1 0 4
+        r lrem l1 2 a
+        r lmove l2 l3 left right
+        r lmove l1 l1 left right
+        r lmpop 1 l2 left count 10
+        assert_elements_histograms
+
+        r sadd s1 {*}[lrepeat 20 a] b c d e f g h i j
+        r sadd s2 1 2 3 4 5 6 7 8 9 10
+        r srem s1 a b c
+        r smove s2 s1 1
+        r spop s2
+        r spop s2 2
+        r spop s1 5
+        r sadd s3 x
+        r srem s3 x
+        assert_elements_histograms
+
+        r zadd z1 1 a 2 b 3 c 4 d 5 e
+        r zadd z2 1 a
+        r zincrby z2 1 b
+        r zrem z1 a b
+        r zremrangebyrank z1 0 0
+        r zpopmin z2
+        r zmpop 1 z1 max count 1
+        r zrem z2 b
+        assert_elements_histograms
+
+        r hset h1 a 1 b 2 c 3 d 4
+        r hsetnx h1 e 5
+        r hincrby h1 f 1
+        r hincrbyfloat h1 g 1.5
+        r hdel h1 a b
+        r hset h2 a 1
+        r hdel h2 a
+        assert_elements_histograms
+
+        r xadd x1 * a 1
+        r xadd x1 * a 2
+        r xadd x1 * a 3
+        set id [r xadd x1 maxlen 2 * a 4]
+        r xdel x1 $id
+        r xadd x2 * a 1
+        r xtrim x2 maxlen 0
+        assert_elements_histograms
+
+        r set str1 abc
+        r append str1 defgh
+        r setrange str1 20 x
+        r set str2 1
+        r incrby str2 1000
+        r setbit str3 100 1
+        r pfadd hll a b c
+        r pfadd hll d e f
+        r pfmerge hll2 hll
+        r getdel str2
+        assert_elements_histograms
+
+        r select 10
+        r rpush l4 a b
+        r set str4 xyz
+        r select 9
+        r expire str1 100
+        r set str1 replaced
+        r set l1 now-a-string
+        r copy s1 s1copy
+        r rename h1 h1renamed
+        r del x1
+        r pexpire s1copy 1
+        after 10
+        r exists s1copy
+        assert_elements_histograms
+
+        r swapdb 9 10
+        assert_elements_histograms
+        r swapdb 9 10
+
+        r debug reload
+        assert_elements_histograms
+
+        r flushdb
+        assert_elements_histograms
+        r flushall
+        assert_equal {} [reported_elements_histograms]
+    } {} {needs:debug}
+
+    test {MEMORY KEYSIZES - histograms per type} {
+        r flushall
+        r config set keysizes-scan-cpu-percent 10
+        r set s1 ""
+        r set s2 [string repeat x 5]
+        r set s3 [string repeat x 6]
+        r rpush list {*}[lrepeat 100 a]
+        r hset hash f1 v1 f2 v2
+        r select 10
+        r sadd set a b c
+        r select 9
+
+        set ks [wait_for_keysizes_pass]
+        set types [dict get $ks types]
+        assert_equal [lsort [dict keys $types]] {hash list set string}
+        set strings [dict get $types string]
+        assert_equal 3 [dict get $strings keys]
+        # One empty string, and two strings in the [4, 8) bucket.
+        assert_equal {{0 1} {4 2}} [dict get $strings elements]
+        assert_equal {{64 1}} [dict get [dict get $types list] elements]
+        assert_equal {{2 1}} [dict get [dict get $types hash] elements]
+        assert_equal {{2 1}} [dict get [dict get $types set] elements]
+        set bytes 0
+        foreach bucket [dict get $strings bytes] { incr bytes [lindex $bucket 1] }
+        assert_equal 3 $bytes
+    }
+
+    test {MEMORY KEYSIZES - biggest keys} {
+        r flushall
+        for {set j 0} {$j < 50} {incr j} { r set key:$j [string repeat x $j] }
+        r select 10
+        r set big [string repeat x 10000]
+        r select 9
+
+        set ks [wait_for_keysizes_pass]
+        set biggest [dict get $ks biggest-keys]
+        assert_equal 32 [llength $biggest]
+        set first [lindex $biggest 0]
+        assert_equal big [dict get $first key]
+        assert_equal 10 [dict get $first db]
+        assert_equal string [dict get $first type]
+        assert_equal 10000 [dict get $first elements]
+        # Several keys share the allocation size of the largest string.
+        assert_equal [r memory usage key:49] [dict get [lindex $biggest 1] bytes]
+    }
+
+    test {MEMORY KEYSIZES - results reflect the keyspace of the last pass} {
+        r flushall
+        set ks [wait_for_keysizes_pass]
+        assert_equal {} [dict get $ks types]
+        assert_equal {} [dict get $ks biggest-keys]
+        assert_morethan [dict get $ks last-pass-end-time] 0
+        r config set keysizes-scan-cpu-percent 0
+    } {OK}
+}
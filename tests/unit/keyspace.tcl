@@ -42,6 +42,14 @@ start_server {tags {"keyspace"}} {
         assert_equal [lsort [r keys "*{b}*"]] [list "{b}a" "{b}b" "{b}c"]
     } 
 
+    test {KEYS with literal pattern} {
+        r set "{a}*" hello
+        assert_equal [r keys "{a}x"] [list "{a}x"]
+        assert_equal [r keys "{a}w"] {}
+        assert_equal [r keys "{a}\\*"] [list "{a}*"]
+        r del "{a}*"
+    }
+
     test {DEL all keys} {
         foreach key [r keys *] {r del $key}
         r dbsize
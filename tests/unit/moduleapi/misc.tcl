@@ -545,6 +545,28 @@ start_server {tags {"modules"}} {
         assert_equal {0} [r test.get_n_events]
     }
 
+    test {test RM_OpenKeys} {
+        r flushall
+        r set a foo
+        r rpush b 1 2 3
+        r hset c f1 v1 f2 v2
+        set prev_batches [s io_threaded_total_prefetch_batches]
+        assert_equal {4 3 3 {} 3 2} [r test.open_keys a b missing b c]
+        assert_equal {0 {}} [r test.open_keys missing]
+        assert_equal {1 3} [r test.open_keys a]
+
+        # More keys than prefetched at once
+        set keys {}
+        for {set j 0} {$j < 40} {incr j} {
+            r set key:$j $j
+            lappend keys key:$j
+        }
+        assert_equal 40 [lindex [r test.open_keys {*}$keys] 0]
+
+        # The module prefetches aren't reported as IO threads batches
+        assert_equal $prev_batches [s io_threaded_total_prefetch_batches]
+    }
+
 if {[string match {*jemalloc*} [s mem_allocator]]} {
     test {test RM_Call with large arg for SET command} {
         # set a big value to trigger increasing the query buf
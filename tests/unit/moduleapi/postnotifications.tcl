@@ -148,6 +148,25 @@ tags "modules" {
             close_replication_stream $repl
         }
 
+        test {Test hot keys looked up by post notification jobs} {
+            r flushall
+            r config set hotkeys-sample-ratio 1
+            r set foo bar
+            r hotkeys reset
+            r set open_foo 1
+            r ping
+
+            # The job that opened 'foo' has no reply, the next command's reply
+            # must not be attributed to it.
+            set accessed {}
+            foreach entry [r hotkeys get] { lappend accessed [dict get $entry key] }
+            assert_equal {foo open_foo} [lsort $accessed]
+            set charged {}
+            foreach entry [r hotkeys get by bytes] { lappend charged [dict get $entry key] }
+            assert_equal {open_foo} $charged
+            r config set hotkeys-sample-ratio 100
+        }
+
         test {Test eviction} {
             r flushall
             set repl [attach_to_replication_stream]
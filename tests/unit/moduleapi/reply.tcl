@@ -150,3 +150,22 @@ start_server {tags {"modules"}} {
         assert_equal {OK} [r module unload replywith]
     }
 }
+
+start_server {tags {"modules"}} {
+    r module load $testmodule
+
+    test "Unload the module while the reply of a sampled command is pending" {
+        r config set command-phase-sample-ratio 1
+        set rd [valkey_deferring_client]
+        $rd rw.string [string repeat x 20000000]
+        wait_for_condition 50 100 {
+            [s total_net_output_bytes] > 0 && [s mem_clients_normal] > 10000000
+        } else {
+            fail "reply was not queued"
+        }
+        assert_equal {OK} [r module unload replywith]
+        assert_equal 20000000 [string length [$rd read]]
+        assert_equal {PONG} [r ping]
+        $rd close
+    }
+}
@@ -159,6 +159,89 @@ start_server {tags {"pubsub network"}} {
         $rd2 close
     }
 
+    test "PUBLISH/PSUBSCRIBE with patterns sharing a literal prefix" {
+        set rd1 [valkey_deferring_client]
+        assert_equal {1 2 3 4 5} [psubscribe $rd1 {news.* news.sport news.s?ort news news[.]*}]
+        assert_equal 4 [r publish news.sport hello]
+        assert_equal 1 [r publish news hello]
+        assert_equal 0 [r publish new hello]
+        assert_equal 2 [r publish news.sp0rt hello]
+        set patterns {}
+        for {set i 0} {$i < 7} {incr i} {
+            lappend patterns [lindex [$rd1 read] 1]
+        }
+        assert_equal [lsort {news.* news.* news.sport news.s?ort news news[.]* news[.]*}] [lsort $patterns]
+
+        # unsubscribe from the literal pattern only
+        assert_equal {4} [punsubscribe $rd1 {news.sport}]
+        assert_equal 3 [r publish news.sport hello]
+        assert_equal 4 [r pubsub numpat]
+
+        # clean up clients
+        $rd1 close
+        wait_for_condition 50 100 {
+            [r pubsub numpat] eq 0
+        } else {
+            fail "patterns were not released"
+        }
+    }
+
+    test "PUBLISH large messages shared by RESP2 and RESP3 subscribers" {
+        set rd1 [valkey_deferring_client]
+        set rd2 [valkey_deferring_client]
+        set rd3 [valkey_deferring_client]
+        set rd4 [valkey_deferring_client]
+        foreach rd [list $rd2 $rd4] {
+            $rd hello 3
+            $rd read
+        }
+        assert_equal {1} [subscribe $rd1 {chan1}]
+        assert_equal {1} [subscribe $rd2 {chan1}]
+        assert_equal {1} [psubscribe $rd3 {chan*}]
+        assert_equal {1} [psubscribe $rd4 {chan*}]
+
+        set big1 [string repeat a 20000]
+        set big2 [string repeat b 100000]
+        assert_equal 4 [r publish chan1 $big1]
+        assert_equal 4 [r publish chan1 $big2]
+        assert_equal 2 [r publish chan2 small]
+        foreach rd [list $rd1 $rd2] {
+            assert_equal [list message chan1 $big1] [$rd read]
+            assert_equal [list message chan1 $big2] [$rd read]
+        }
+        foreach rd [list $rd3 $rd4] {
+            assert_equal [list pmessage chan* chan1 $big1] [$rd read]
+            assert_equal [list pmessage chan* chan1 $big2] [$rd read]
+            assert_equal {pmessage chan* chan2 small} [$rd read]
+        }
+
+        # clean up clients
+        $rd1 close
+        $rd2 close
+        $rd3 close
+        $rd4 close
+    }
+
+    test "PUBLISH large messages from a script" {
+        set rd1 [valkey_deferring_client]
+        set rd2 [valkey_deferring_client]
+        assert_equal {1} [subscribe $rd1 {chan1}]
+        assert_equal {1} [subscribe $rd2 {chan1}]
+
+        set big [string repeat c 20000]
+        r set bigkey $big
+        set res [r eval {
+            local n = server.call('publish', 'chan1', ARGV[1])
+            return {n, server.call('get', KEYS[1])}
+        } 1 bigkey $big]
+        assert_equal [list 2 $big] $res
+        foreach rd [list $rd1 $rd2] {
+            assert_equal [list message chan1 $big] [$rd read]
+            $rd close
+        }
+        r del bigkey
+    }
+
     test "PUBLISH/PSUBSCRIBE after PUNSUBSCRIBE without arguments" {
         set rd1 [valkey_deferring_client]
         assert_equal {1 2 3} [psubscribe $rd1 {chan1.* chan2.* chan3.*}]
@@ -526,3 +609,96 @@ start_server {tags {"pubsub network"}} {
     } {} {resp3}
 
 }
+
+start_server {tags {"pubsub network external:skip"} overrides {io-threads 4 events-per-io-thread 0}} {
+    test "PUBLISH fan-out to many subscribers keeps the messages order" {
+        set clients {}
+        for {set i 0} {$i < 150} {incr i} {
+            set rd [valkey_deferring_client]
+            assert_equal {1} [subscribe $rd {fanout}]
+            lappend clients $rd
+        }
+        set before [s io_threaded_pubsub_messages]
+        for {set j 0} {$j < 5} {incr j} {
+            assert_equal 150 [r publish fanout msg$j]
+        }
+        foreach rd $clients {
+            for {set j 0} {$j < 5} {incr j} {
+                assert_equal [list message fanout msg$j] [$rd read]
+            }
+            $rd close
+        }
+        # The messages were appended to the output buffers by the I/O threads.
+        assert_morethan [s io_threaded_pubsub_messages] $before
+    }
+
+    test "PUBLISH fan-out with I/O threads to RESP3 and pattern subscribers" {
+        set clients {}
+        for {set i 0} {$i < 40} {incr i} {
+            set rd [valkey_deferring_client]
+            if {$i % 2} {
+                $rd hello 3
+                $rd read
+            }
+            assert_equal {1} [psubscribe $rd {fan*}]
+            lappend clients $rd
+        }
+        set big [string repeat x 10000]
+        assert_equal 40 [r publish fanout small]
+        assert_equal 40 [r publish fanout $big]
+        foreach rd $clients {
+            assert_equal {pmessage fan* fanout small} [$rd read]
+            assert_equal [list pmessage fan* fanout $big] [$rd read]
+            $rd close
+        }
+    }
+
+    test "PUBLISH fan-out with I/O threads keeps the messages before later replies" {
+        set clients {}
+        for {set i 0} {$i < 40} {incr i} {
+            set rd [valkey_deferring_client]
+            $rd hello 3
+            $rd read
+            assert_equal {1} [subscribe $rd {fanout}]
+            lappend clients $rd
+        }
+        for {set j 0} {$j < 5} {incr j} {
+            assert_equal 40 [r publish fanout msg$j]
+            foreach rd $clients {
+                $rd ping
+            }
+            foreach rd $clients {
+                assert_equal [list message fanout msg$j] [$rd read]
+                assert_equal {PONG} [$rd read]
+            }
+        }
+        foreach rd $clients {
+            $rd close
+        }
+    }
+
+    test "PUBLISH fan-out with I/O threads counts queued messages in the output buffer limits" {
+        r config set client-output-buffer-limit "pubsub 100k 0 0"
+        set clients {}
+        for {set i 0} {$i < 10} {incr i} {
+            set rd [valkey_deferring_client]
+            assert_equal {1} [subscribe $rd {fanout}]
+            lappend clients $rd
+        }
+        set before [s client_output_buffer_limit_disconnections]
+        set payload [string repeat x 10000]
+        # The messages are queued during EXEC and only handed to the I/O
+        # threads after it, the subscribers are disconnected before that.
+        r multi
+        for {set j 0} {$j < 50} {incr j} {
+            r publish fanout $payload
+        }
+        assert_equal [lrepeat 50 10] [r exec]
+        assert_equal [expr {$before + 10}] [s client_output_buffer_limit_disconnections]
+        foreach rd $clients {
+            assert_error "*I/O error*" {$rd read}
+            $rd close
+        }
+        r config set client-output-buffer-limit "pubsub 32mb 8mb 60"
+    }
+}
@@ -459,6 +459,37 @@ proc test_scan {type} {
         set keys [lsort -unique $keys]
         assert_equal 100 [llength $keys]
     }
+
+    test "{$type} SCAN MATCH pattern with escaped hash tag" {
+        r flushdb
+        for {set j 0} {$j < 100} {incr j} {
+            r set "{f*o}-$j" "foo"
+            r set "{bar}-$j" "bar"
+        }
+
+        set cursor 0
+        set keys {}
+        while 1 {
+            set res [r scan $cursor match "{f\\*o}-*"]
+            set cursor [lindex $res 0]
+            set k [lindex $res 1]
+            lappend keys {*}$k
+            if {$cursor == 0} break
+        }
+
+        set keys [lsort -unique $keys]
+        assert_equal 100 [llength $keys]
+    }
+
+    test "{$type} SCAN MATCH literal pattern" {
+        r flushdb
+        populate 100
+
+        assert_equal {0 key:42} [r scan 0 match key:42]
+        assert_equal {0 key:42} [r scan 0 match key:42 type string]
+        assert_equal {0 {}} [r scan 0 match key:42 type list]
+        assert_equal {0 {}} [r scan 0 match key:1000]
+    }
 }
 
 start_server {tags {"scan network standalone"}} {
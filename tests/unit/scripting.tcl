@@ -975,6 +975,20 @@ start_server {tags {"scripting"}} {
         assert_equal $res $expected_list
     } {} {resp3}
 
+    test {Script scalar replies are converted to the right Lua types} {
+        r set intkey 12345
+        r set strkey value
+        r del nokey
+        set script {
+            local get = redis.call('get', KEYS[1])
+            return {type(get), get, redis.call('get', KEYS[2]), redis.call('incr', KEYS[1]),
+                    type(redis.call('get', KEYS[3])), redis.call('exists', KEYS[3])}
+        }
+        assert_equal {string 12345 value 12346 boolean 0} [run_script $script 3 intkey strkey nokey]
+        set script {redis.setresp(3); return type(redis.call('get', KEYS[1]))}
+        assert_equal {nil} [run_script $script 1 nokey]
+    }
+
     if {!$::log_req_res} { # this test creates a huge nested array which python can't handle (RecursionError: maximum recursion depth exceeded in comparison)
     test {Script return recursive object} {
         r readraw 1
@@ -1171,6 +1185,97 @@ start_server {tags {"scripting"}} {
         $rd close
     }
 
+    test {Timedout read-only scripts allow read commands with busy-script-allow-reads} {
+        r set foo bar
+        r config set busy-script-allow-reads yes
+        set rd [valkey_deferring_client]
+        r config set lua-time-limit 10
+        if {$is_eval eq 1} {
+            $rd eval_ro {while true do end} 1 foo
+        } else {
+            r function load replace [format "#!lua name=test\n%s.register_function{function_name='test', callback=function(KEYS, ARGV) while true do end end, flags={'no-writes'}}" [get_script_api_name]]
+            $rd fcall_ro test 1 foo
+        }
+        wait_for_condition 50 100 {
+            [catch {r ping} e] == 1
+        } else {
+            fail "Can't wait for script to start running"
+        }
+        assert_equal bar [r get foo]
+        assert_equal 1 [r exists foo]
+        catch {r set foo baz} e
+        assert_match {BUSY*} $e
+        catch {r eval_ro {return 1} 0} e
+        assert_match {BUSY*} $e
+
+        kill_script
+        wait_for_condition 50 100 {
+            [catch {r ping} e] == 0
+        } else {
+            fail "Can't wait for script to be killed"
+        }
+        catch {$rd read} res
+        $rd close
+        assert_match {*killed by user*} $res
+        assert_equal bar [r get foo]
+        r config set busy-script-allow-reads no
+    }
+
+    test {Read commands served during a busy read-only script don't delete expired keys} {
+        r flushall
+        r debug set-active-expire 0
+        r set foo bar
+        r set ttlkey val px 200
+        r config set busy-script-allow-reads yes
+        if {$is_eval eq 0} {
+            r function load replace [format "#!lua name=test\n%s.register_function{function_name='test', callback=function(KEYS, ARGV) while true do end end, flags={'no-writes'}}" [get_script_api_name]]
+        }
+        set repl [attach_to_replication_stream]
+        set rd [valkey_deferring_client]
+        r config set lua-time-limit 10
+        if {$is_eval eq 1} {
+            $rd eval_ro {while true do end} 1 foo
+        } else {
+            $rd fcall_ro test 1 foo
+        }
+        wait_for_condition 50 100 {
+            [catch {r ping} e] == 1
+        } else {
+            fail "Can't wait for script to start running"
+        }
+
+        # Each read gets its own time snapshot, so the key expires while the
+        # script runs, but it is only deleted after the script.
+        wait_for_condition 50 100 {
+            [r get ttlkey] eq {}
+        } else {
+            fail "Key didn't expire while the script was running"
+        }
+        assert_equal 0 [r exists ttlkey]
+        assert_equal 2 [r dbsize]
+
+        kill_script
+        wait_for_condition 50 100 {
+            [catch {r ping} e] == 0
+        } else {
+            fail "Can't wait for script to be killed"
+        }
+        catch {$rd read} res
+        $rd close
+        assert_match {*killed by user*} $res
+        assert_equal {} [r get ttlkey]
+        assert_equal 1 [r dbsize]
+        r set trailingkey 1
+        assert_replication_stream $repl {
+            {select *}
+            {unlink ttlkey}
+            {set trailingkey 1}
+        }
+        close_replication_stream $repl
+        r config set busy-script-allow-reads no
+        r debug set-active-expire 1
+    } {OK} {external:skip needs:debug needs:repl}
+
     test {Timedout read-only scripts can be killed by SCRIPT KILL even when use pcall} {
         set rd [valkey_deferring_client]
         r config set lua-time-limit 10
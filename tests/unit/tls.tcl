@@ -94,6 +94,45 @@ start_server {tags {"tls"}} {
             r CONFIG SET tls-ciphers "DEFAULT"
         }
 
+        test {TLS: Verify tls-ktls behaves as expected} {
+            set before [s tls_ktls_send_connections]
+            set s [valkey [srv 0 host] [srv 0 port] 0 1]
+            assert_match {PONG} [$s PING]
+            $s close
+            assert_equal $before [s tls_ktls_send_connections]
+
+            r CONFIG SET tls-ktls yes
+
+            # Replies are sent with kTLS when the kernel supports it, otherwise
+            # the connection falls back to the user space encryption.
+            set s [valkey [srv 0 host] [srv 0 port] 0 1]
+            assert_match {PONG} [$s PING]
+            set big [string repeat x 100000]
+            $s SET big $big
+            set keys {}
+            set values {}
+            for {set j 0} {$j < 100} {incr j} {
+                $s SET key:$j $j
+                lappend keys key:$j
+                lappend values $j
+            }
+            # Large replies span several reply buffers, written with writev
+            assert_equal $big [$s GET big]
+            assert_equal $values [$s MGET {*}$keys]
+            $s close
+
+            # The kernel needs the "tls" ULP for kTLS, the server also needs an
+            # OpenSSL built with kTLS support.
+            set ulp {}
+            catch {set ulp [exec cat /proc/sys/net/ipv4/tcp_available_ulp]}
+            if {[lsearch -exact $ulp tls] >= 0} {
+                assert_morethan [s tls_ktls_send_connections] $before
+            }
+
+            r CONFIG SET tls-ktls no
+            r DEL big
+        }
+
         test {TLS: Verify tls-cert-file is also used as a client cert if none specified} {
             set master [srv 0 client]
             set master_host [srv 0 host]
@@ -156,3 +195,25 @@ start_server {tags {"tls"}} {
         }
     }
 }
+
+foreach io_threads {1 2} {
+    start_server [list tags {"tls"} overrides [list io-threads $io_threads events-per-io-thread 0 tls-handshake-threads 2]] {
+        if {$::tls} {
+            test "TLS: Handshakes are done by the TLS handshake threads with io-threads $io_threads" {
+                set before [s tls_handshake_jobs_processed]
+                set clients {}
+                for {set j 0} {$j < 10} {incr j} {
+                    set s [valkey [srv 0 host] [srv 0 port] 0 1]
+                    assert_match {PONG} [$s PING]
+                    lappend clients $s
+                }
+                foreach s $clients {
+                    assert_equal OK [$s SET foo bar]
+                    $s close
+                }
+                assert_morethan_equal [s tls_handshake_jobs_processed] [expr {$before + 10}]
+                assert_equal 0 [s tls_handshake_queue_depth]
+            }
+        }
+    }
+}
@@ -73,6 +73,7 @@ start_server {tags {"tracking network logreqres:skip"}} {
     test {Clients can enable the BCAST mode with prefixes} {
         r CLIENT TRACKING off
         r CLIENT TRACKING on BCAST REDIRECT $redir_id PREFIX a: PREFIX b:
+        set batched [s tracking_invalidations_batched]
         r MULTI
         r INCR a:1{t}
         r INCR a:2{t}
@@ -81,12 +82,11 @@ start_server {tags {"tracking network logreqres:skip"}} {
         # we should not get this key
         r INCR c:1{t}
         r EXEC
-        # Because of the internals, we know we are going to receive
-        # two separated notifications for the two different prefixes.
-        set keys1 [lsort [lindex [$rd_redirection read] 2]]
-        set keys2 [lsort [lindex [$rd_redirection read] 2]]
-        set keys [lsort [list {*}$keys1 {*}$keys2]]
+        # The keys of the two different prefixes are batched in a
+        # single notification.
+        set keys [lsort [lindex [$rd_redirection read] 2]]
         assert {$keys eq {a:1{t} a:2{t} b:1{t} b:2{t}}}
+        assert_equal [expr {$batched + 1}] [s tracking_invalidations_batched]
     }
 
     test {Adding prefixes to BCAST mode works} {
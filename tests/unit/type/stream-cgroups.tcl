@@ -861,6 +861,77 @@ start_server {
         assert_error {ERR COUNT*} {r XAUTOCLAIM x grp Bob 0 3-0 COUNT 8070450532247928833}
     }
 
+    test {XPENDING and XAUTOCLAIM with IDLE find old entries among many recent ones} {
+        r DEL x
+        for {set j 1} {$j <= 2000} {incr j} {
+            r XADD x $j-0 f v
+        }
+        r XGROUP CREATE x grp 0
+        r XREADGROUP GROUP grp Alice COUNT 2000 STREAMS x >
+
+        # Move the delivery time of a few entries far in the past, in an
+        # order different from the one of their IDs.
+        set old [expr {[clock milliseconds] - 100000}]
+        r XCLAIM x grp Alice 0 70-0 TIME [expr {$old - 2}] JUSTID
+        r XCLAIM x grp Bob 0 10-0 TIME $old JUSTID
+        r XCLAIM x grp Alice 0 40-0 TIME [expr {$old - 1}] JUSTID
+
+        set pending [r XPENDING x grp IDLE 50000 - + 10]
+        assert_equal [lmap e $pending {lindex $e 0}] {10-0 40-0 70-0}
+        set pending [r XPENDING x grp IDLE 50000 - + 10 Alice]
+        assert_equal [lmap e $pending {lindex $e 0}] {40-0 70-0}
+        set pending [r XPENDING x grp IDLE 50000 (10-0 69-0 10]
+        assert_equal [lmap e $pending {lindex $e 0}] {40-0}
+        set pending [r XPENDING x grp IDLE 50000 - + 1]
+        assert_equal [lmap e $pending {lindex $e 0}] {10-0}
+
+        # The index survives a reload, and follows the claimed, acknowledged
+        # and deleted entries.
+        r DEBUG RELOAD
+        set pending [r XPENDING x grp IDLE 50000 - + 10]
+        assert_equal [lmap e $pending {lindex $e 0}] {10-0 40-0 70-0}
+        r XCLAIM x grp Bob 0 40-0 JUSTID
+        r XACK x grp 70-0
+        set pending [r XPENDING x grp IDLE 50000 - + 10]
+        assert_equal [lmap e $pending {lindex $e 0}] {10-0}
+
+        # XAUTOCLAIM reports deleted entries whether they are idle or not.
+        r XDEL x 5-0
+        assert_equal [r XAUTOCLAIM x grp Bob 50000 0-0 COUNT 2 JUSTID] {11-0 10-0 5-0}
+        assert_equal [r XPENDING x grp IDLE 50000 - + 10] {}
+        assert_equal [llength [r XPENDING x grp - + 2000]] 1998
+    } {} {needs:debug}
+
+    test {The PEL delivery time index is only kept for idle queries on large PELs} {
+        r DEL x y
+        foreach key {x y} {
+            for {set j 1} {$j <= 2000} {incr j} {
+                r XADD $key $j-0 f v
+            }
+            r XGROUP CREATE $key grp 0
+            r XREADGROUP GROUP grp Alice COUNT 2000 STREAMS $key >
+        }
+
+        # Without idle queries the PEL costs what it costs without the index.
+        r XPENDING x grp - + 10
+        r XPENDING x grp
+        assert_equal [r MEMORY USAGE x SAMPLES 0] [r MEMORY USAGE y SAMPLES 0]
+
+        r XPENDING x grp IDLE 1 - + 10
+        assert_morethan [r MEMORY USAGE x SAMPLES 0] [r MEMORY USAGE y SAMPLES 0]
+
+        # The index is dropped once the PEL got small.
+        set ids {}
+        for {set j 1} {$j <= 1900} {incr j} {
+            lappend ids $j-0
+        }
+        r XACK x grp {*}$ids
+        r XACK y grp {*}$ids
+        assert_equal [r MEMORY USAGE x SAMPLES 0] [r MEMORY USAGE y SAMPLES 0]
+        assert_equal [llength [r XPENDING x grp IDLE 1 - + 200]] 100
+        assert_equal [r MEMORY USAGE x SAMPLES 0] [r MEMORY USAGE y SAMPLES 0]
+    }
+
     test {XCLAIM with trimming} {
         r DEL x
         r config set stream-node-max-entries 2